@@ -0,0 +1,70 @@
+#ifndef BACKENDDICTIONARY_H
+#define BACKENDDICTIONARY_H
+
+/**
+ * @file BackendDictionary.h
+ * @brief BackendDictionary interface.
+ *        Thread safe interning of backend URLs into 32 bit ids, so every key stores an id
+ *        instead of its own copy of the URL. Ids are dense, start at 0 and are never
+ *        released, so one dictionary can be shared by several map managers (e.g. shards).
+ *        Looking up the URL of an id is lock free.
+ * @author Guillermo M. Paris
+ * @date 2026-10-18
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <iosfwd>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#define BACKEND_CHUNK_BITS  10 // 1024 ids per chunk
+#define BACKEND_MAX_CHUNKS  1024
+
+class BackendDictionary
+{
+public:
+    static constexpr uint32_t ms_ChunkBits = BACKEND_CHUNK_BITS;
+    static constexpr uint32_t ms_ChunkSize = 1U << BACKEND_CHUNK_BITS;
+    static constexpr uint32_t ms_MaxChunks = BACKEND_MAX_CHUNKS;
+    static constexpr const char* ms_Header = "#backends";
+    static constexpr char        ms_Reference = '#'; // "#id": a url by its id in a written dictionary
+
+    BackendDictionary();
+    ~BackendDictionary();
+
+    BackendDictionary(const BackendDictionary&) = delete;
+    BackendDictionary& operator = (const BackendDictionary&) = delete;
+
+    // Id of url, added if it is new. Throws std::length_error beyond ms_ChunkSize * ms_MaxChunks.
+    uint32_t           intern(std::string_view url);
+    // id must come from intern().
+    const std::string& getUrl(uint32_t id) const
+    { return *m_chunks[id >> ms_ChunkBits].load(std::memory_order_acquire)[id & (ms_ChunkSize - 1)]; }
+
+    uint32_t           size() const { return m_size.load(std::memory_order_acquire); }
+    std::size_t        memoryUsage() const;
+
+    // Writes "#backends,<n>" and then n lines "<id>,<url>". Returns n: the ids known by the file.
+    uint32_t           write(std::ostream& out) const;
+    // Reads what write() wrote, interning every url: ids[file id] = id in this dictionary.
+    bool               read(std::istream& in, std::vector<uint32_t>& ids);
+    // True if the stream is positioned at a header written by write(): "#backends," in full.
+    // The stream position is left where it was.
+    static bool        hasHeader(std::istream& in);
+    // True if field is a "#id" reference, fileId gets id. Anything else is a url.
+    static bool        parseReference(const std::string& field, unsigned long& fileId);
+
+private:
+    static const char  ms_FieldSeparator = ',';
+
+    mutable std::shared_mutex                     m_mutex;
+    std::unordered_map<std::string, uint32_t>     m_ids;
+    std::atomic<const std::string**>              m_chunks[BACKEND_MAX_CHUNKS];
+    std::atomic<uint32_t>                         m_size;
+};
+
+#endif // BACKENDDICTIONARY_H
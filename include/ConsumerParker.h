@@ -0,0 +1,90 @@
+#ifndef CONSUMERPARKER_H
+#define CONSUMERPARKER_H
+
+/**
+ * @file ConsumerParker.h
+ * @brief ConsumerParker interface.
+ *        How a queue output thread waits for messages: it spins for a while (adaptive, bounded),
+ *        then parks on a futex. Producers only make the wake up system call when it is parked.
+ * @author Guillermo M. Paris
+ * @date 2026-10-18
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+#define MAX_SPIN_MICROSECONDS 50 // longest spin on an empty queue before parking
+
+class ConsumerParker
+{
+public:
+    static const int maxSpinMicroseconds; // = MAX_SPIN_MICROSECONDS
+
+    ConsumerParker() : m_spinMicroseconds(maxSpinMicroseconds), m_parked(false), m_wakeups(0) {}
+
+    // Output thread: returns when ready() is true, or after a wakeUp(), or once parked for
+    // timeout (0: no timeout). ready() must also be true once the queue is being stopped.
+    template<class Ready>
+    void wait(Ready&& ready, std::chrono::milliseconds timeout = std::chrono::milliseconds(0))
+    {
+        if (spin(ready))
+            return;
+
+        // Park. The flag is raised before the last check, and notify() checks the flag after
+        // the message is published: either this thread sees the message or the producer sees
+        // the flag.
+        const uint32_t wakeups = m_wakeups.load(std::memory_order_relaxed);
+        m_parked.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+
+        const std::chrono::steady_clock::time_point parkedAt = std::chrono::steady_clock::now();
+        if (! ready())
+            sleep(wakeups, timeout);
+
+        m_parked.store(false, std::memory_order_relaxed);
+        adapt(parkedAt);
+    }
+
+    // Producer side, once the message is published. Only one producer makes the system call.
+    void notify()
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (m_parked.load(std::memory_order_relaxed) && m_parked.exchange(false, std::memory_order_relaxed))
+            wakeUp();
+    }
+
+    void wakeUp();
+
+private:
+    // Bounded spin: right after some traffic the next message usually comes soon.
+    template<class Ready>
+    bool spin(Ready& ready)
+    {
+        if (m_spinMicroseconds <= 0)
+            return false;
+
+        const std::chrono::steady_clock::time_point deadline =
+            std::chrono::steady_clock::now() + std::chrono::microseconds(m_spinMicroseconds);
+        do
+        {
+            relax();
+            if (ready())
+                return true;
+        }
+        while (std::chrono::steady_clock::now() < deadline);
+
+        return false;
+    }
+
+    static void relax();
+    void        sleep(uint32_t wakeups, std::chrono::milliseconds timeout);
+    void        adapt(std::chrono::steady_clock::time_point parkedAt);
+
+    int                   m_spinMicroseconds; // adapted by the output thread
+    std::atomic<bool>     m_parked;           // the output thread is (about to be) parked
+    std::atomic<uint32_t> m_wakeups;          // futex word
+};
+
+#endif // CONSUMERPARKER_H
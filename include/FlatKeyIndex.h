@@ -0,0 +1,269 @@
+#ifndef FLATKEYINDEX_H
+#define FLATKEYINDEX_H
+
+/**
+ * @file FlatKeyIndex.h
+ * @brief FlatKeyIndex template.
+ *        Open addressing hash table (Swiss table layout) mapping string keys to values.
+ *        One metadata byte per slot (empty, or 7 bits of the key hash) is probed 16 slots
+ *        at a time with SSE2, so a lookup usually touches one metadata group and one slot.
+ *        Keys are copied once into a chunked arena: their address never changes, and the
+ *        string_view handed out by the index stays valid until clear() or destruction.
+ *        There is no erase: MapManager only inserts, and purges by building a new index.
+ * @author Guillermo M. Paris
+ * @date 2026-10-18
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define FLATKEYINDEX_ARENA_BLOCK 65536 // bytes per arena block
+
+template<class V>
+class FlatKeyIndex
+{
+public:
+    struct Slot
+    {
+        std::string_view key;   // points into the arena
+        V                value;
+    };
+
+    static constexpr std::size_t ms_groupSize = 16;
+    static constexpr std::size_t ms_arenaBlockSize = FLATKEYINDEX_ARENA_BLOCK;
+
+    FlatKeyIndex() : m_size(0), m_growthLeft(0), m_groupMask(0), m_arenaLeft(0), m_arenaBytes(0)
+    {
+        rehash(ms_groupSize);
+    }
+
+    explicit FlatKeyIndex(std::size_t expected) : FlatKeyIndex() { reserve(expected); }
+
+    FlatKeyIndex(const FlatKeyIndex&) = delete;
+    FlatKeyIndex& operator = (const FlatKeyIndex&) = delete;
+
+    static std::size_t hash(std::string_view key) { return std::hash<std::string_view>{}(key); }
+
+    std::size_t size() const  { return m_size; }
+    bool        empty() const { return m_size == 0; }
+    std::size_t capacity() const { return m_slots.size(); }
+
+    // Bytes held by the table: metadata, slots and key arena.
+    std::size_t memoryUsage() const
+    { return m_ctrl.size() * sizeof(Group) + m_slots.size() * sizeof(Slot) + m_arenaBytes; }
+
+    V* find(std::string_view key) { return find(key, hash(key)); }
+
+    V* find(std::string_view key, std::size_t h)
+    {
+        Slot* pSlot = findSlot(key, h);
+        return pSlot ? &pSlot->value : nullptr;
+    }
+
+    // Returns the slot of key, inserting {key, V(args...)} if it was not there.
+    template<class... Args>
+    std::pair<Slot*, bool> tryEmplace(std::string_view key, Args&&... args)
+    {
+        return tryEmplaceHashed(key, hash(key), std::forward<Args>(args)...);
+    }
+
+    template<class... Args>
+    std::pair<Slot*, bool> tryEmplaceHashed(std::string_view key, std::size_t h, Args&&... args)
+    {
+        Slot* pSlot = findSlot(key, h);
+        if (pSlot) return {pSlot, false};
+
+        if (m_growthLeft == 0)
+            rehash(m_slots.size() * 2);
+
+        std::size_t index = findEmpty(h);
+        setCtrl(index, h2(h));
+        pSlot = &m_slots[index];
+        pSlot->key = intern(key);
+        pSlot->value = V(std::forward<Args>(args)...);
+        ++m_size;
+        --m_growthLeft;
+        return {pSlot, true};
+    }
+
+    void reserve(std::size_t expected)
+    {
+        std::size_t needed = ms_groupSize;
+        while (needed - needed / 8 < expected) needed *= 2;
+        if (needed > m_slots.size()) rehash(needed);
+    }
+
+    void clear()
+    {
+        m_arena.clear();
+        m_arenaLeft = 0;
+        m_arenaBytes = 0;
+        m_size = 0;
+        m_ctrl.clear();
+        m_slots.clear();
+        rehash(ms_groupSize);
+    }
+
+    // Calls f(std::string_view key, V& value) for every element, in table order.
+    template<class F>
+    void forEach(F&& f)
+    {
+        for (std::size_t i = 0; i < m_slots.size(); ++i)
+        {
+            if (ctrl(i) != ms_empty)
+                f(m_slots[i].key, m_slots[i].value);
+        }
+    }
+
+    // Fills out with every slot sorted by key. Ordering is only paid here (e.g. backups).
+    void sortedSlots(std::vector<const Slot*>& out) const
+    {
+        out.clear();
+        out.reserve(m_size);
+        for (std::size_t i = 0; i < m_slots.size(); ++i)
+        {
+            if (ctrl(i) != ms_empty)
+                out.push_back(&m_slots[i]);
+        }
+
+        std::sort( out.begin(), out.end(),
+                   [](const Slot* a, const Slot* b) { return a->key < b->key; } );
+    }
+
+private:
+    static constexpr int8_t ms_empty = -128;
+
+    struct alignas(16) Group
+    {
+        int8_t ctrl[ms_groupSize];
+    };
+
+    static int8_t      h2(std::size_t h) { return static_cast<int8_t>(h & 0x7F); }
+    static std::size_t h1(std::size_t h) { return h >> 7; }
+
+    int8_t ctrl(std::size_t index) const { return m_ctrl[index / ms_groupSize].ctrl[index % ms_groupSize]; }
+    void   setCtrl(std::size_t index, int8_t c) { m_ctrl[index / ms_groupSize].ctrl[index % ms_groupSize] = c; }
+
+    // Bit i set when byte i of the group equals c.
+    static uint32_t matchByte(const Group& g, int8_t c)
+    {
+#if defined(__SSE2__)
+        __m128i group = _mm_load_si128(reinterpret_cast<const __m128i*>(g.ctrl));
+        return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8(c))));
+#else
+        uint32_t mask = 0;
+        for (std::size_t i = 0; i < ms_groupSize; ++i)
+            mask |= uint32_t(g.ctrl[i] == c) << i;
+        return mask;
+#endif
+    }
+
+    static unsigned lowestBit(uint32_t mask) { return static_cast<unsigned>(__builtin_ctz(mask)); }
+
+    Slot* findSlot(std::string_view key, std::size_t h)
+    {
+        const int8_t tag = h2(h);
+        std::size_t g = h1(h) & m_groupMask;
+        for (std::size_t step = 1; ; ++step)
+        {
+            const Group& group = m_ctrl[g];
+            for (uint32_t match = matchByte(group, tag); match != 0; match &= match - 1)
+            {
+                Slot& slot = m_slots[g * ms_groupSize + lowestBit(match)];
+                if (slot.key == key)
+                    return &slot;
+            }
+
+            if (matchByte(group, ms_empty) != 0)
+                return nullptr;
+
+            g = (g + step) & m_groupMask; // triangular probing visits every group
+        }
+    }
+
+    std::size_t findEmpty(std::size_t h) const
+    {
+        std::size_t g = h1(h) & m_groupMask;
+        for (std::size_t step = 1; ; ++step)
+        {
+            uint32_t empty = matchByte(m_ctrl[g], ms_empty);
+            if (empty != 0)
+                return g * ms_groupSize + lowestBit(empty);
+
+            g = (g + step) & m_groupMask;
+        }
+    }
+
+    void rehash(std::size_t newCapacity)
+    {
+        std::vector<Group> oldCtrl(newCapacity / ms_groupSize);
+        std::vector<Slot>  oldSlots(newCapacity);
+        oldCtrl.swap(m_ctrl);
+        oldSlots.swap(m_slots);
+
+        for (Group& g : m_ctrl)
+            std::memset(g.ctrl, ms_empty, ms_groupSize);
+
+        m_groupMask = m_ctrl.size() - 1;
+        m_growthLeft = newCapacity - newCapacity / 8 - m_size; // max load 7/8
+
+        for (std::size_t i = 0; i < oldSlots.size(); ++i)
+        {
+            if (oldCtrl[i / ms_groupSize].ctrl[i % ms_groupSize] == ms_empty)
+                continue;
+
+            std::size_t h = hash(oldSlots[i].key);
+            std::size_t index = findEmpty(h);
+            setCtrl(index, h2(h));
+            m_slots[index] = std::move(oldSlots[i]);
+        }
+    }
+
+    std::string_view intern(std::string_view key)
+    {
+        if (key.size() > m_arenaLeft)
+        {
+            // Big keys get a block of their own, so the current block is not wasted.
+            std::size_t blockSize = std::max(ms_arenaBlockSize, key.size());
+            m_arena.emplace_back(new char[blockSize]);
+            m_arenaBytes += blockSize;
+            if (key.size() * 4 > ms_arenaBlockSize && m_arena.size() > 1)
+            {
+                std::swap(m_arena.back(), m_arena[m_arena.size() - 2]);
+                std::memcpy(m_arena[m_arena.size() - 2].get(), key.data(), key.size());
+                return std::string_view(m_arena[m_arena.size() - 2].get(), key.size());
+            }
+
+            m_arenaCursor = m_arena.back().get();
+            m_arenaLeft = blockSize;
+        }
+
+        char* p = m_arenaCursor;
+        std::memcpy(p, key.data(), key.size());
+        m_arenaCursor += key.size();
+        m_arenaLeft -= key.size();
+        return std::string_view(p, key.size());
+    }
+
+    std::size_t                          m_size;
+    std::size_t                          m_growthLeft;
+    std::size_t                          m_groupMask;
+    std::vector<Group>                   m_ctrl;
+    std::vector<Slot>                    m_slots;
+    std::vector<std::unique_ptr<char[]>> m_arena;
+    char*                                m_arenaCursor = nullptr;
+    std::size_t                          m_arenaLeft;
+    std::size_t                          m_arenaBytes;
+};
+
+#endif // FLATKEYINDEX_H
@@ -8,12 +8,18 @@
  * @date 2019-12-15
  */
 
+#include <cstddef>
+#include "KeyBatch.h"
 #include "KeyFrequency.h"
 
 class IMapManager
 {
 public:
+    virtual ~IMapManager() {}
+
     virtual void      addOrUpdateKey(const std::string& key, const std::string& url, unsigned int port) = 0;
+    // Same result as addOrUpdateKey() on every event in order, duplicate keys collapsed first.
+    virtual void      addOrUpdateKeys(const KeyEvent* pEvents, std::size_t n) = 0;
     virtual void      setTopKeyReportBaseSize(unsigned short baseSize) = 0;
     virtual unsigned  getTopKeyReportBaseSize() = 0;
     virtual unsigned  getTopKeyReportActualSize() = 0;
@@ -9,16 +9,29 @@
  * @date 2020-01-08
  */
 
+#include "LogLinearHistogram.h"
+#include "OverloadGuard.h"
+
+struct QueueStats
+{
+    LogLinearHistogram::Summary latency; // enqueue to apply of the sampled messages, nanoseconds
+    LogLinearHistogram::Summary depth;   // messages queued, sampled by the output thread per batch
+};
 
 template<class E, class C>
 class IQueue
 {
 public:
+    virtual       ~IQueue() {}
     virtual bool  isEmpty() = 0;
-    virtual void  push(E) = 0;
+    virtual bool  push(E) = 0;    // false: not queued (overload policy, stopped queue) and deleted
+    // push() of a message of keys: the number of them queued, less than keys if part was shed.
+    virtual size_t pushKeys(E e, size_t keys) { return push(e) ? keys : 0; }
     virtual void  setConsumer(C) = 0; // It is up to consumer class to call pop()
     virtual bool  start() = 0;
     virtual bool  stop() = 0;
+    virtual OverloadGuard::Stats getOverloadStats() { return {0, 0, 0, 0, 0}; } // unbounded queue
+    virtual QueueStats getQueueStats() { return QueueStats(); } // not instrumented queue: all 0
 };
 
 
@@ -0,0 +1,80 @@
+#ifndef INLINEMESSAGE_H
+#define INLINEMESSAGE_H
+
+/**
+ * @file InlineMessage.h
+ * @brief InlineMessage interface.
+ *        Fixed size, trivially copyable message, stored by value in the InlineMessageQueue ring:
+ *        the command, the key in an inline buffer, the interned backend id and the numbers.
+ *        Keys longer than the inline buffer are copied into a spill arena: chunks owned by the
+ *        producer thread, reference counted by the messages pointing into them, so the chunk
+ *        is freed by whichever thread releases its last key.
+ * @author Guillermo M. Paris
+ * @date 2026-10-18
+ */
+
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+#include "Message.h"
+
+#define INLINE_MESSAGE_KEY_SIZE  64     // longest key kept inside the message
+#define INLINE_SPILL_CHUNK_SIZE  65536  // bytes of every spill arena chunk
+
+class InlineMessage
+{
+public:
+    using Command = Message::Command;
+
+    static constexpr std::size_t ms_KeySize = INLINE_MESSAGE_KEY_SIZE;
+
+    InlineMessage() = default;
+
+    InlineMessage(Command c, uint8_t u8 = 0, uint16_t u16 = 0, uint32_t u32 = 0)
+        : m_keyLength(0), m_backend(0), m_number(u32), m_cmd(c), m_nbyte(u8), m_nshort(u16) {}
+
+    // backend is an id of the BackendDictionary of the queue. Keys longer than ms_KeySize are
+    // copied into the spill arena of the calling thread.
+    InlineMessage(Command c, std::string_view key, uint32_t backend,
+                  uint8_t u8 = 0, uint16_t u16 = 0, uint32_t u32 = 0);
+
+    std::string_view getKey() const
+    { return { isSpilled() ? m_key.spilled.data : m_key.inlined, m_keyLength }; }
+
+    bool          isSpilled() const  { return m_keyLength > ms_KeySize; }
+    Command       getCommand() const { return m_cmd; }
+    uint32_t      getBackend() const { return m_backend; }
+    uint8_t       getByte() const    { return m_nbyte; }
+    uint16_t      getShort() const   { return m_nshort; }
+    uint32_t      getNumber() const  { return m_number; }
+
+    // Once the key is no longer used: a spilled key is given back to its arena chunk.
+    // Exactly once per message built with a key (copies share the spilled key).
+    void          releaseKey() const;
+
+private:
+    struct SpillChunk;
+    class  SpillArena;
+
+    union Key
+    {
+        char inlined[INLINE_MESSAGE_KEY_SIZE];
+        struct
+        {
+            SpillChunk* chunk;
+            const char* data;
+        } spilled;
+    };
+
+    Key       m_key;
+    uint32_t  m_keyLength;
+    uint32_t  m_backend;
+    uint32_t  m_number;
+    Command   m_cmd;
+    uint8_t   m_nbyte;
+    uint16_t  m_nshort;
+};
+
+static_assert(std::is_trivially_copyable<InlineMessage>::value, "InlineMessage is copied by value into the ring");
+
+#endif // INLINEMESSAGE_H
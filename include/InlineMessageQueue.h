@@ -0,0 +1,90 @@
+#ifndef INLINEMESSAGEQUEUE_H
+#define INLINEMESSAGEQUEUE_H
+
+/**
+ * @file InlineMessageQueue.h
+ * @brief InlineMessageQueue interface.
+ *        A Queue + output thread for messaging to IMapManager derived objects, like
+ *        ThreadedMessageQueue, but messages are InlineMessage values copied into a bounded ring
+ *        of cache line aligned slots: no allocation per message and no pointer to follow on pop.
+ *        The ring is a multi producer, single consumer array queue: producers claim a slot by
+ *        incrementing the tail, and every slot carries a sequence number telling whether it is
+ *        free or published for the lap in course. The output thread applies the keys straight
+ *        from the ring, so a batch of slots is only given back once it is applied.
+ *        push() waits for a free slot when the ring is full (block overload policy).
+ * @author Guillermo M. Paris
+ * @date 2026-10-18
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "BackendDictionary.h"
+#include "ConsumerParker.h"
+#include "IMapManager.h"
+#include "InlineMessage.h"
+#include "IQueue.h"
+
+#define INLINE_QUEUE_DEFAULT_SLOTS 65536
+
+#ifndef CACHE_LINE_SIZE
+#define CACHE_LINE_SIZE 64
+#endif
+
+class InlineMessageQueue : public IQueue<const InlineMessage&, IMapManager*>
+{
+public:
+    // slots is rounded up to a power of 2, at least twice batchSize.
+    InlineMessageQueue(size_t slots = INLINE_QUEUE_DEFAULT_SLOTS, size_t batchSize = DEFAULT_KEY_BATCH_SIZE);
+    ~InlineMessageQueue();
+
+    InlineMessageQueue(const InlineMessageQueue&) = delete;
+    InlineMessageQueue& operator = (const InlineMessageQueue&) = delete;
+
+    virtual void setConsumer(IMapManager* pMgr) { m_consumer = pMgr; }
+    virtual bool isEmpty();
+    virtual bool start();
+    virtual bool stop();
+    // Ignored (and its key released) when the queue is not running.
+    virtual bool push(const InlineMessage& msg);
+
+    // Builds the addKey message straight into its slot, interning url into getBackends().
+    bool         pushKey(std::string_view key, std::string_view url, unsigned port);
+
+    // Backend ids of the messages pushed to this queue.
+    BackendDictionary& getBackends() { return m_backends; }
+    size_t       getCapacity() const { return m_mask + 1; }
+    size_t       getBatchSize() const { return m_batchSize; }
+
+private:
+    struct alignas(CACHE_LINE_SIZE) Slot
+    {
+        std::atomic<size_t> sequence; // == position: free, == position + 1: published
+        InlineMessage       message;
+    };
+
+    Slot&   slot(size_t position) { return m_slots[position & m_mask]; }
+    // Producer side: the position of a free slot, waiting while the ring is full.
+    bool    claim(size_t& position);
+    void    publish(size_t position);
+
+    void    run();
+    // Applies the pending keys, then gives their slots back up to position head.
+    void    flushKeys(std::vector<KeyEvent>& events, size_t head);
+    void    releaseSlot(size_t position);
+
+    Slot*                 m_slots;
+    size_t                m_mask;
+    size_t                m_batchSize;
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> m_tail; // next position to claim
+    alignas(CACHE_LINE_SIZE) std::atomic<size_t> m_head; // next position to give back
+    std::atomic<bool>     m_running;
+    IMapManager*          m_consumer;
+    BackendDictionary     m_backends;
+    ConsumerParker        m_parker;
+    std::thread           m_poper;
+};
+
+#endif // INLINEMESSAGEQUEUE_H
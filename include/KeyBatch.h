@@ -0,0 +1,74 @@
+#ifndef KEYBATCH_H
+#define KEYBATCH_H
+
+/**
+ * @file KeyBatch.h
+ * @brief KeyEvent and KeyBatch interface.
+ *        A KeyEvent is one key notification (key, url, port) handed to a map manager in a batch.
+ *        KeyBatch collapses the events of a batch sharing the same key into one (key, count)
+ *        entry before any lock is taken, so a map manager updates every distinct key once.
+ *        Its buffers are reused from batch to batch: once warmed up it allocates nothing.
+ * @author Guillermo M. Paris
+ * @date 2026-10-18
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+#define DEFAULT_KEY_BATCH_SIZE 256
+
+// Partition (shard, queue) of a key among n, from its std::hash. The upper half of the hash is
+// used, so the partition does not correlate with the bucket choice inside a partition.
+inline unsigned int keyPartition(std::size_t keyHash, std::size_t n)
+{
+    return static_cast<unsigned int>((keyHash >> (sizeof(std::size_t) * 4)) % n);
+}
+
+// Views of the strings of the caller: they must outlive the addOrUpdateKeys() call.
+struct KeyEvent
+{
+    std::string_view key;
+    std::string_view url;
+    unsigned int     port;
+    unsigned int     count = 1; // events it stands for (e.g. a sampled key)
+};
+
+// Bulk body: one key[,url,port[,count]] record per line ('\n' or "\r\n"), e.g. "hot key,www.a.com,80,3".
+// Appends one KeyEvent per record to events, viewing the body: nothing is copied. Empty lines
+// and records with an empty key or a zero count are skipped, a missing or bad port is 0. Every
+// count is multiplied by weight (a sampled bulk). Returns the records appended.
+std::size_t parseKeyRecords(std::string_view body, std::vector<KeyEvent>& events, unsigned int weight = 1);
+// Next record line of a bulk body, consumed from it, without its '\n' or "\r\n".
+std::string_view nextKeyRecord(std::string_view& body);
+// Records of a bulk body by a newline scan only (no field is parsed): the lines with a key.
+// Records parseKeyRecords() skips for a zero or bad count are counted too.
+std::size_t countKeyRecords(std::string_view body);
+
+class KeyBatch
+{
+public:
+    struct Entry
+    {
+        std::string_view key;
+        std::string_view url;   // of the last event of the key
+        unsigned int     port;  // of the last event of the key
+        unsigned long    count; // events of the key in the batch
+        std::size_t      hash;  // std::hash<std::string_view> of the key
+    };
+
+    // Replaces the entries by the ones of the events, in order of first appearance.
+    void         aggregate(const KeyEvent* pEvents, std::size_t n);
+
+    const Entry* begin() const { return m_entries.data(); }
+    const Entry* end() const   { return m_entries.data() + m_entries.size(); }
+    std::size_t  size() const  { return m_entries.size(); }
+    bool         empty() const { return m_entries.empty(); }
+
+private:
+    std::vector<Entry>    m_entries;
+    std::vector<uint32_t> m_table; // open addressing: entry index + 1, 0 when empty
+};
+
+#endif // KEYBATCH_H
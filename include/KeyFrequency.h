@@ -8,16 +8,34 @@
  * @date 2020-01-08
  */
 
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <vector>
 
+// Allocation free ranking element. key points to storage owned by the map manager.
+struct KeyCount
+{
+    std::string_view key;
+    uint64_t         count;
+};
+
+using KeyCountVector = std::vector<KeyCount>;
+
 struct KeyFrequency
 {
     KeyFrequency(const std::string&& sKey, const std::string&& sFreq)
       : key(sKey), frequency(sFreq) {}
 
+    KeyFrequency(const std::string&& sKey, const std::string&& sFreq, const std::string&& sError)
+      : key(sKey), frequency(sFreq), error(sError) {}
+
+    explicit KeyFrequency(const KeyCount& kc)
+      : key(kc.key), frequency(std::to_string(kc.count)) {}
+
     std::string  key;
     std::string  frequency;
+    std::string  error;     // maximum overestimation of frequency. Empty when it is exact.
 };
 
 using KeyFrequencyVector = std::vector<KeyFrequency>;
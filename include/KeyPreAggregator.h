@@ -0,0 +1,108 @@
+#ifndef KEYPREAGGREGATOR_H
+#define KEYPREAGGREGATOR_H
+
+/**
+ * @file KeyPreAggregator.h
+ * @brief KeyPreAggregator interface.
+ *        Optional ingest stage between the listener threads and the message queue. Every thread
+ *        counts its keys in its own small key -> count table instead of queueing one Message per
+ *        event, so a hot key costs a hash table bump. A table is flushed to the queue as weighted
+ *        addKey messages (the count travels in the message short) when it is full, when a count
+ *        reaches 65535, and by a flusher thread once its oldest count is staleness old: a key is
+ *        queued at most staleness after it was seen.
+ *        Every table has its own mutex, only contended while the flusher visits it.
+ *        The queue sheds counts long after their events were accepted, so once it shed one the
+ *        new events are refused for a staleness period: the caller reports the overload and the
+ *        client retries, as with keys queued one by one.
+ * @author Guillermo M. Paris
+ * @date 2026-10-18
+ */
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "IMapManager.h"
+#include "IQueue.h"
+#include "Message.h"
+
+#define PREAGGREGATION_TABLE_KEYS           1024 // distinct keys per thread table before it is flushed
+#define PREAGGREGATION_STALENESS_MICROSECONDS 1000 // default bound of the time a count waits
+
+class KeyPreAggregator
+{
+public:
+    using MessageQueue = IQueue<Message*, IMapManager*>;
+
+    struct Stats
+    {
+        uint64_t events;   // keys counted
+        uint64_t messages; // weighted messages queued
+        uint64_t dropped;  // events of messages shed by the queue
+        uint64_t tables;   // thread tables
+    };
+
+    // The flusher thread runs from construction to destruction, which flushes what is left.
+    KeyPreAggregator(MessageQueue& queue,
+                     std::chrono::microseconds staleness = std::chrono::microseconds(PREAGGREGATION_STALENESS_MICROSECONDS),
+                     size_t tableKeys = PREAGGREGATION_TABLE_KEYS);
+    ~KeyPreAggregator();
+
+    KeyPreAggregator(const KeyPreAggregator&) = delete;
+    KeyPreAggregator& operator = (const KeyPreAggregator&) = delete;
+
+    // Any thread: one event of key. The url and port of the last event of a key are the queued ones.
+    // False, and the event is not counted, when the queue shed a count less than staleness ago.
+    bool      addKey(const std::string& key, const std::string& url, uint32_t port);
+    // Flushes every table now.
+    void      flush();
+
+    Stats     getStats() const;
+    std::chrono::microseconds getStaleness() const { return m_staleness; }
+
+private:
+    struct Count
+    {
+        std::string url;
+        uint32_t    port;
+        uint16_t    count;
+    };
+
+    struct Table
+    {
+        std::mutex                             mutex;
+        std::unordered_map<std::string, Count> counts;
+        std::chrono::steady_clock::time_point  oldest; // of the pending counts
+        uint64_t                               events = 0;
+    };
+
+    class ThreadTables;
+
+    Table*    table(); // of the calling thread
+    // Table mutex held.
+    void      flushTable(Table& table);
+    void      queueCount(const std::string& key, Count& count);
+    void      runFlusher();
+
+    const uint64_t                      m_id; // never reused, unlike addresses
+    MessageQueue&                       m_queue;
+    const std::chrono::microseconds     m_staleness;
+    const size_t                        m_tableKeys;
+    mutable std::mutex                  m_tablesMutex;
+    std::vector<std::unique_ptr<Table>> m_tables;
+    std::atomic<uint64_t>               m_messages;
+    std::atomic<uint64_t>               m_dropped;
+    std::atomic<int64_t>                m_lastDrop; // steady_clock ticks of the last shed count, 0: none
+    std::mutex                          m_flusherMutex;
+    std::condition_variable             m_flusherWakeUp;
+    bool                                m_stopping;
+    std::thread                         m_flusher;
+};
+
+#endif // KEYPREAGGREGATOR_H
@@ -0,0 +1,104 @@
+#ifndef LOGLINEARHISTOGRAM_H
+#define LOGLINEARHISTOGRAM_H
+
+/**
+ * @file LogLinearHistogram.h
+ * @brief LogLinearHistogram and TickClock interfaces.
+ *        LogLinearHistogram: lock free histogram of 64 bit values. Every power of two range is
+ *        split in 2^LOGLINEAR_SUB_BUCKET_BITS linear buckets, so a reported percentile is at most
+ *        1/2^LOGLINEAR_SUB_BUCKET_BITS above the real value, whatever its magnitude. One thread
+ *        records (no atomic read-modify-write: a load and a store per value), any thread reads.
+ *        TickClock: the cheapest monotonic time stamp of the platform (the TSC on x86-64, the
+ *        steady clock elsewhere). Ticks are converted to nanoseconds only when reporting.
+ * @author Guillermo M. Paris
+ * @date 2026-10-18
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#define LOGLINEAR_SUB_BUCKET_BITS 4 // 16 buckets per power of two: 6.25 % resolution
+
+class TickClock
+{
+public:
+    static uint64_t now()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+    }
+
+    // Calibrated against the steady clock since the program started (waits for 10 mSec of it
+    // when called earlier).
+    static double nanosecondsPerTick();
+};
+
+class LogLinearHistogram
+{
+public:
+    static constexpr unsigned ms_SubBucketBits = LOGLINEAR_SUB_BUCKET_BITS;
+    static constexpr unsigned ms_SubBuckets = 1U << LOGLINEAR_SUB_BUCKET_BITS;
+    static constexpr unsigned ms_Buckets = (64 - LOGLINEAR_SUB_BUCKET_BITS + 1) << LOGLINEAR_SUB_BUCKET_BITS;
+
+    struct Summary
+    {
+        uint64_t count;
+        uint64_t p50;
+        uint64_t p99;
+        uint64_t p999;
+        uint64_t max;
+    };
+
+    LogLinearHistogram() { reset(); }
+
+    LogLinearHistogram(const LogLinearHistogram&) = delete;
+    LogLinearHistogram& operator = (const LogLinearHistogram&) = delete;
+
+    // Single writer.
+    void     record(uint64_t value)
+    {
+        std::atomic<uint64_t>& bucket = m_buckets[getBucket(value)];
+        bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        m_count.store(m_count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        if (value > m_max.load(std::memory_order_relaxed))
+            m_max.store(value, std::memory_order_relaxed);
+    }
+
+    // Adds the counts of another histogram. The writer of this one must not be recording.
+    void     add(const LogLinearHistogram& other);
+    // Not while recording.
+    void     reset();
+
+    uint64_t getCount() const { return m_count.load(std::memory_order_relaxed); }
+    uint64_t getMax() const   { return m_max.load(std::memory_order_relaxed); }
+    // Upper bound of the bucket holding the given fraction (0..1] of the values, max at most.
+    uint64_t getPercentile(double fraction) const;
+    // Percentiles and max multiplied by scale (e.g. TickClock::nanosecondsPerTick()).
+    Summary  getSummary(double scale = 1.0) const;
+
+    static unsigned getBucket(uint64_t value)
+    {
+        if (value < ms_SubBuckets)
+            return unsigned(value);
+
+        const unsigned exponent = 63U - unsigned(__builtin_clzll(value)); // >= ms_SubBucketBits
+        const unsigned shift = exponent - ms_SubBucketBits;
+        return ((shift + 1) << ms_SubBucketBits) + unsigned((value >> shift) & (ms_SubBuckets - 1));
+    }
+    static uint64_t getBucketUpperBound(unsigned bucket);
+
+private:
+    std::atomic<uint64_t> m_buckets[ms_Buckets];
+    std::atomic<uint64_t> m_count;
+    std::atomic<uint64_t> m_max;
+};
+
+#endif // LOGLINEARHISTOGRAM_H
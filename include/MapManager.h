@@ -10,9 +10,16 @@
  */
 
 #include <condition_variable>
-#include <map>
+#include <cstdint>
+#include <iosfwd>
 #include <mutex>
+#include <string_view>
+#include <vector>
+#include "BackendDictionary.h"
+#include "FlatKeyIndex.h"
 #include "IMapManager.h"
+#include "SnapshotPublisher.h"
+#include "StreamSummary.h"
 #include "verbosity.h"
 
 #define DEFAULT_TOPKEY_REPORTSIZE 10
@@ -23,41 +30,110 @@
 class MapManager : public IMapManager
 {
 public:
+    struct RankedKey
+    {
+        std::string_view key;         // points into the key map arena
+        uint16_t         fingerprint; // see hotKeyFingerprint()
+    };
+
+    // Top M keys in frequency buckets: an increment moves the key to the next bucket in O(1).
+    using Ranking = StreamSummary<RankedKey>;
+
     struct KeyDetails
     {
-        KeyDetails(const std::string& s, unsigned int ui, unsigned long ul)
-          : url(s), port(ui), frequency(ul) {}
+        KeyDetails() : backend(0), port(0), frequency(0), rank(nullptr) {}
+        KeyDetails(uint32_t b, unsigned int ui, unsigned long ul)
+          : backend(b), port(ui), frequency(ul), rank(nullptr) {}
 
-        std::string   url;
+        uint32_t      backend; // url id in the BackendDictionary
         unsigned int  port;
         unsigned long frequency;
+        Ranking::Node* rank;  // nullptr when the key is out of the ranking
+    };
+
+    using strdetailsMap = FlatKeyIndex<KeyDetails>; // hashed, ordered only when backing up
+
+    // Immutable copy of the ranking published for the readers. Keys point into the key map
+    // arena, which is not released while any reader holds an older copy.
+    struct TopKeys
+    {
+        KeyCountVector             entries;      // highest frequency first
+        std::vector<uint16_t>      fingerprints; // one per key, 0 padded up to ms_fingerprintLanes
+        unsigned int               size = 0;     // valid elements, up to M
+        unsigned int               base = 0;     // N when it was published
     };
 
-    using strdetailsMap = std::map<std::string, KeyDetails>;
-    using ulongstrMap = std::multimap<unsigned long, std::string>;
-    using strdetailsIterator = std::map<std::string, KeyDetails>::iterator;
-    using ulongstrIterator = std::multimap<unsigned long, std::string>::iterator;
+    using TopKeysPublisher = SnapshotPublisher<TopKeys>;
+    // Pins the published ranking: keys handed out by getTopKeys() stay valid while it lives.
+    using TopKeysGuard = TopKeysPublisher::ReadGuard;
 
     MapManager();
-    MapManager(unsigned int n, unsigned int m = 0, unsigned int ll = 0);
+    // backends may be shared by several managers and is not owned. nullptr: a dictionary of its own.
+    MapManager(unsigned int n, unsigned int m = 0, unsigned int ll = 0, BackendDictionary* backends = nullptr);
     ~MapManager();
 
     virtual void       addOrUpdateKey(const std::string& key, const std::string& url, unsigned int port);
+    virtual void       addOrUpdateKeys(const KeyEvent* pEvents, std::size_t n);
     virtual void       setTopKeyReportBaseSize(unsigned short base);
     virtual unsigned   getTopKeyReportBaseSize() {return m_baseReportElementNumber;}  // getN();
-    virtual unsigned   getTopKeyReportActualSize() {return m_pFrequencyMap->size();}
+    virtual unsigned   getTopKeyReportActualSize() {return TopKeysPublisher::ReadGuard(m_topKeys)->size;}
     virtual unsigned   getTopKeyReportMaxSize() {return m_maxReportElementNumber;} // getM();
     virtual unsigned   getTotalKeyNumber() {return m_pKeyMap->size();}
-    virtual void       getTopHotkeys(KeyFrequencyVector& vec);
-    virtual bool       isHotKey(const std::string& key);
+    virtual void       getTopHotkeys(KeyFrequencyVector& vec);    // lock free (published ranking)
+    virtual bool       isHotKey(const std::string& key);          // lock free (published ranking)
     virtual bool       backupRequest(const std::string& keyFilename, const std::string& freqFilename);
     virtual bool       restoreRequest(const std::string& keyFilename, const std::string& freqFilename);
 
+    // Applies entries already aggregated by a KeyBatch, under one map lock acquisition.
+    void               addOrUpdateKeys(const KeyBatch::Entry* pEntries, std::size_t n);
+
+    // Published frequency of the key if it is a hot one, 0 otherwise. Lock free, as isHotKey().
+    uint64_t           getHotKeyCount(const std::string& key);
+    // Same answer than isHotKey(), taken from the live ranking under the map lock.
+    bool               isRankedKey(const std::string& key);
+
+    // Stream versions of the above, so several managers can share the same pair of files.
+    // Key lines refer to the first knownBackends ids as "#id" (a BackendDictionary header written
+    // before them), other urls are written in full. pBackendIds translates those "#id" on restore.
+    bool               backupRequest(std::ostream& keyStream, std::ostream& freqStream, uint32_t knownBackends = 0);
+    bool               restoreRequest( std::istream& keyStream, std::istream& freqStream,
+                                       const std::vector<uint32_t>* pBackendIds = nullptr );
+    // Copies up to count ranking elements (highest frequency first). count may go up to M. Lock free.
+    void               getRanking(KeyFrequencyVector& vec, unsigned int count);
+    // Fills out (cleared, preallocated by the caller: nothing is allocated when its capacity
+    // reaches count) with up to count ranking elements pinned by guard. Returns out.size().
+    unsigned int       getTopKeys(const TopKeysGuard& guard, KeyCountVector& out, unsigned int count);
+    TopKeysGuard       pinTopKeys() {return TopKeysGuard(m_topKeys);}
+
+    BackendDictionary& getBackends() {return *m_pBackends;}
+    std::size_t        memoryUsage(); // key map bytes, plus the dictionary when it is not shared
+
     void               purge(unsigned short n); // purge n /  N <= n <= M
     void               zap();
 
 private:
+    // Adds count to the frequency of the key (hash h). Caller holds m_mapMutex.
+    // Returns true if the ranking changed.
+    bool               updateKey( std::string_view key, std::size_t h, std::string_view url,
+                                  unsigned int port, unsigned long count );
+    // Puts the key in the ranking if its frequency deserves it, evicting the lowest one when full.
+    void               rankKey(std::string_view key, KeyDetails& details);
+    // Publishes a new snapshot of the ranking for the readers. Caller holds m_mapMutex.
+    void               publishTopKeys();
+    void               initTopKeys();
+    // Backend id of a key file url field: a full url, or "#id" translated by pBackendIds (only
+    // when the file had a dictionary header, otherwise it is a url as well).
+    bool               resolveBackend(const std::string& field, const std::vector<uint32_t>* pBackendIds, uint32_t& backend);
+    static void        copyTopKeys(const TopKeys& topKeys, KeyFrequencyVector& vec, unsigned int count);
+
+    // Never 0, which pads TopKeys::fingerprints.
+    static uint16_t    hotKeyFingerprint(std::size_t hash) { return uint16_t(hash >> 48) | 1; }
+    // Index of the first published key from 'from' on with that fingerprint, or topKeys.size.
+    static unsigned    findFingerprint(const TopKeys& topKeys, uint16_t fingerprint, unsigned from);
+
+    static constexpr unsigned ms_fingerprintLanes = 8; // per SSE2 compare
     static const char  ms_FieldSeparator = FIELD_SEPARATOR;
+    static const char  ms_BackendReference = BackendDictionary::ms_Reference;
     static const short ms_DefaultTopKeySize = DEFAULT_TOPKEY_REPORTSIZE;
     static const short ms_MaxTopKeySize = MAX_TOPKEY_REPORTSIZE;
 
@@ -66,8 +142,11 @@ private:
 
     unsigned short     m_baseReportElementNumber; // N = DEFAULT_TOPKEY_REPORTSIZE
     unsigned short     m_maxReportElementNumber;  // M = MAX_TOPKEY_REPORTSIZE
+    BackendDictionary* m_pBackends;
+    bool               m_ownsBackends;
     strdetailsMap*     m_pKeyMap;
-    ulongstrMap*       m_pFrequencyMap;
+    Ranking*           m_pRanking;
+    TopKeysPublisher   m_topKeys;
     int                m_writingData;
     std::mutex         m_mapMutex;
     std::condition_variable m_mapCondition;
@@ -8,46 +8,53 @@
  * @date 2019-12-15
  */
 
+#include <cstdint>
 #include <string>
+#include "MessagePool.h"
 
 class Message
 {
 public:
     enum class Command : uint8_t
     {
-        notDefined, stop, addKey, getKeyRanking, isHotKey, setRankingLength
+        notDefined, stop, addKey, getKeyRanking, isHotKey, setRankingLength,
+        addKeys // bulk: key records in the first string (parseKeyRecords), their number in the number
     };
 
-    Message() : m_cmd(Command::notDefined), m_nbyte(0), m_nshort(0), m_number(0) {}
+    Message() : m_cmd(Command::notDefined), m_nbyte(0), m_nshort(0), m_number(0), m_ticks(0) {}
 
     Message(Command c, uint8_t u8 = 0, uint16_t u16 = 0, uint32_t u32 = 0)
-        : m_cmd(c), m_nbyte(u8), m_nshort(u16), m_number(u32) {}
+        : m_cmd(c), m_nbyte(u8), m_nshort(u16), m_number(u32), m_ticks(0) {}
 
     Message(Command c, const std::string& s1, const std::string& s2,
             uint8_t u8 = 0, uint16_t u16 = 0, uint32_t u32 = 0)
-        : m_str1(s1), m_str2(s2), m_cmd(c), m_nbyte(u8), m_nshort(u16), m_number(u32) {}
+        : m_str1(s1), m_str2(s2), m_cmd(c), m_nbyte(u8), m_nshort(u16), m_number(u32), m_ticks(0) {}
 
-    Message(Command c, const std::string&& s1, const std::string&& s2,
+    Message(Command c, std::string&& s1, std::string&& s2,
             uint8_t u8 = 0, uint16_t u16 = 0, uint32_t u32 = 0)
-        : m_str1(s1), m_str2(s2), m_cmd(c), m_nbyte(u8), m_nshort(u16), m_number(u32) {}
+        : m_str1(std::move(s1)), m_str2(std::move(s2)), m_cmd(c), m_nbyte(u8), m_nshort(u16), m_number(u32), m_ticks(0) {}
 
     Message(const Message& m)
         : m_str1(m.m_str1), m_str2(m.m_str2), m_cmd(m.m_cmd)
-        , m_nbyte(m.m_nbyte), m_nshort(m.m_nshort), m_number(m.m_number) {}
+        , m_nbyte(m.m_nbyte), m_nshort(m.m_nshort), m_number(m.m_number), m_ticks(m.m_ticks) {}
 
     Message(const Message&& m)
         : m_str1(std::move(m.m_str1)), m_str2(std::move(m.m_str2)), m_cmd(m.m_cmd)
-        , m_nbyte(m.m_nbyte), m_nshort(m.m_nshort), m_number(m.m_number) {}
+        , m_nbyte(m.m_nbyte), m_nshort(m.m_nshort), m_number(m.m_number), m_ticks(m.m_ticks) {}
 
 //  ~Message() {m_str1.clear(); m_str2.clear();}
 
+    // Messages are new'ed by the producer threads and deleted by the queue output thread.
+    static void*  operator new(std::size_t size) { return MessagePool::allocate(size); }
+    static void   operator delete(void* p, std::size_t size) { MessagePool::release(p, size); }
+
     const Message& operator = (const Message& m) // pop = delete;
           { m_cmd = m.m_cmd; m_str1 = m.m_str1; m_str2 = m.m_str2;
-            m_nbyte = m.m_nbyte; m_nshort = m.m_nshort; m_number = m.m_number; return m; }
+            m_nbyte = m.m_nbyte; m_nshort = m.m_nshort; m_number = m.m_number; m_ticks = m.m_ticks; return m; }
 
     const Message& operator = (Message&& m)
           { m_cmd = m.m_cmd; m_str1 = std::move(m.m_str1); m_str2 = std::move(m.m_str2);
-            m_nbyte = m.m_nbyte; m_nshort = m.m_nshort; m_number = m.m_number; return *this; }
+            m_nbyte = m.m_nbyte; m_nshort = m.m_nshort; m_number = m.m_number; m_ticks = m.m_ticks; return *this; }
 
     std::string   getString1() { return m_str1; }
     std::string   getString2() { return m_str2; } // sometimes a copy is necessary :)
@@ -59,6 +66,12 @@ public:
     uint8_t       getByte()    { return m_nbyte; }
     uint16_t      getShort()   { return m_nshort; }
     uint32_t      getNumber()  { return m_number; }
+    void          setByte(uint8_t u8) { m_nbyte = u8; }
+    // addKey: the events the message stands for, its pre-aggregated count (short) times its
+    // sampling weight (byte), 0 meaning 1 for both.
+    unsigned      getKeyCount() { return (m_nshort > 0 ? m_nshort : 1U) * (m_nbyte > 0 ? m_nbyte : 1U); }
+    uint64_t      getTicks()   { return m_ticks; }
+    void          setTicks(uint64_t ticks) { m_ticks = ticks; } // TickClock time it was queued
 
 private:
     std::string  m_str1;
@@ -67,6 +80,7 @@ private:
     uint8_t      m_nbyte;
     uint16_t     m_nshort;
     uint32_t     m_number;
+    uint64_t     m_ticks;
 };
 
 #endif // MESSAGE_H
@@ -0,0 +1,68 @@
+#ifndef MESSAGEPOOL_H
+#define MESSAGEPOOL_H
+
+/**
+ * @file MessagePool.h
+ * @brief MessagePool interface.
+ *        Lock free pool of fixed size blocks for Message objects, which are allocated by the
+ *        producer threads (web listeners) and released by the queue output thread.
+ *        Every thread keeps a cache of free blocks. Released blocks are chained in the cache
+ *        and every full chain is handed over to a shared lock free stack of chains, from where
+ *        allocating threads take every chain at once (exchange: no ABA). Chains keep their
+ *        length in the first block, so handing over or taking them never walks the blocks.
+ *        Only when both are empty blocks are taken from the global allocator: a miss.
+ *        The shared stack is bounded: beyond that, released blocks go back to the global
+ *        allocator, so a burst does not leave a huge scattered free list behind.
+ * @author Guillermo M. Paris
+ * @date 2026-10-18
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#define MESSAGEPOOL_CHAIN_BLOCKS    256 // released blocks per chain handed over to the shared stack
+#define MESSAGEPOOL_REFILL_BLOCKS    64 // blocks taken from the global allocator on a miss
+#define MESSAGEPOOL_SHARED_BLOCKS 16384 // beyond that, released blocks go to the global allocator (a large
+                                    // pool of scattered blocks is slower than fresh memory)
+
+class MessagePool
+{
+public:
+    struct Stats
+    {
+        uint64_t hits;     // allocations served by a thread cache or the shared stack
+        uint64_t misses;   // allocations that needed blocks from the global allocator
+        uint64_t blocks;   // blocks ever taken from the global allocator
+        uint64_t released; // blocks given back to the global allocator
+    };
+
+    static void*        allocate(std::size_t size);
+    static void         release(void* p, std::size_t size);
+    static Stats        getStats();
+    static std::size_t  blockSize();
+
+private:
+    struct Block
+    {
+        Block*      next;
+        Block*      nextChain; // only meaningful in the first block of a chain
+        std::size_t count;     // blocks of the chain, idem
+    };
+
+    class ThreadCache;
+
+    static ThreadCache& threadCache();
+    static void         pushShared(Block* chain);
+    static Block*       takeShared();
+    static Block*       newBlocks();
+
+    static std::atomic<Block*>   ms_shared; // chains of free blocks handed over by other threads
+    static std::atomic<int64_t>  ms_sharedBlocks;
+    static std::atomic<uint64_t> ms_hits;
+    static std::atomic<uint64_t> ms_misses;
+    static std::atomic<uint64_t> ms_blocks;
+    static std::atomic<uint64_t> ms_released;
+};
+
+#endif // MESSAGEPOOL_H
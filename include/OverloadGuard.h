@@ -0,0 +1,127 @@
+#ifndef OVERLOADGUARD_H
+#define OVERLOADGUARD_H
+
+/**
+ * @file OverloadGuard.h
+ * @brief OverloadGuard interface.
+ *        Capacity and overload policy of a message queue. Producers ask for admission before
+ *        pushing, the output thread tells when messages leave the queue. Once the queue holds
+ *        its capacity:
+ *        - block:      the producer waits for room (backpressure up to the clients),
+ *        - dropNewest: the new message is shed,
+ *        - sample:     from half the capacity on, 1 of every sampleRate keys is queued counting
+ *                      sampleRate times and the others are shed; at capacity all of them are.
+ *        A bulk of keys is admitted, shed or sampled as a whole, counting as its keys.
+ *        An unbounded guard (capacity 0) admits everything and counts nothing.
+ * @author Guillermo M. Paris
+ * @date 2026-10-18
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#define DEFAULT_OVERLOAD_SAMPLE_RATE 10 // 1..255: the weight travels in the Message byte
+
+class OverloadGuard
+{
+public:
+    enum class Policy : uint8_t
+    {
+        block, dropNewest, sample
+    };
+
+    struct Stats
+    {
+        uint64_t capacity; // 0: unbounded
+        uint64_t size;     // admitted keys not yet applied
+        uint64_t dropped;  // shed keys
+        uint64_t sampled;  // keys queued on behalf of sampleRate ones
+        uint64_t blocked;  // pushes that had to wait for room
+    };
+
+    explicit OverloadGuard(size_t capacity = 0, Policy policy = Policy::block,
+                           unsigned sampleRate = DEFAULT_OVERLOAD_SAMPLE_RATE);
+
+    // Before the queue is started.
+    void       configure(size_t capacity, Policy policy, unsigned sampleRate = DEFAULT_OVERLOAD_SAMPLE_RATE);
+
+    bool       isBounded() const  { return m_capacity > 0; }
+    size_t     getCapacity() const { return m_capacity; }
+    Policy     getPolicy() const  { return m_policy; }
+    size_t     getSize() const    { return m_size.load(std::memory_order_relaxed); } // bounded only
+
+    // Producer side, before pushing a key (or a bulk of keys). 0: shed it. Otherwise every key
+    // is queued counting that many events. While blocked, running() is polled: once false the
+    // keys are shed.
+    template<class Running>
+    unsigned   admitKey(Running&& running, size_t keys = 1)
+    {
+        if (m_capacity == 0)
+            return 1;
+
+        const size_t size = m_size.fetch_add(keys, std::memory_order_relaxed);
+        if (size + keys <= m_threshold)
+            return 1;
+
+        m_size.fetch_sub(keys, std::memory_order_relaxed);
+        if (m_policy == Policy::block)
+            return waitForRoom(running, keys) ? 1 : 0;
+
+        if (m_policy == Policy::sample && size < m_capacity && sampleOne(keys))
+            return m_sampleRate;
+
+        m_dropped.fetch_add(keys, std::memory_order_relaxed);
+        return 0;
+    }
+
+    // Producer side: a message that must not be shed (commands); only counted.
+    void       admit() { if (m_capacity > 0) m_size.fetch_add(1, std::memory_order_relaxed); }
+
+    // Output thread: n admitted messages left the queue.
+    void       release(size_t n) { if (m_capacity > 0) m_size.fetch_sub(n, std::memory_order_relaxed); }
+
+    Stats      getStats() const;
+
+    // 'b'lock, 'd'rop newest or 's'ample. False if none of them.
+    static bool parsePolicy(char c, Policy& policy);
+    static const char* getPolicyName(Policy policy);
+
+private:
+    template<class Running>
+    bool       waitForRoom(Running& running, size_t keys)
+    {
+        m_blocked.fetch_add(1, std::memory_order_relaxed);
+        for (unsigned waits = 0; ; ++waits)
+        {
+            // A bulk larger than the capacity gets in once the queue is empty.
+            size_t size = m_size.load(std::memory_order_relaxed);
+            if ((size + keys <= m_capacity || size == 0) &&
+                m_size.compare_exchange_weak(size, size + keys, std::memory_order_relaxed))
+                return true;
+
+            if (! running())
+            {
+                m_dropped.fetch_add(keys, std::memory_order_relaxed);
+                return false;
+            }
+
+            pause(waits);
+        }
+    }
+
+    bool        sampleOne(size_t keys);
+    static void pause(unsigned waits);
+
+    size_t                m_capacity;
+    size_t                m_threshold; // admission without policy below this size
+    Policy                m_policy;
+    unsigned              m_sampleRate;
+    std::atomic<size_t>   m_size;
+    std::atomic<uint64_t> m_sampleTicket;
+    std::atomic<uint64_t> m_dropped;
+    std::atomic<uint64_t> m_sampled;
+    std::atomic<uint64_t> m_blocked;
+};
+
+#endif // OVERLOADGUARD_H
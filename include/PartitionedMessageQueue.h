@@ -0,0 +1,58 @@
+#ifndef PARTITIONEDMESSAGEQUEUE_H
+#define PARTITIONEDMESSAGEQUEUE_H
+
+/**
+ * @file PartitionedMessageQueue.h
+ * @brief PartitionedMessageQueue interface.
+ *        K ThreadedMessageQueue partitions, each one with its own consumer thread. addKey
+ *        messages are routed by the hash of their key, so every key is always applied by the
+ *        same consumer thread. Consuming into a ShardedMapManager of K shards, partition i only
+ *        ever touches shard i (same routing): consumers never contend for a lock.
+ *        A bulk of keys (addKeys) is split into one bulk per partition, record lines copied as
+ *        they are. A partition may shed its own part: pushKeys() returns the records queued, and
+ *        push() is true when any part is.
+ *        Other commands go to partition 0.
+ * @author Guillermo M. Paris
+ * @date 2026-10-18
+ */
+
+#include <string>
+#include <vector>
+#include "IMapManager.h"
+#include "IQueue.h"
+#include "Message.h"
+#include "ThreadedMessageQueue.h"
+
+class PartitionedMessageQueue : public IQueue<Message*, IMapManager*>
+{
+public:
+    // initialSize is split among the partitions.
+    PartitionedMessageQueue(unsigned int partitions, size_t initialSize, size_t batchSize = DEFAULT_KEY_BATCH_SIZE);
+    ~PartitionedMessageQueue();
+
+    PartitionedMessageQueue(const PartitionedMessageQueue&) = delete;
+    PartitionedMessageQueue& operator = (const PartitionedMessageQueue&) = delete;
+
+    virtual void setConsumer(IMapManager* pMgr); // every partition consumes into pMgr
+    virtual bool isEmpty();
+    virtual bool start();
+    virtual bool stop();
+    virtual bool push(Message* pMsg);
+    virtual size_t pushKeys(Message* pMsg, size_t keys);
+    virtual OverloadGuard::Stats getOverloadStats(); // summed over the partitions
+    virtual QueueStats getQueueStats();              // histograms merged over the partitions
+
+    // Before start(). The capacity is split among the partitions.
+    void         setOverloadPolicy(size_t capacity, OverloadGuard::Policy policy,
+                                   unsigned sampleRate = DEFAULT_OVERLOAD_SAMPLE_RATE);
+
+    unsigned int getPartitionNumber() const { return unsigned(m_partitions.size()); }
+    unsigned int getPartition(const std::string& key) const;
+
+private:
+    size_t       pushBulk(Message* pMsg); // records queued
+
+    std::vector<ThreadedMessageQueue*> m_partitions;
+};
+
+#endif // PARTITIONEDMESSAGEQUEUE_H
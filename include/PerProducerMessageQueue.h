@@ -0,0 +1,83 @@
+#ifndef PERPRODUCERMESSAGEQUEUE_H
+#define PERPRODUCERMESSAGEQUEUE_H
+
+/**
+ * @file PerProducerMessageQueue.h
+ * @brief PerProducerMessageQueue interface.
+ *        A Queue + output thread for messaging to IMapManager derived objects, made of one wait
+ *        free SpscRing per producer thread instead of one queue shared by all of them: producers
+ *        never write a cache line written by another producer.
+ *        A thread gets its ring on its first push (a ring left by an ended thread is reused).
+ *        The output thread visits the rings round robin, taking up to one batch from each.
+ *        Messages of one producer keep their order; there is no order among producers.
+ *        push() waits for room when the ring of the thread is full (block overload policy).
+ * @author Guillermo M. Paris
+ * @date 2026-10-18
+ */
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "ConsumerParker.h"
+#include "IMapManager.h"
+#include "IQueue.h"
+#include "Message.h"
+#include "SpscRing.h"
+
+#define PRODUCER_RING_SLOTS  4096 // default capacity of every producer ring
+#define PRODUCER_RINGS_MAX   1024 // producer threads pushing at the same time
+
+class PerProducerMessageQueue : public IQueue<Message*, IMapManager*>
+{
+public:
+    PerProducerMessageQueue(size_t ringSlots = PRODUCER_RING_SLOTS, size_t batchSize = DEFAULT_KEY_BATCH_SIZE);
+    ~PerProducerMessageQueue();
+
+    PerProducerMessageQueue(const PerProducerMessageQueue&) = delete;
+    PerProducerMessageQueue& operator = (const PerProducerMessageQueue&) = delete;
+
+    virtual void setConsumer(IMapManager* pMgr) { m_consumer = pMgr; }
+    virtual bool isEmpty();
+    virtual bool start();
+    virtual bool stop();
+    // Ignored (and the message deleted) when the queue is not running. Throws std::length_error
+    // from a new producer thread beyond PRODUCER_RINGS_MAX threads.
+    virtual bool push(Message* pMsg);
+
+    size_t       getRingNumber() const { return m_ringNumber.load(std::memory_order_acquire); }
+    size_t       getBatchSize() const { return m_batchSize; }
+
+private:
+    struct Ring : public SpscRing<Message*>
+    {
+        explicit Ring(size_t slots) : SpscRing<Message*>(slots), owned(true) {}
+
+        std::atomic<bool> owned; // by a running producer thread
+    };
+
+    class ProducerRings;
+
+    Ring*   ring();           // the ring of the calling thread
+    std::shared_ptr<Ring> registerRing();
+
+    void    run();
+    // Up to one batch of the messages of the ring. Returns how many were taken.
+    size_t  drain(Ring& ring, std::vector<Message*>& messages, std::vector<KeyEvent>& events);
+    void    flushKeys(std::vector<Message*>& messages, std::vector<KeyEvent>& events);
+
+    const uint64_t          m_id; // never reused, unlike addresses
+    size_t                  m_ringSlots;
+    size_t                  m_batchSize;
+    std::atomic<Ring*>      m_rings[PRODUCER_RINGS_MAX];
+    std::atomic<size_t>     m_ringNumber;
+    std::vector<std::shared_ptr<Ring>> m_owners; // shared with the producer threads
+    std::mutex              m_registerMutex;
+    std::atomic<bool>       m_running;
+    IMapManager*            m_consumer;
+    ConsumerParker          m_parker;
+    std::thread             m_poper;
+};
+
+#endif // PERPRODUCERMESSAGEQUEUE_H
@@ -0,0 +1,221 @@
+#ifndef SEGMENTEDQUEUE_H
+#define SEGMENTEDQUEUE_H
+
+/**
+ * @file SegmentedQueue.h
+ * @brief SegmentedQueue template.
+ *        Unbounded lock free queue for many producer threads and one consumer thread, stored
+ *        in fixed size segments mapped on demand. A producer claims a ticket with one atomic
+ *        add and stores its value in the slot of that ticket; the first producer to reach a
+ *        new segment installs it in a directory indexed by segment number. The consumer reads
+ *        the slots in ticket order and retires every segment it has drained into a spare list
+ *        that producers take new segments from. releaseIdleSegments() unmaps the spares
+ *        beyond a reserve, returning their memory to the system: nothing is preallocated, a
+ *        burst maps what it needs and an idle queue gives it back.
+ *        A retired segment is never touched by a producer again: the producers of segment n
+ *        wait until segment n - QUEUE_SEGMENT_DIRECTORY is retired, so the queue holds up to
+ *        QUEUE_SEGMENT_SLOTS * QUEUE_SEGMENT_DIRECTORY values (134M by default) before a push
+ *        waits.
+ *        T must be trivially copyable, T() marks a free slot and must not be pushed.
+ * @author Guillermo M. Paris
+ * @date 2026-10-18
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
+#include <sys/mman.h>
+
+#ifndef CACHE_LINE_SIZE
+#define CACHE_LINE_SIZE 64
+#endif
+
+#define QUEUE_SEGMENT_BITS      15   // 32768 slots per segment: 256 KiB of pointers
+#define QUEUE_SEGMENT_DIRECTORY 4096 // segments the queue may hold at once
+
+template<class T>
+class SegmentedQueue
+{
+public:
+    static constexpr std::size_t ms_SegmentSlots = std::size_t(1) << QUEUE_SEGMENT_BITS;
+    static constexpr std::size_t ms_DirectorySize = QUEUE_SEGMENT_DIRECTORY;
+
+    struct Stats
+    {
+        uint64_t mapped;   // segments mapped now: in use and spare
+        uint64_t spare;    // drained segments kept for the next ones
+        uint64_t released; // segments returned to the system so far
+    };
+
+    // Up to reserveSlots (one segment at least) of spare segments survive releaseIdleSegments().
+    explicit SegmentedQueue(std::size_t reserveSlots = 0)
+        : m_reserve((reserveSlots + ms_SegmentSlots - 1) / ms_SegmentSlots)
+        , m_mapped(0), m_spareCount(0), m_released(0)
+        , m_tail(0), m_headSegment(0), m_head(0), m_pHead(nullptr)
+    {
+        if (m_reserve == 0)
+            m_reserve = 1;
+
+        for (std::atomic<Segment*>& entry : m_directory)
+            entry.store(nullptr, std::memory_order_relaxed);
+    }
+
+    ~SegmentedQueue()
+    {
+        for (std::atomic<Segment*>& entry : m_directory)
+            if (Segment* pSegment = entry.load(std::memory_order_relaxed))
+                unmap(pSegment);
+
+        for (Segment* pSegment : m_spares)
+            unmap(pSegment);
+    }
+
+    SegmentedQueue(const SegmentedQueue&) = delete;
+    SegmentedQueue& operator = (const SegmentedQueue&) = delete;
+
+    // Any producer thread. Lock free but while a new segment is mapped.
+    void push(const T& value)
+    {
+        const uint64_t ticket = m_tail.fetch_add(1, std::memory_order_relaxed);
+        const uint64_t number = ticket >> QUEUE_SEGMENT_BITS;
+        while (number >= m_headSegment.load(std::memory_order_acquire) + ms_DirectorySize)
+            std::this_thread::yield(); // the directory is full: wait for the consumer
+
+        std::atomic<Segment*>& entry = m_directory[number & (ms_DirectorySize - 1)];
+        Segment* pSegment = entry.load(std::memory_order_acquire);
+        if (pSegment == nullptr)
+        {
+            Segment* pNew = acquireSegment();
+            if (entry.compare_exchange_strong(pSegment, pNew, std::memory_order_acq_rel, std::memory_order_acquire))
+                pSegment = pNew;
+            else
+                retire(pNew); // installed by another producer of this segment
+        }
+
+        pSegment->slots[ticket & (ms_SegmentSlots - 1)].store(value, std::memory_order_release);
+    }
+
+    // Consumer thread. False when empty, or when the next value is claimed but not stored yet.
+    bool pop(T& value)
+    {
+        const uint64_t head = m_head.load(std::memory_order_relaxed);
+        if (m_pHead == nullptr)
+        {
+            m_pHead = m_directory[(head >> QUEUE_SEGMENT_BITS) & (ms_DirectorySize - 1)].load(std::memory_order_acquire);
+            if (m_pHead == nullptr)
+                return false;
+        }
+
+        std::atomic<T>& slot = m_pHead->slots[head & (ms_SegmentSlots - 1)];
+        value = slot.load(std::memory_order_acquire);
+        if (value == T())
+            return false;
+
+        slot.store(T(), std::memory_order_relaxed); // spares are handed over clean
+        m_head.store(head + 1, std::memory_order_release);
+
+        if ((head & (ms_SegmentSlots - 1)) == ms_SegmentSlots - 1) // drained: retire it
+        {
+            const uint64_t number = head >> QUEUE_SEGMENT_BITS;
+            m_directory[number & (ms_DirectorySize - 1)].store(nullptr, std::memory_order_relaxed);
+            retire(m_pHead);
+            m_pHead = nullptr;
+            m_headSegment.store(number + 1, std::memory_order_release);
+        }
+
+        return true;
+    }
+
+    // Any thread: a snapshot.
+    bool empty() const
+    {
+        return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire);
+    }
+
+    // Any thread. Spares beyond the reserve.
+    bool hasIdleSegments() const { return m_spareCount.load(std::memory_order_relaxed) > m_reserve; }
+
+    // Any thread, usually the consumer once the queue has been idle for a while.
+    void releaseIdleSegments()
+    {
+        std::vector<Segment*> idle;
+        {
+            std::lock_guard<std::mutex> lock(m_sparesMutex);
+            while (m_spares.size() > m_reserve)
+            {
+                idle.push_back(m_spares.back());
+                m_spares.pop_back();
+            }
+            m_spareCount.store(m_spares.size(), std::memory_order_relaxed);
+        }
+
+        for (Segment* pSegment : idle)
+            unmap(pSegment);
+        m_released.fetch_add(idle.size(), std::memory_order_relaxed);
+    }
+
+    Stats getStats() const
+    {
+        return {m_mapped.load(std::memory_order_relaxed), m_spareCount.load(std::memory_order_relaxed),
+                m_released.load(std::memory_order_relaxed)};
+    }
+
+private:
+    struct Segment
+    {
+        std::atomic<T> slots[ms_SegmentSlots];
+    };
+
+    Segment* acquireSegment()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_sparesMutex);
+            if (! m_spares.empty())
+            {
+                Segment* pSegment = m_spares.back();
+                m_spares.pop_back();
+                m_spareCount.store(m_spares.size(), std::memory_order_relaxed);
+                return pSegment;
+            }
+        }
+
+        // Anonymous pages: zeroed (T() slots) and only resident once written.
+        void* p = mmap(nullptr, sizeof(Segment), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED)
+            throw std::bad_alloc();
+
+        m_mapped.fetch_add(1, std::memory_order_relaxed);
+        return static_cast<Segment*>(p);
+    }
+
+    void retire(Segment* pSegment)
+    {
+        std::lock_guard<std::mutex> lock(m_sparesMutex);
+        m_spares.push_back(pSegment);
+        m_spareCount.store(m_spares.size(), std::memory_order_relaxed);
+    }
+
+    void unmap(Segment* pSegment)
+    {
+        munmap(pSegment, sizeof(Segment));
+        m_mapped.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    std::size_t                                       m_reserve; // spare segments kept when idle
+    std::mutex                                        m_sparesMutex;
+    std::vector<Segment*>                             m_spares;
+    std::atomic<std::size_t>                          m_mapped;
+    std::atomic<std::size_t>                          m_spareCount;
+    std::atomic<uint64_t>                             m_released;
+    std::atomic<Segment*>                             m_directory[QUEUE_SEGMENT_DIRECTORY];
+    alignas(CACHE_LINE_SIZE) std::atomic<uint64_t>    m_tail;        // next ticket, producers
+    alignas(CACHE_LINE_SIZE) std::atomic<uint64_t>    m_headSegment; // first segment not retired
+    alignas(CACHE_LINE_SIZE) std::atomic<uint64_t>    m_head;        // next ticket to pop, consumer
+    Segment*                                          m_pHead;       // segment of m_head, consumer
+};
+
+#endif // SEGMENTEDQUEUE_H
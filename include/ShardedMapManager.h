@@ -0,0 +1,76 @@
+#ifndef SHARDEDMAPMANAGER_H
+#define SHARDEDMAPMANAGER_H
+
+/**
+ * @file ShardedMapManager.h
+ * @brief ShardedMapManager interface.
+ *        An IMapManager made of several hash partitioned MapManager shards, each one with
+ *        its own lock, so writers on different shards never serialize on the same mutex.
+ *        The rankings of every shard are merged on demand into one global ranking. isHotKey()
+ *        only compares the frequency of the key with the M-th highest one of all the shards,
+ *        cached and recomputed once after every batch of updates.
+ * @author Guillermo M. Paris
+ * @date 2026-10-18
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "BackendDictionary.h"
+#include "MapManager.h"
+
+#define DEFAULT_SHARD_NUMBER 8
+
+class ShardedMapManager : public IMapManager
+{
+public:
+    static const unsigned short ms_DefaultShardNumber = DEFAULT_SHARD_NUMBER;
+
+    ShardedMapManager();
+    ShardedMapManager(unsigned int shards, unsigned int n, unsigned int m = 0, unsigned int ll = 0);
+    ~ShardedMapManager();
+
+    virtual void       addOrUpdateKey(const std::string& key, const std::string& url, unsigned int port);
+    virtual void       addOrUpdateKeys(const KeyEvent* pEvents, std::size_t n);
+    virtual void       setTopKeyReportBaseSize(unsigned short base);
+    virtual unsigned   getTopKeyReportBaseSize() {return m_baseReportElementNumber;}  // getN();
+    virtual unsigned   getTopKeyReportActualSize();
+    virtual unsigned   getTopKeyReportMaxSize() {return m_maxReportElementNumber;} // getM();
+    virtual unsigned   getTotalKeyNumber();
+    virtual void       getTopHotkeys(KeyFrequencyVector& vec);
+    virtual bool       isHotKey(const std::string& key);
+    virtual bool       backupRequest(const std::string& keyFilename, const std::string& freqFilename);
+    virtual bool       restoreRequest(const std::string& keyFilename, const std::string& freqFilename);
+
+    unsigned int       getShardNumber() {return m_shards.size();}
+    unsigned int       getShardIndex(const std::string& key);
+    unsigned int       getShardIndex(std::size_t keyHash); // std::hash of the key
+    BackendDictionary& getBackends() {return m_backends;}
+    void               purge(unsigned short n); // purge n on every shard /  N <= n <= M
+    void               zap();
+
+private:
+    // Global ranking (up to count elements, highest frequency first) merged from all the shards.
+    void               mergeRankings(KeyFrequencyVector& vec, unsigned int count);
+    // Sets m_hotThreshold from the published rankings of the shards, if it is still stale.
+    void               refreshHotThreshold();
+
+    static const char  ms_FieldSeparator = FIELD_SEPARATOR;
+
+    // Verbosity or log level : 0:warnings & errors,  1:info,  2:trace,  3:debug
+    const Verbosity    m_verbosity;
+
+    unsigned short     m_baseReportElementNumber; // N = DEFAULT_TOPKEY_REPORTSIZE
+    unsigned short     m_maxReportElementNumber;  // M = MAX_TOPKEY_REPORTSIZE
+    BackendDictionary  m_backends; // shared by every shard
+    std::vector<MapManager*> m_shards;
+    // M-th highest frequency of the global ranking (0 while it has fewer than M keys): a key
+    // ranked by its shard is hot when it reaches it. Ties with the M-th key are hot too.
+    std::atomic<uint64_t> m_hotThreshold;
+    std::atomic<bool>     m_hotThresholdStale; // set after every update, cleared by a refresh
+    std::mutex            m_hotThresholdMutex; // one refresh at a time
+};
+
+#endif // SHARDEDMAPMANAGER_H
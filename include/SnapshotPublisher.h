@@ -0,0 +1,125 @@
+#ifndef SNAPSHOTPUBLISHER_H
+#define SNAPSHOTPUBLISHER_H
+
+/**
+ * @file SnapshotPublisher.h
+ * @brief SnapshotPublisher template.
+ *        Read-copy-update publication of an immutable value for one writer and many readers.
+ *        The value lives in a small fixed pool of buffers. The writer fills a buffer that is
+ *        neither the current one nor held by any reader, then swaps the current pointer.
+ *        A reader pins the current buffer by raising its reader count and checking that it
+ *        is still the current one, so readers never take a lock nor wait for the writer, and
+ *        a buffer is only reused once every reader of it is gone (per buffer reference
+ *        counts play the role of hazard pointers). Nothing is allocated after construction.
+ * @author Guillermo M. Paris
+ * @date 2026-10-18
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <thread>
+
+#define SNAPSHOT_BUFFER_NUMBER 4
+
+template<class T, std::size_t Buffers = SNAPSHOT_BUFFER_NUMBER>
+class SnapshotPublisher
+{
+    static_assert(Buffers >= 2, "the writer needs a spare buffer");
+
+    struct Buffer
+    {
+        T                     value;
+        std::atomic<unsigned> readers{0};
+    };
+
+public:
+    // Pins the current snapshot for the lifetime of the guard.
+    class ReadGuard
+    {
+    public:
+        explicit ReadGuard(const SnapshotPublisher& publisher) : m_pBuffer(publisher.pin()) {}
+        ~ReadGuard() { m_pBuffer->readers.fetch_sub(1, std::memory_order_release); }
+
+        ReadGuard(const ReadGuard&) = delete;
+        ReadGuard& operator = (const ReadGuard&) = delete;
+
+        const T& operator * () const  { return m_pBuffer->value; }
+        const T* operator -> () const { return &m_pBuffer->value; }
+
+    private:
+        Buffer* m_pBuffer;
+    };
+
+    SnapshotPublisher() : m_pCurrent(&m_buffers[0]), m_pWriting(nullptr) {}
+
+    SnapshotPublisher(const SnapshotPublisher&) = delete;
+    SnapshotPublisher& operator = (const SnapshotPublisher&) = delete;
+
+    // Calls f(T&) on every buffer. Only before readers or writers start (e.g. to reserve memory).
+    template<class F>
+    void initialize(F&& f)
+    {
+        for (Buffer& b : m_buffers)
+            f(b.value);
+    }
+
+    // Writer side: a buffer to fill from scratch. Only one writer at a time (caller serializes).
+    T& beginWrite()
+    {
+        Buffer* pCurrent = m_pCurrent.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            for (Buffer& b : m_buffers)
+            {
+                if (&b != pCurrent && b.readers.load(std::memory_order_seq_cst) == 0)
+                {
+                    m_pWriting = &b;
+                    return b.value;
+                }
+            }
+
+            std::this_thread::yield(); // every spare buffer is pinned by a slow reader
+        }
+    }
+
+    // Writer side: makes the buffer returned by beginWrite() the current snapshot.
+    void commit()
+    {
+        m_pCurrent.store(m_pWriting, std::memory_order_seq_cst);
+        m_pWriting = nullptr;
+    }
+
+    // Writer side: waits until no reader holds any snapshot older than the current one, so
+    // whatever only those snapshots referenced can be released (RCU grace period).
+    void synchronize() const
+    {
+        const Buffer* pCurrent = m_pCurrent.load(std::memory_order_seq_cst);
+        for (const Buffer& b : m_buffers)
+        {
+            while (&b != pCurrent && b.readers.load(std::memory_order_seq_cst) != 0)
+                std::this_thread::yield();
+        }
+    }
+
+private:
+    Buffer* pin() const
+    {
+        for (;;)
+        {
+            Buffer* pBuffer = m_pCurrent.load(std::memory_order_seq_cst);
+            pBuffer->readers.fetch_add(1, std::memory_order_seq_cst);
+
+            // Still current: the writer can not have started refilling it.
+            if (m_pCurrent.load(std::memory_order_seq_cst) == pBuffer)
+                return pBuffer;
+
+            pBuffer->readers.fetch_sub(1, std::memory_order_release);
+        }
+    }
+
+    Buffer               m_buffers[Buffers];
+    std::atomic<Buffer*> m_pCurrent;
+    Buffer*              m_pWriting;
+};
+
+#endif // SNAPSHOTPUBLISHER_H
@@ -0,0 +1,86 @@
+#ifndef SPACESAVINGMANAGER_H
+#define SPACESAVINGMANAGER_H
+
+/**
+ * @file SpaceSavingManager.h
+ * @brief SpaceSavingManager interface.
+ *        Approximate heavy hitter tracker (Space-Saving algorithm, Metwally et al.) with a fixed
+ *        number of counters, so memory stays constant whatever the number of distinct keys is.
+ *        When every counter is taken, a new key replaces the key with the lowest count, and
+ *        inherits that count as its overestimation error. For every monitored key:
+ *            count - error  <=  true frequency  <=  count
+ *        and any key with a true frequency above streamLength / counters is always monitored.
+ * @author Guillermo M. Paris
+ * @date 2026-10-18
+ */
+
+#include <iosfwd>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "MapManager.h" // report size and field separator defaults
+#include "StreamSummary.h"
+
+#define DEFAULT_SPACESAVING_COUNTERS 100000
+
+class SpaceSavingManager : public IMapManager
+{
+public:
+    struct Monitored
+    {
+        std::string   key;
+        std::string   url;
+        unsigned int  port = 0;
+        unsigned long error = 0; // overestimation inherited from the replaced key
+    };
+
+    using Summary = StreamSummary<Monitored>;
+    using MonitoredIndex = std::unordered_map<std::string, Summary::Node*>;
+
+    static const unsigned int ms_DefaultCounters = DEFAULT_SPACESAVING_COUNTERS;
+
+    SpaceSavingManager(unsigned int counters, unsigned int n, unsigned int m = 0, unsigned int ll = 0);
+
+    virtual void       addOrUpdateKey(const std::string& key, const std::string& url, unsigned int port);
+    virtual void       addOrUpdateKeys(const KeyEvent* pEvents, std::size_t n);
+    virtual void       setTopKeyReportBaseSize(unsigned short base);
+    virtual unsigned   getTopKeyReportBaseSize() {return m_baseReportElementNumber;}  // getN();
+    virtual unsigned   getTopKeyReportActualSize();
+    virtual unsigned   getTopKeyReportMaxSize() {return m_maxReportElementNumber;} // getM();
+    virtual unsigned   getTotalKeyNumber(); // monitored keys, never above the counter number
+    virtual void       getTopHotkeys(KeyFrequencyVector& vec); // also fills KeyFrequency::error
+    virtual bool       isHotKey(const std::string& key);
+    virtual bool       backupRequest(const std::string& keyFilename, const std::string& freqFilename);
+    virtual bool       restoreRequest(const std::string& keyFilename, const std::string& freqFilename);
+
+    // True only when the key is in the top M even in the worst case allowed by the error bounds.
+    bool               isGuaranteedHotKey(const std::string& key);
+    // Highest possible overestimation of any key: the lowest counter when all of them are taken.
+    unsigned long      getMaxError();
+    // Total of reported keys. It always equals the sum of every counter.
+    unsigned long      getStreamLength();
+    unsigned int       getCounterNumber() {return m_summary.capacity();}
+    void               zap();
+
+private:
+    // True if pNode is among the first m elements of the ranking. *pNext gets the count of the
+    // element right after them (0 if none).
+    bool               isInTop(const Summary::Node* pNode, unsigned int m, unsigned long* pNext = nullptr);
+    // Weighted Space-Saving update. Caller holds m_mutex.
+    void               update(const std::string& key, const std::string& url, unsigned int port,
+                              unsigned long weight, unsigned long error);
+
+    static const char  ms_FieldSeparator = FIELD_SEPARATOR;
+
+    // Verbosity or log level : 0:warnings & errors,  1:info,  2:trace,  3:debug
+    const Verbosity    m_verbosity;
+
+    unsigned short     m_baseReportElementNumber; // N
+    unsigned short     m_maxReportElementNumber;  // M
+    unsigned long      m_streamLength;
+    Summary            m_summary;
+    MonitoredIndex     m_index;
+    std::mutex         m_mutex;
+};
+
+#endif // SPACESAVINGMANAGER_H
@@ -0,0 +1,92 @@
+#ifndef SPSCRING_H
+#define SPSCRING_H
+
+/**
+ * @file SpscRing.h
+ * @brief SpscRing template.
+ *        Bounded wait free ring for exactly one producer thread and one consumer thread.
+ *        The producer only writes the tail and the consumer only writes the head, each one on
+ *        its own cache line, and each side keeps a private copy of the other index that is only
+ *        refreshed when the ring looks full (producer) or empty (consumer).
+ * @author Guillermo M. Paris
+ * @date 2026-10-18
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+#ifndef CACHE_LINE_SIZE
+#define CACHE_LINE_SIZE 64
+#endif
+
+template<class T>
+class SpscRing
+{
+public:
+    // capacity is rounded up to a power of 2.
+    explicit SpscRing(std::size_t capacity)
+        : m_slots(roundUp(capacity)), m_mask(m_slots.size() - 1)
+        , m_tail(0), m_cachedHead(0), m_head(0), m_cachedTail(0) {}
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator = (const SpscRing&) = delete;
+
+    std::size_t capacity() const { return m_slots.size(); }
+
+    // Producer side. False when full.
+    bool push(const T& value)
+    {
+        const std::size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_cachedHead == m_slots.size())
+        {
+            m_cachedHead = m_head.load(std::memory_order_acquire);
+            if (tail - m_cachedHead == m_slots.size())
+                return false;
+        }
+
+        m_slots[tail & m_mask] = value;
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side. False when empty.
+    bool pop(T& value)
+    {
+        const std::size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_cachedTail)
+        {
+            m_cachedTail = m_tail.load(std::memory_order_acquire);
+            if (head == m_cachedTail)
+                return false;
+        }
+
+        value = m_slots[head & m_mask];
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Any thread: a snapshot.
+    bool empty() const
+    {
+        return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire);
+    }
+
+private:
+    static std::size_t roundUp(std::size_t n)
+    {
+        std::size_t capacity = 1;
+        while (capacity < n)
+            capacity <<= 1;
+        return capacity;
+    }
+
+    std::vector<T>                                   m_slots;
+    const std::size_t                                m_mask;
+    alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> m_tail;       // written by the producer
+    std::size_t                                      m_cachedHead; // producer copy of m_head
+    alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> m_head;       // written by the consumer
+    std::size_t                                      m_cachedTail; // consumer copy of m_tail
+};
+
+#endif // SPSCRING_H
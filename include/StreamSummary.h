@@ -0,0 +1,231 @@
+#ifndef STREAMSUMMARY_H
+#define STREAMSUMMARY_H
+
+/**
+ * @file StreamSummary.h
+ * @brief StreamSummary template.
+ *        Fixed capacity "stream summary" counter layout (Metwally et al.): a doubly linked
+ *        list of buckets in ascending count order, each bucket holding the doubly linked list
+ *        of the items sharing its count, and every item pointing back to its bucket.
+ *        Incrementing an item moves it to the next bucket, the minimum is the head bucket
+ *        and the top of the ranking is read backwards from the tail bucket.
+ *        Items and buckets live in arrays preallocated at construction: nothing is allocated
+ *        afterwards.
+ * @author Guillermo M. Paris
+ * @date 2026-10-18
+ */
+
+#include <cstddef>
+#include <vector>
+
+template<class Item>
+class StreamSummary
+{
+public:
+    struct Bucket;
+
+    struct Node
+    {
+        Item    item;
+        Bucket* bucket = nullptr;
+        Node*   prev = nullptr;
+        Node*   next = nullptr;   // also links the free list
+
+        unsigned long count() const { return bucket->count; }
+    };
+
+    struct Bucket
+    {
+        unsigned long count = 0;
+        Node*   first = nullptr;  // oldest item having this count
+        Node*   last = nullptr;   // newest item having this count
+        Bucket* prev = nullptr;
+        Bucket* next = nullptr;   // also links the free list
+    };
+
+    explicit StreamSummary(std::size_t capacity)
+        : m_nodes(capacity), m_buckets(capacity + 1)
+    {
+        clear();
+    }
+
+    StreamSummary(const StreamSummary&) = delete;
+    StreamSummary& operator = (const StreamSummary&) = delete;
+
+    std::size_t size() const     { return m_size; }
+    std::size_t capacity() const { return m_nodes.size(); }
+    bool        empty() const    { return m_size == 0; }
+    bool        full() const     { return m_size == m_nodes.size(); }
+
+    // The oldest item among the ones having the lowest count.
+    Node*         minNode() const  { return m_head ? m_head->first : nullptr; }
+    unsigned long minCount() const { return m_head ? m_head->count : 0; }
+    unsigned long maxCount() const { return m_tail ? m_tail->count : 0; }
+
+    // Takes a free item with the given count; nullptr when full. The caller fills node->item.
+    Node* insert(unsigned long count)
+    {
+        if (m_freeNodes == nullptr) return nullptr;
+
+        Node* n = m_freeNodes;
+        m_freeNodes = n->next;
+
+        Bucket* b = m_head;
+        if (m_tail != nullptr && count >= m_tail->count) // O(1) when filled in ascending order
+        {
+            b = (count == m_tail->count ? m_tail : nullptr);
+        }
+        else
+        {
+            while (b != nullptr && b->count < count)
+                b = b->next;
+        }
+
+        if (b == nullptr || b->count != count)
+            b = newBucketBefore(b, count);
+
+        append(b, n);
+        ++m_size;
+        return n;
+    }
+
+    // Moves the item to the bucket of count + by (new items go last in their bucket).
+    void increment(Node* n, unsigned long by = 1)
+    {
+        if (by == 0) return;
+
+        Bucket* from = n->bucket;
+        const unsigned long target = from->count + by;
+
+        Bucket* to = from->next;
+        while (to != nullptr && to->count < target)
+            to = to->next;
+
+        if (to == nullptr || to->count != target)
+            to = newBucketBefore(to, target);
+
+        unlink(n);
+        append(to, n);
+        if (from->first == nullptr)
+            freeBucket(from);
+    }
+
+    void remove(Node* n)
+    {
+        Bucket* from = n->bucket;
+        unlink(n);
+        if (from->first == nullptr)
+            freeBucket(from);
+
+        n->bucket = nullptr;
+        n->next = m_freeNodes;
+        m_freeNodes = n;
+        --m_size;
+    }
+
+    void clear()
+    {
+        m_head = m_tail = nullptr;
+        m_size = 0;
+        m_freeNodes = nullptr;
+        for (std::size_t i = m_nodes.size(); i > 0; --i)
+        {
+            m_nodes[i - 1].bucket = nullptr;
+            m_nodes[i - 1].next = m_freeNodes;
+            m_freeNodes = &m_nodes[i - 1];
+        }
+
+        m_freeBuckets = nullptr;
+        for (std::size_t i = m_buckets.size(); i > 0; --i)
+        {
+            m_buckets[i - 1].next = m_freeBuckets;
+            m_freeBuckets = &m_buckets[i - 1];
+        }
+    }
+
+    // f(Node&) is called from the highest count down (newest first among equal counts),
+    // until it returns false.
+    template<class F>
+    void forEachDescending(F&& f)
+    {
+        for (Bucket* b = m_tail; b != nullptr; )
+        {
+            Bucket* prevBucket = b->prev;
+            for (Node* n = b->last; n != nullptr; )
+            {
+                Node* prev = n->prev; // f may remove n
+                if (! f(*n)) return;
+                n = prev;
+            }
+            b = prevBucket;
+        }
+    }
+
+    // f(Node&) is called from the lowest count up (oldest first among equal counts),
+    // until it returns false.
+    template<class F>
+    void forEachAscending(F&& f)
+    {
+        for (Bucket* b = m_head; b != nullptr; )
+        {
+            Bucket* next = b->next;
+            for (Node* n = b->first; n != nullptr; )
+            {
+                Node* following = n->next; // f may remove n
+                if (! f(*n)) return;
+                n = following;
+            }
+            b = next;
+        }
+    }
+
+private:
+    Bucket* newBucketBefore(Bucket* next, unsigned long count)
+    {
+        Bucket* b = m_freeBuckets;
+        m_freeBuckets = b->next;
+
+        b->count = count;
+        b->first = b->last = nullptr;
+        b->next = next;
+        b->prev = (next != nullptr ? next->prev : m_tail);
+        (b->prev != nullptr ? b->prev->next : m_head) = b;
+        (next != nullptr ? next->prev : m_tail) = b;
+        return b;
+    }
+
+    void freeBucket(Bucket* b)
+    {
+        (b->prev != nullptr ? b->prev->next : m_head) = b->next;
+        (b->next != nullptr ? b->next->prev : m_tail) = b->prev;
+        b->next = m_freeBuckets;
+        m_freeBuckets = b;
+    }
+
+    static void append(Bucket* b, Node* n)
+    {
+        n->bucket = b;
+        n->next = nullptr;
+        n->prev = b->last;
+        (b->last != nullptr ? b->last->next : b->first) = n;
+        b->last = n;
+    }
+
+    static void unlink(Node* n)
+    {
+        Bucket* b = n->bucket;
+        (n->prev != nullptr ? n->prev->next : b->first) = n->next;
+        (n->next != nullptr ? n->next->prev : b->last) = n->prev;
+        n->prev = n->next = nullptr;
+    }
+
+    std::vector<Node>   m_nodes;
+    std::vector<Bucket> m_buckets;
+    Node*               m_freeNodes = nullptr;
+    Bucket*             m_freeBuckets = nullptr;
+    Bucket*             m_head = nullptr; // lowest count
+    Bucket*             m_tail = nullptr; // highest count
+    std::size_t         m_size = 0;
+};
+
+#endif // STREAMSUMMARY_H
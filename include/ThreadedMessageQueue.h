@@ -5,44 +5,110 @@
  * @file ThreadedMessageQueue.h
  * @brief ThreadedMessageQueue interface.
  *        A Queue + output thread for messaging to IMapManager derived objects.
+ *        Messages are stored in a SegmentedQueue: segments are mapped as bursts need them and
+ *        the spare ones are returned to the system once the queue has been idle for
+ *        QUEUE_IDLE_RELEASE_MILLISECONDS.
+ *        When the queue gets empty the output thread spins for a while (adaptive, bounded), then
+ *        parks on a futex (ConsumerParker). push() only makes the wake up system call when it is
+ *        parked.
+ *        Optionally bounded: the OverloadGuard capacity and policy decide what push() does
+ *        with a key once the queue is full.
+ *        addKeys messages (a bulk of key records) are queued like keys, parsed in place by the
+ *        output thread and counted as their keys by the guard and the depth.
+ *        Other commands than addKey(s) travel in a small control lane that the output thread checks
+ *        before each batch: they are applied ahead of the keys queued before them, whatever the
+ *        backlog.
+ *        push() stamps 1 of every QUEUE_LATENCY_SAMPLE_RATE messages of each producer thread with
+ *        the TickClock (a clock read costs more than the few nSec a message may spend on it); the
+ *        output thread records the enqueue to apply latency of the stamped messages and the queue
+ *        depth of every batch in histograms.
  * @author Guillermo M. Paris
  * @date 2019-12-15
  */
 
+#include <atomic>
 #include <thread>
+#include <vector>
 #include <boost/lockfree/queue.hpp>
+#include "ConsumerParker.h"
 #include "Message.h"
 #include "IMapManager.h"
 #include "IQueue.h"
+#include "SegmentedQueue.h"
 
-#define FIRST_POPING_LATENCY 1 // up to 1 mSec latency in the first pop()
+#define QUEUE_LATENCY_SAMPLE_RATE 8  // power of 2, 1: every message
+#define QUEUE_CONTROL_LANE_SIZE   16 // initial nodes of the control lane
+#define QUEUE_IDLE_RELEASE_MILLISECONDS 1000 // quiet period before the spare segments are unmapped
 
 using BLFMessageQueue = boost::lockfree::queue<Message*>;
+using SegmentedMessageQueue = SegmentedQueue<Message*>;
 
-class ThreadedMessageQueue : public IQueue<Message*, IMapManager*>, private BLFMessageQueue
+class ThreadedMessageQueue : public IQueue<Message*, IMapManager*>, private SegmentedMessageQueue
 {
 public:
-    static const int firstPopLatency; // = FIRST_POPING_LATENCY;
-
-    ThreadedMessageQueue()
-        : BLFMessageQueue(10), m_running(false), m_consumer(nullptr){}
-    ThreadedMessageQueue(size_t initialSize)
-        : BLFMessageQueue(initialSize), m_running(false), m_consumer(nullptr) {}
+    ThreadedMessageQueue() : ThreadedMessageQueue(10) {}
+    // Nothing is preallocated: initialSize is the storage kept mapped while idle (one segment
+    // at least). Up to batchSize consecutive addKey messages are handed to the consumer in one call.
+    ThreadedMessageQueue(size_t initialSize, size_t batchSize = DEFAULT_KEY_BATCH_SIZE)
+        : SegmentedMessageQueue(initialSize), m_control(QUEUE_CONTROL_LANE_SIZE), m_running(false), m_consumer(nullptr)
+        , m_batchSize(batchSize > 0 ? batchSize : 1)
+        , m_idleRelease(std::chrono::milliseconds(QUEUE_IDLE_RELEASE_MILLISECONDS)), m_pushed(0), m_applied(0) {}
 
     ~ThreadedMessageQueue();
 
     virtual void setConsumer(IMapManager* pMgr) { m_consumer = pMgr; }
-    virtual bool isEmpty() { return BLFMessageQueue::empty(); }
+    virtual bool isEmpty() { return SegmentedMessageQueue::empty() && m_control.empty(); }
     virtual bool start();
     virtual bool stop();
-    virtual void push(Message* pMsg);
+    virtual bool push(Message* pMsg);
+    virtual OverloadGuard::Stats getOverloadStats() { return m_guard.getStats(); }
+    virtual QueueStats getQueueStats();
+
+    // Adds the histograms of this queue (latency in TickClock ticks) to the given ones.
+    void         addQueueHistograms(LogLinearHistogram& latency, LogLinearHistogram& depth) const
+                 { latency.add(m_latency); depth.add(m_depth); }
+
+    // Before start(). capacity 0: unbounded.
+    void         setOverloadPolicy(size_t capacity, OverloadGuard::Policy policy,
+                                   unsigned sampleRate = DEFAULT_OVERLOAD_SAMPLE_RATE)
+                 { m_guard.configure(capacity, policy, sampleRate); }
+
+    void         setBatchSize(size_t batchSize) { m_batchSize = (batchSize > 0 ? batchSize : 1); } // before start()
+    size_t       getBatchSize() const { return m_batchSize; }
+
+    void         setIdleRelease(std::chrono::milliseconds quiet) { m_idleRelease = quiet; } // before start()
+    SegmentedMessageQueue::Stats getStorageStats() const { return SegmentedMessageQueue::getStats(); }
 
 private:
     void    run();
+    // Applies the pending control commands.
+    void    applyControl();
+    // Hands the pending addKey messages to the consumer, then deletes them.
+    void    flushKeys(std::vector<Message*>& messages, std::vector<KeyEvent>& events);
+    // Output thread: records the latency of msg if it was stamped.
+    void    recordLatency(Message* pMsg, uint64_t ticks)
+            { if (pMsg->getTicks() != 0) m_latency.record(ticks > pMsg->getTicks() ? ticks - pMsg->getTicks() : 0); }
+    static bool   isKeyMessage(Message* pMsg)
+                  { return pMsg->getCommand() == Message::Command::addKey || pMsg->getCommand() == Message::Command::addKeys; }
+    // Keys a message stands for in the guard and the depth: the records of a bulk.
+    static size_t getKeys(Message* pMsg)
+                  { return pMsg->getCommand() == Message::Command::addKeys ? pMsg->getNumber() : 1; }
+    // Output thread: keys pushed and not applied yet.
+    size_t  getDepth() const
+            { return m_guard.isBounded() ? m_guard.getSize() : size_t(m_pushed.load(std::memory_order_relaxed) - m_applied); }
 
-    bool          m_running;
-    IMapManager*  m_consumer;
-    std::thread   m_poper;
+    BLFMessageQueue       m_control;
+    std::atomic<bool>     m_running;
+    IMapManager*          m_consumer;
+    size_t                m_batchSize;
+    std::chrono::milliseconds m_idleRelease;
+    ConsumerParker        m_parker;
+    OverloadGuard         m_guard;
+    std::atomic<uint64_t> m_pushed;  // unbounded queue only: the guard counts the bounded one
+    uint64_t              m_applied; // output thread
+    LogLinearHistogram    m_latency; // TickClock ticks
+    LogLinearHistogram    m_depth;
+    std::thread           m_poper;
 };
 
 #endif // MESSAGETHREADEDQUEUE_H
@@ -0,0 +1,107 @@
+#ifndef BINARYSERVER_H
+#define BINARYSERVER_H
+
+/**
+ * @file binaryserver.h
+ * @brief BinaryServer interface.
+ *        Compact binary TCP protocol next to the web server, for clients that only report keys
+ *        and ask for hot keys: no HTTP header to parse and no HTML document around a one word
+ *        answer. Every request is a frame: 4 bytes length (network byte order) of the rest,
+ *        1 byte opcode and the payload. Every reply starts with 1 Status byte (the CMD_* result
+ *        of the reporter mapped to a protocol value, or unknownOpcode), then the opcode data:
+ *          keySent       payload key[,url,port]                     reply status
+ *          keysSent      payload key[,url,port[,count]] per line    reply status
+ *          isHotKey      payload key                                reply status, 0 | 1
+ *          isHotKeys     payload one key per line                   reply status, 4 bytes count, 0 | 1 per key
+ *          getTopHotKeys no payload                                 reply status, 4 bytes length, JSON text
+ *          totalKeys     no payload                                 reply status, 4 bytes total
+ *        Frames are served as they arrive: every complete frame in a read is processed in order
+ *        and their replies go out in one write. A frame longer than MAX_FRAME_SIZE closes the
+ *        connection. The requests reach the same reporter functor as the web ones.
+ * @author Guillermo M. Paris
+ * @date 2026-10-18
+ */
+
+#include <boost/asio.hpp>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "icommunicationserver.h"
+#include "verbosity.h"
+
+#define MAX_FRAME_SIZE (1024 * 1024)
+
+class BinaryServer : public ICommunicationServer
+{
+public:
+
+    enum Opcode : uint8_t
+    {
+        keySent = 1, keysSent = 2, isHotKey = 3, isHotKeys = 4, getTopHotKeys = 5, totalKeys = 6
+    };
+
+    // Protocol values, not the CMD_* ones: no reporter result can be taken for another status.
+    enum Status : uint8_t
+    {
+        failed = 0, succeeded = 1, overloaded = 2, unknownCommand = 3, unknownOpcode = 0xFF
+    };
+
+    static const size_t   ms_maxFrameSize = MAX_FRAME_SIZE;
+
+    BinaryServer() = delete;
+
+    BinaryServer(boost::asio::ip::address ip, const unsigned short port,
+                 const unsigned short threads = 1, Verbosity v = 0);
+    ~BinaryServer();
+
+    virtual void  setReporter(IncommingMessageFunctor& f) { m_topMessageFunctor = f; }
+    // Starts accepting on its own threads and returns: it runs next to the blocking web server.
+    virtual bool  start();
+    virtual bool  stop();
+
+    // Frame helpers, shared with the clients.
+    static void appendUint32(std::string& out, uint32_t value)
+    {
+        out += char(value >> 24);
+        out += char(value >> 16);
+        out += char(value >> 8);
+        out += char(value);
+    }
+
+    static uint32_t readUint32(const char* in)
+    {
+        const unsigned char* p = reinterpret_cast<const unsigned char*>(in);
+        return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | uint32_t(p[3]);
+    }
+
+    static void appendFrame(std::string& out, Opcode opcode, std::string_view payload)
+    {
+        appendUint32(out, uint32_t(payload.size() + 1));
+        out += char(opcode);
+        out.append(payload.data(), payload.size());
+    }
+
+
+private:
+
+    class Connection;
+
+    void accept();
+    // Appends the reply of one frame to reply.
+    void processFrame(uint8_t opcode, std::string_view payload, std::string& reply);
+    // Status byte of a reporter result: CMD_UNKNOWN, or any other value, is unknownCommand.
+    static char toStatus(int result);
+
+    // Verbosity or log level : 0:warnings & errors,  1:info,  2:trace,  3:debug
+    const Verbosity                 m_verbosity;
+    const unsigned short            m_nThreads;
+    boost::asio::io_context         m_ioc;
+    boost::asio::ip::tcp::acceptor  m_acceptor;
+    std::vector<std::thread>        m_threads;
+    IncommingMessageFunctor         m_topMessageFunctor;
+};
+
+#endif // BINARYSERVER_H
@@ -10,6 +10,12 @@
 
 #include <functional>
 
+// Results of the incomming message functor.
+const int CMD_UNKNOWN    = -1; // Command not found.
+const int CMD_FAILED     =  0; // Command execution failed.
+const int CMD_SUCCEEDED  =  1; // Command execution successfully completed.
+const int CMD_OVERLOADED =  2; // Command shed by the overload policy: the client should retry later.
+
 class ICommunicationServer
 {
 public:
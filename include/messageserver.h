@@ -12,6 +12,7 @@
  */
 
 #include <functional>
+#include <vector>
 #include "icommunicationserver.h"
 #include "IMapManager.h"
 #include "imessageserver.h"
@@ -20,10 +21,8 @@
 #include "verbosity.h"
 
 class BackupManager;
-
-const int CMD_UNKNOWN   = -1; // Command not found.
-const int CMD_FAILED    =  0; // Command execution failed.
-const int CMD_SUCCEEDED =  1; // Command execution successfully completed.
+class KeyPreAggregator;
+class UdpServer;
 
 class MessageServer : public IMessageServer
 {
@@ -58,13 +57,22 @@ public:
     virtual bool     start();
     virtual bool     stop();
 
+    // Another source of messages (another port or protocol) reporting to this server. Its start()
+    // must not block: it is started ahead of the main communication server, and stopped with it.
+    void             addCommServer(ICommunicationServer* comsrv);
+
 
 private:
 
     friend int main(int, char*[]); // this object is a "light singleton".
+    friend class MessageServerTester; // unit tests: build one and call onMessage()
 
+    // agg: optional, keys are counted there instead of queued one by one.
+    // udp: optional, fire and forget key reports queued by their own threads, started and stopped
+    // with comsrv (see addCommServer), their counters reported by udpStats.
     MessageServer( IMapManager* mgr, IMessageQueue* queue, BackupManager* bkp,
-                   ICommunicationServer* comsrv, Verbosity v = 0);
+                   ICommunicationServer* comsrv, Verbosity v = 0, KeyPreAggregator* agg = nullptr,
+                   UdpServer* udp = nullptr );
 
     static int onMessage(const std::string& inTarget, const std::string& inData, std::string& outData);
 
@@ -73,8 +81,11 @@ private:
     const Verbosity         m_verbosity;
     IMapManager*            m_pMapManager;
     IMessageQueue*          m_pMessageQueue;
+    KeyPreAggregator*       m_pAggregator;
+    UdpServer*              m_pUdpServer;
     BackupManager*          m_pBackupManager;
     ICommunicationServer*   m_pCommServer;
+    std::vector<ICommunicationServer*> m_extraCommServers;
     MessageServerFunctor    m_topMessageServerFunctor;
 };
 
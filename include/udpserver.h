@@ -0,0 +1,92 @@
+#ifndef UDPSERVER_H
+#define UDPSERVER_H
+
+/**
+ * @file udpserver.h
+ * @brief UdpServer interface.
+ *        Fire and forget key reports: every datagram carries one or many key[,url,port[,count]]
+ *        records, one per line (as the /keysSent body), and gets no reply. Every receiving thread
+ *        owns a SO_REUSEPORT socket (the kernel spreads the senders among them) and takes up to
+ *        UDP_RECV_BATCH datagrams per recvmmsg() call, into slots of the maximum datagram size.
+ *        The records of a datagram are only counted by a newline scan: with at least one, it
+ *        is pushed straight into the message queue as one addKeys message, parsed once by the
+ *        queue thread; with none, or cut by the slot size, it is malformed. Counted too: the
+ *        records shed by the queue overload policy, and the datagrams the kernel dropped for
+ *        lack of socket buffer (SO_RXQ_OVFL), the loss a sender never hears about.
+ * @author Guillermo M. Paris
+ * @date 2026-10-18
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "icommunicationserver.h"
+#include "IMapManager.h"
+#include "IQueue.h"
+#include "Message.h"
+#include "verbosity.h"
+
+#define UDP_RECV_BATCH      64
+#define UDP_MAX_DATAGRAM    9000 // a jumbo frame payload fits: larger datagrams are IP fragmented
+#define UDP_SOCKET_BUFFER   (8 * 1024 * 1024) // asked for, the kernel caps it to net.core.rmem_max
+
+class UdpServer : public ICommunicationServer
+{
+public:
+
+    using IMessageQueue = IQueue<Message*, IMapManager*>;
+
+    struct Stats
+    {
+        uint64_t datagrams;     // received
+        uint64_t keys;          // records queued
+        uint64_t malformed;     // no key record, or truncated
+        uint64_t shed;          // records refused by the queue
+        uint64_t kernelDropped; // datagrams dropped by the kernel, socket buffer full
+    };
+
+    UdpServer() = delete;
+
+    // address: IPv4 or IPv6 literal to bind to. maxDatagram: bytes of every receive slot, longer
+    // datagrams are malformed. The path MTU payload (1472 on Ethernet) is enough for most senders.
+    UdpServer(const std::string& address, unsigned short port, IMessageQueue& queue,
+              unsigned short threads = 1, Verbosity v = 0, size_t maxDatagram = UDP_MAX_DATAGRAM);
+    ~UdpServer();
+
+    // Records go straight to the queue: nothing is reported upwards.
+    virtual void  setReporter(IncommingMessageFunctor&) {}
+    // Binds the sockets and starts the receiving threads, then returns. False if a bind failed.
+    virtual bool  start();
+    virtual bool  stop();
+
+    Stats getStats() const;
+
+
+private:
+
+    // The loop of one thread on its socket, the socket index in m_sockets.
+    void receive(int fd, size_t socketIndex);
+    void processDatagram(const char* data, size_t size, bool truncated);
+
+    // Verbosity or log level : 0:warnings & errors,  1:info,  2:trace,  3:debug
+    const Verbosity               m_verbosity;
+    const std::string             m_address;
+    const unsigned short          m_nPort;
+    const unsigned short          m_nThreads;
+    const size_t                  m_maxDatagram;
+    IMessageQueue&                m_queue;
+    std::atomic<bool>             m_running;
+    std::vector<int>              m_sockets;
+    std::vector<std::thread>      m_threads;
+
+    std::atomic<uint64_t>         m_datagrams;
+    std::atomic<uint64_t>         m_keys;
+    std::atomic<uint64_t>         m_malformed;
+    std::atomic<uint64_t>         m_shed;
+    std::vector<std::atomic<uint32_t>> m_kernelDropped; // per socket, the last SO_RXQ_OVFL count
+};
+
+#endif // UDPSERVER_H
@@ -0,0 +1,47 @@
+#ifndef ASYNCHTTPCONNECTION_H
+#define ASYNCHTTPCONNECTION_H
+
+/**
+ * @file async-http-connection.h
+ * @brief AsyncHttpConnection interface.
+ *        Keep-alive HTTP connection served by completion handlers instead of a blocking loop:
+ *        start() arms the first read and returns, so the accepting thread is free at once.
+ *        Every read completion processes the request and arms the write, every write
+ *        completion arms the next read. Requests pipelined behind the one read are processed
+ *        at once and all the responses go out in one gathered write. Between requests the connection holds no thread, only
+ *        its pending read, so a few io_context threads serve thousands of idle or busy clients.
+ *        The socket comes from the acceptor bound to its own strand: the handlers of one
+ *        connection never run concurrently.
+ * @author Guillermo M. Paris
+ * @date 2026-10-18
+ */
+
+#include "web/http-connection.h"
+
+class AsyncHttpConnection : public HttpConnection
+{
+public:
+
+    AsyncHttpConnection() = delete;
+
+    AsyncHttpConnection( boost::asio::ip::tcp::socket & socket, Verbosity v = 0)
+    : HttpConnection(socket, v)
+    {
+    }
+
+    // Arms the first read. The connection lives in its pending handlers until the client leaves.
+    void start();
+
+
+private:
+
+    void readRequestAsync();
+    void onRead(boost::beast::error_code ec, size_t bytes_read);
+    void writeResponseAsync();
+    void onWrite(boost::beast::error_code ec, size_t bytes_written);
+
+    std::shared_ptr<AsyncHttpConnection> self()
+        { return std::static_pointer_cast<AsyncHttpConnection>(shared_from_this()); }
+};
+
+#endif // ASYNCHTTPCONNECTION_H
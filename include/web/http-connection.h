@@ -6,11 +6,16 @@
 #include <boost/asio.hpp>
 #include <functional>
 #include <memory>
+#include <thread>
+#include <vector>
 
+#include "icommunicationserver.h"
 #include "verbosity.h"
 
 #define MAX_BUFFER_SIZE       4096
+#define MAX_BODY_SIZE         (1024 * 1024) // request body limit of the beast parser
 #define STEADY_DEADLINE_TIMER   10
+#define RETRY_AFTER_SECONDS      1 // advised to clients of a shed request
 
 
 class HttpConnection : public std::enable_shared_from_this<HttpConnection>
@@ -20,7 +25,8 @@ public:
     using WebServerGetFunctor = std::function<int (const std::string&, std::string&)>;
     using WebServerPostFunctor = std::function<int (const std::string&, const std::string&, std::string&)>;
 
-    static const size_t ms_maxBufferSize = MAX_BUFFER_SIZE;
+    static constexpr size_t ms_maxBufferSize = MAX_BUFFER_SIZE;
+    static constexpr size_t ms_maxBodySize = MAX_BODY_SIZE; // bulk /keysSent bodies
 //  static const int ms_steady_DeadlineTimer = STEADY_DEADLINE_TIMER;
 
     HttpConnection() = delete;
@@ -33,6 +39,9 @@ public:
     , m_socket(std::move(socket))
     , m_buffer(ms_maxBufferSize)
     {
+        // Responses leave in one write per burst of requests: nothing to coalesce by waiting.
+        boost::system::error_code ec;
+        m_socket.set_option(boost::asio::ip::tcp::no_delay(true), ec);
     }
 
     void setReporters(WebServerGetFunctor& gf, WebServerPostFunctor& pf)
@@ -47,11 +56,33 @@ public:
 private:
 
     void readRequest();
+    void writeResponse();
+
+protected:
+
+    // Logs a failed read, unless the client just closed the connection.
+    void reportReadError(const boost::beast::error_code& ec, size_t bytes_read);
     void processRequest();
+    // Sets the content length of m_response before it is written.
+    void prepareResponse();
+    // Pipelining: parses one more complete request already in m_buffer into m_request, without
+    // any read. False when the buffer holds no complete request (nothing is consumed then).
+    bool parseBufferedRequest();
+    // Serializes m_response after the responses pending to be written.
+    void queueResponse();
+    // Appends to m_buffer the bytes already received by the socket, without blocking. False when none.
+    bool readAvailable();
+    // Processes and queues the responses of every complete request left in m_buffer, or already
+    // received by the socket, in order.
+    void processBufferedRequests();
+    // The pending responses, for one gathered write; clearPendingResponses() once written.
+    const std::vector<boost::asio::const_buffer>& getPendingBuffers();
+    void clearPendingResponses() { m_pendingNumber = 0; }
     void createGetResponse(boost::beast::http::response<boost::beast::http::dynamic_body> & response);
     void createPostResponse(boost::beast::http::response<boost::beast::http::dynamic_body> & response);
-    void writeResponse();
 
+    // HTTP status of a command result (CMD_FAILED, CMD_SUCCEEDED, CMD_OVERLOADED).
+    void setResult(boost::beast::http::response<boost::beast::http::dynamic_body> & response, int retval);
     bool retrieveBody(std::string& sBody);
     void insertHtmlInResponse( boost::beast::http::response<boost::beast::http::dynamic_body> & response,
                                const char* payload,
@@ -90,6 +121,12 @@ private:
     // The response message.
     boost::beast::http::response<boost::beast::http::dynamic_body>  m_response;
 
+    // Serialized responses not written yet, in request order: m_pendingNumber of them are in use,
+    // the others keep their capacity for the next requests.
+    std::vector<std::string>                 m_pending;
+    size_t                                   m_pendingNumber = 0;
+    std::vector<boost::asio::const_buffer>   m_pendingBuffers;
+
     // The GET functor to report upwards the GET requests.
     WebServerGetFunctor m_getFunctor;
 
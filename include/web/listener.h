@@ -21,7 +21,7 @@ public:
     static const size_t max_threads = MAX_THREADS;
 
     Listener( boost::asio::ip::address address,
-              unsigned short port, unsigned short threadQty, Verbosity v = 0 );
+              unsigned short port, unsigned short threadQty, Verbosity v = 0, bool async = false );
     ~Listener();
 
     void setReporters(WebServerGetFunctor& gf, WebServerPostFunctor& pf) {m_getFunctor = gf; m_postFunctor = pf;}
@@ -40,6 +40,11 @@ private:
     // Verbosity or log level : 0:warnings & errors,  1:info,  2:trace,  3:debug
     const Verbosity                 m_verbosity;
 
+    // Set to serve every connection with AsyncHttpConnection: the accept is re-armed at once and a
+    // connection only takes a thread while one of its handlers runs. Otherwise every connection
+    // blocks one thread of the context until the client closes it.
+    const bool                      m_async;
+
     // I/O context having the execution context.
     boost::asio::io_context         m_ioc;
 
@@ -38,7 +38,7 @@ private:
     friend int main(int, char*[]); // this object is a "light singleton".
 
     WebServer(boost::asio::ip::address ip, const unsigned short port,
-              const unsigned short threads = 1, Verbosity v = 0);
+              const unsigned short threads = 1, Verbosity v = 0, bool async = false);
 //  ~WebServer();
 
     static int onGetMessage(const std::string& inTarget, std::string& outPayload);
@@ -0,0 +1,161 @@
+/**
+ * @file BackendDictionary.cpp
+ * @brief BackendDictionary implementation. Interning of backend URLs into 32 bit ids.
+ * @author Guillermo M. Paris
+ * @date 2026-10-18
+ */
+
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include "BackendDictionary.h"
+
+BackendDictionary::BackendDictionary() : m_size(0)
+{
+    for (std::atomic<const std::string**>& chunk : m_chunks)
+        chunk.store(nullptr, std::memory_order_relaxed);
+}
+
+BackendDictionary::~BackendDictionary()
+{
+    for (std::atomic<const std::string**>& chunk : m_chunks)
+        delete [] chunk.load(std::memory_order_relaxed);
+}
+
+uint32_t BackendDictionary::intern(std::string_view view)
+{
+    thread_local std::string url; // lookup key, its buffer is reused by the thread
+    url.assign(view);
+    {
+        std::shared_lock<std::shared_mutex> lock(m_mutex);
+        auto it = m_ids.find(url);
+        if (it != m_ids.end())
+            return it->second;
+    }
+
+    std::unique_lock<std::shared_mutex> lock(m_mutex);
+    auto inserted = m_ids.emplace(url, m_size.load(std::memory_order_relaxed));
+    if (! inserted.second) // interned by another thread in the meantime
+        return inserted.first->second;
+
+    const uint32_t id = inserted.first->second;
+    const uint32_t chunk = id >> ms_ChunkBits;
+    if (chunk >= ms_MaxChunks)
+    {
+        m_ids.erase(inserted.first);
+        throw std::length_error("BackendDictionary: too many backends");
+    }
+
+    const std::string** pChunk = m_chunks[chunk].load(std::memory_order_relaxed);
+    if (pChunk == nullptr)
+    {
+        pChunk = new const std::string*[ms_ChunkSize];
+        m_chunks[chunk].store(pChunk, std::memory_order_release);
+    }
+
+    pChunk[id & (ms_ChunkSize - 1)] = &inserted.first->first; // map nodes never move
+    m_size.store(id + 1, std::memory_order_release);
+    return id;
+}
+
+std::size_t BackendDictionary::memoryUsage() const
+{
+    std::shared_lock<std::shared_mutex> lock(m_mutex);
+
+    // Map nodes: key, id, next/hash words and the url heap buffer beyond the small string one;
+    // buckets; one pointer per id.
+    std::size_t bytes = m_ids.bucket_count() * sizeof(void*);
+    for (const auto& entry : m_ids)
+        bytes += sizeof(entry) + 2 * sizeof(void*) + (entry.first.capacity() > 15 ? entry.first.capacity() + 1 : 0);
+
+    const uint32_t chunks = (m_size.load(std::memory_order_relaxed) + ms_ChunkSize - 1) >> ms_ChunkBits;
+    return bytes + chunks * ms_ChunkSize * sizeof(const std::string*);
+}
+
+uint32_t BackendDictionary::write(std::ostream& out) const
+{
+    const uint32_t n = size();
+    out << ms_Header << ms_FieldSeparator << n << '\n';
+    for (uint32_t id = 0; id < n; id++)
+        out << id << ms_FieldSeparator << getUrl(id) << '\n';
+
+    return n;
+}
+
+bool BackendDictionary::hasHeader(std::istream& in)
+{
+    // A key may start with '#' too: the whole "#backends," token is looked for, then put back.
+    const std::string token = std::string(ms_Header) + ms_FieldSeparator;
+    const std::istream::pos_type start = in.tellg();
+    std::string prefix(token.size(), '\0');
+    in.read(&prefix[0], std::streamsize(prefix.size()));
+    const bool found = in.gcount() == std::streamsize(token.size()) && prefix == token;
+    in.clear();
+    in.seekg(start);
+    return found;
+}
+
+bool BackendDictionary::parseReference(const std::string& field, unsigned long& fileId)
+{
+    if (field.size() < 2 || field[0] != ms_Reference)
+        return false;
+
+    try
+    {
+        std::size_t end = 0;
+        fileId = std::stoul(field.substr(1), &end);
+        return end == field.size() - 1;
+    }
+    catch(const std::logic_error&)
+    {
+        return false;
+    }
+}
+
+bool BackendDictionary::read(std::istream& in, std::vector<uint32_t>& ids)
+{
+    std::string sHeader, sNumber, sUrl;
+    std::getline(in, sHeader, ms_FieldSeparator);
+    std::getline(in, sNumber);
+    if (in.fail() || sHeader != ms_Header)
+        return false;
+
+    unsigned long n = 0;
+    try
+    {
+        n = std::stoul(sNumber);
+    }
+    catch(const std::logic_error&) // invalid_argument or out_of_range
+    {
+        return false;
+    }
+
+    if (n > static_cast<unsigned long>(ms_ChunkSize) * ms_MaxChunks) // more than intern() could take
+        return false;
+
+    ids.assign(n, 0);
+    for (unsigned long i = 0; i < n; i++)
+    {
+        std::getline(in, sNumber, ms_FieldSeparator);
+        std::getline(in, sUrl); // the url is the last field: it may hold separators
+        if (in.fail())
+            return false;
+
+        unsigned long fileId = 0;
+        try
+        {
+            fileId = std::stoul(sNumber);
+        }
+        catch(const std::logic_error&)
+        {
+            return false;
+        }
+
+        if (fileId >= n)
+            return false;
+
+        ids[fileId] = intern(sUrl);
+    }
+
+    return true;
+}
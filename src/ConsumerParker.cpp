@@ -0,0 +1,87 @@
+/**
+ * @file ConsumerParker.cpp
+ * @brief ConsumerParker implementation. Spin then park waiting of a queue output thread.
+ * @author Guillermo M. Paris
+ * @date 2026-10-18
+ */
+
+#include <algorithm>
+#include <ctime>
+#include "ConsumerParker.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+const int ConsumerParker::maxSpinMicroseconds = MAX_SPIN_MICROSECONDS;
+
+namespace
+{
+    // Sleeps while *pWord == value, up to timeout if not 0 (spurious returns are fine, the
+    // caller loops).
+    void futexWait(std::atomic<uint32_t>* pWord, uint32_t value, std::chrono::milliseconds timeout)
+    {
+#if defined(__linux__)
+        struct timespec relative = {time_t(timeout.count() / 1000), long(timeout.count() % 1000) * 1000000L};
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(pWord), FUTEX_WAIT_PRIVATE, value,
+                timeout.count() > 0 ? &relative : nullptr, nullptr, 0);
+#else
+        (void) timeout;
+        if (pWord->load() == value)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+#endif
+    }
+
+    void futexWake(std::atomic<uint32_t>* pWord)
+    {
+#if defined(__linux__)
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(pWord), FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+#else
+        (void) pWord;
+#endif
+    }
+}
+
+void ConsumerParker::relax()
+{
+    // With a single hardware thread the producers can only push if this one yields.
+    static const bool singleCore = (std::thread::hardware_concurrency() <= 1);
+    if (singleCore)
+    {
+        std::this_thread::yield();
+        return;
+    }
+
+#if defined(__SSE2__)
+    for (int i = 0; i < 64; ++i)
+        _mm_pause();
+#endif
+}
+
+void ConsumerParker::sleep(uint32_t wakeups, std::chrono::milliseconds timeout)
+{
+    futexWait(&m_wakeups, wakeups, timeout);
+}
+
+void ConsumerParker::adapt(std::chrono::steady_clock::time_point parkedAt)
+{
+    // A short park means a longer spin would have avoided it, a long one that the spin was wasted.
+    const auto parked = std::chrono::duration_cast<std::chrono::microseconds>(
+                            std::chrono::steady_clock::now() - parkedAt).count();
+    if (parked < maxSpinMicroseconds)
+        m_spinMicroseconds = std::min(maxSpinMicroseconds, 2 * m_spinMicroseconds + 1);
+    else
+        m_spinMicroseconds /= 2;
+}
+
+void ConsumerParker::wakeUp()
+{
+    m_wakeups.fetch_add(1, std::memory_order_relaxed);
+    futexWake(&m_wakeups);
+}
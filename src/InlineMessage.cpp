@@ -0,0 +1,85 @@
+/**
+ * @file InlineMessage.cpp
+ * @brief InlineMessage implementation. Inline key buffer and spill arena for longer keys.
+ * @author Guillermo M. Paris
+ * @date 2026-10-18
+ */
+
+#include <atomic>
+#include <cstring>
+#include <new>
+#include "InlineMessage.h"
+
+// Header of every spill arena chunk, followed by its data. The producer thread holds one
+// reference while it fills the chunk, and every spilled key one more.
+struct InlineMessage::SpillChunk
+{
+    std::atomic<uint32_t> references;
+    uint32_t              used;
+    uint32_t              size;
+
+    char* data() { return reinterpret_cast<char*>(this + 1); }
+
+    static SpillChunk* create(uint32_t size)
+    {
+        SpillChunk* chunk = static_cast<SpillChunk*>(::operator new(sizeof(SpillChunk) + size));
+        new (&chunk->references) std::atomic<uint32_t>(1);
+        chunk->used = 0;
+        chunk->size = size;
+        return chunk;
+    }
+
+    void release()
+    {
+        if (references.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            ::operator delete(this);
+    }
+};
+
+// The chunk a producer thread is filling. Its reference is dropped when the chunk is full or
+// the thread ends.
+class InlineMessage::SpillArena
+{
+public:
+    ~SpillArena() { if (m_pChunk != nullptr) m_pChunk->release(); }
+
+    char* allocate(uint32_t length, SpillChunk*& pChunk)
+    {
+        if (m_pChunk == nullptr || m_pChunk->used + length > m_pChunk->size)
+        {
+            if (m_pChunk != nullptr)
+                m_pChunk->release();
+            m_pChunk = SpillChunk::create(length > INLINE_SPILL_CHUNK_SIZE ? length : INLINE_SPILL_CHUNK_SIZE);
+        }
+
+        m_pChunk->references.fetch_add(1, std::memory_order_relaxed);
+        char* p = m_pChunk->data() + m_pChunk->used;
+        m_pChunk->used += length;
+        pChunk = m_pChunk;
+        return p;
+    }
+
+private:
+    SpillChunk* m_pChunk = nullptr;
+};
+
+InlineMessage::InlineMessage(Command c, std::string_view key, uint32_t backend, uint8_t u8, uint16_t u16, uint32_t u32)
+    : m_keyLength(uint32_t(key.size())), m_backend(backend), m_number(u32), m_cmd(c), m_nbyte(u8), m_nshort(u16)
+{
+    if (key.size() <= ms_KeySize)
+    {
+        std::memcpy(m_key.inlined, key.data(), key.size());
+        return;
+    }
+
+    thread_local SpillArena arena;
+    char* p = arena.allocate(m_keyLength, m_key.spilled.chunk);
+    std::memcpy(p, key.data(), key.size());
+    m_key.spilled.data = p;
+}
+
+void InlineMessage::releaseKey() const
+{
+    if (isSpilled())
+        m_key.spilled.chunk->release();
+}
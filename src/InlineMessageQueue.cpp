@@ -0,0 +1,187 @@
+/**
+ * @file InlineMessageQueue.cpp
+ * @brief InlineMessageQueue implementation.
+ *        A bounded ring of InlineMessage values + output thread for messaging to IMapManager
+ *        derived objects.
+ * @author Guillermo M. Paris
+ * @date 2026-10-18
+ */
+
+#include <new>
+#include "InlineMessageQueue.h"
+
+InlineMessageQueue::InlineMessageQueue(size_t slots, size_t batchSize)
+    : m_batchSize(batchSize > 0 ? batchSize : 1), m_tail(0), m_head(0), m_running(false), m_consumer(nullptr)
+{
+    size_t capacity = 1;
+    while (capacity < slots || capacity < 2 * m_batchSize)
+        capacity <<= 1;
+
+    m_slots = new Slot[capacity];
+    m_mask = capacity - 1;
+    for (size_t i = 0; i < capacity; i++)
+        m_slots[i].sequence.store(i, std::memory_order_relaxed);
+}
+
+InlineMessageQueue::~InlineMessageQueue()
+{
+    // Messages never applied: only their spilled keys need releasing.
+    const size_t tail = m_tail.load(std::memory_order_acquire);
+    for (size_t position = m_head.load(std::memory_order_relaxed); position != tail; position++)
+    {
+        if (slot(position).sequence.load(std::memory_order_acquire) == position + 1)
+            slot(position).message.releaseKey();
+    }
+
+    delete [] m_slots;
+}
+
+bool InlineMessageQueue::isEmpty()
+{
+    return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire);
+}
+
+bool InlineMessageQueue::start()
+{
+    if (m_consumer == nullptr) return false;
+
+    m_running = true;
+    m_poper = std::thread([this]{run();});
+    return true;
+}
+
+bool InlineMessageQueue::stop()
+{
+    m_running = false;
+    m_parker.wakeUp();
+    m_poper.join();
+    return true; // this implementation always return true.
+}
+
+bool InlineMessageQueue::claim(size_t& position)
+{
+    position = m_tail.load(std::memory_order_relaxed);
+    while (m_running)
+    {
+        const size_t sequence = slot(position).sequence.load(std::memory_order_acquire);
+        if (sequence == position)
+        {
+            if (m_tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                return true;
+        }
+        else if (sequence < position + 1) // full: still holding the message of the previous lap
+        {
+            std::this_thread::yield();
+            position = m_tail.load(std::memory_order_relaxed);
+        }
+        else // claimed by another producer in the meantime
+        {
+            position = m_tail.load(std::memory_order_relaxed);
+        }
+    }
+
+    return false;
+}
+
+void InlineMessageQueue::publish(size_t position)
+{
+    slot(position).sequence.store(position + 1, std::memory_order_release);
+    m_parker.notify();
+}
+
+bool InlineMessageQueue::push(const InlineMessage& msg)
+{
+    size_t position = 0;
+    if (! claim(position))
+    {
+        msg.releaseKey();
+        return false;
+    }
+
+    slot(position).message = msg;
+    publish(position);
+    return true;
+}
+
+bool InlineMessageQueue::pushKey(std::string_view key, std::string_view url, unsigned port)
+{
+    const uint32_t backend = m_backends.intern(url); // may throw: before the slot is claimed
+    size_t position = 0;
+    if (! claim(position))
+        return false;
+
+    new (&slot(position).message) InlineMessage(Message::Command::addKey, key, backend, 0, 0, port);
+    publish(position);
+    return true;
+}
+
+void InlineMessageQueue::run()
+{
+    std::vector<KeyEvent> events;
+    events.reserve(m_batchSize);
+    size_t head = m_head.load(std::memory_order_relaxed);
+
+    while (m_running)
+    {
+        Slot& s = slot(head);
+        if (s.sequence.load(std::memory_order_acquire) != head + 1) // empty: the batch is over
+        {
+            if (! events.empty())
+                flushKeys(events, head);
+            else
+                m_parker.wait([this, &s, head]{
+                    return s.sequence.load(std::memory_order_acquire) == head + 1 || ! m_running; });
+            continue;
+        }
+
+        const InlineMessage& msg = s.message;
+        if (msg.getCommand() == Message::Command::addKey)
+        {
+            events.push_back({msg.getKey(), m_backends.getUrl(msg.getBackend()), msg.getNumber()});
+            if (++head - m_head.load(std::memory_order_relaxed) >= m_batchSize)
+                flushKeys(events, head);
+            continue;
+        }
+
+        // Keys queued before any other command are applied first.
+        flushKeys(events, head);
+
+        switch (msg.getCommand())
+        {
+        case Message::Command::setRankingLength:
+            m_consumer->setTopKeyReportBaseSize(msg.getShort());
+            break;
+
+        case Message::Command::stop:
+            m_running = false;
+            break;
+
+        default:
+            break;
+        }
+
+        releaseSlot(head);
+        m_head.store(++head, std::memory_order_release);
+    }
+
+    flushKeys(events, head);
+}
+
+void InlineMessageQueue::flushKeys(std::vector<KeyEvent>& events, size_t head)
+{
+    if (events.empty()) return;
+
+    m_consumer->addOrUpdateKeys(events.data(), events.size());
+    for (size_t position = m_head.load(std::memory_order_relaxed); position != head; position++)
+        releaseSlot(position);
+
+    m_head.store(head, std::memory_order_release);
+    events.clear();
+}
+
+void InlineMessageQueue::releaseSlot(size_t position)
+{
+    Slot& s = slot(position);
+    s.message.releaseKey();
+    s.sequence.store(position + m_mask + 1, std::memory_order_release);
+}
@@ -0,0 +1,117 @@
+/**
+ * @file KeyBatch.cpp
+ * @brief KeyBatch implementation. Pre-aggregation of duplicate keys in a batch of key events.
+ * @author Guillermo M. Paris
+ * @date 2026-10-18
+ */
+
+#include <algorithm>
+#include <charconv>
+#include <functional>
+#include "KeyBatch.h"
+
+void KeyBatch::aggregate(const KeyEvent* pEvents, std::size_t n)
+{
+    m_entries.clear();
+
+    // A power of two at least twice the events: probing sequences stay short.
+    std::size_t tableSize = 16;
+    while (tableSize < 2 * n)
+        tableSize *= 2;
+
+    if (m_table.size() < tableSize)
+        m_table.resize(tableSize);
+
+    std::fill(m_table.begin(), m_table.begin() + tableSize, 0);
+    const std::size_t mask = tableSize - 1;
+
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        const KeyEvent& event = pEvents[i];
+        const std::size_t h = std::hash<std::string_view>{}(event.key);
+
+        std::size_t pos = h & mask;
+        while (m_table[pos] != 0)
+        {
+            Entry& entry = m_entries[m_table[pos] - 1];
+            if (entry.hash == h && entry.key == event.key)
+                break;
+            pos = (pos + 1) & mask;
+        }
+
+        if (m_table[pos] == 0) // first event of this key
+        {
+            m_entries.push_back({event.key, event.url, event.port, event.count, h});
+            m_table[pos] = uint32_t(m_entries.size());
+            continue;
+        }
+
+        Entry& entry = m_entries[m_table[pos] - 1];
+        entry.url = event.url;
+        entry.port = event.port;
+        entry.count += event.count;
+    }
+}
+
+namespace
+{
+    // Next comma separated field of a record, consumed from it.
+    std::string_view nextField(std::string_view& record)
+    {
+        const std::size_t comma = record.find(',');
+        const std::string_view field = record.substr(0, comma);
+        record.remove_prefix(comma == std::string_view::npos ? record.size() : comma + 1);
+        return field;
+    }
+
+    unsigned int toUnsigned(std::string_view field, unsigned int missing)
+    {
+        unsigned int value = missing;
+        if (! field.empty() && std::from_chars(field.data(), field.data() + field.size(), value).ec != std::errc())
+            return 0;
+
+        return value;
+    }
+}
+
+std::size_t parseKeyRecords(std::string_view body, std::vector<KeyEvent>& events, unsigned int weight)
+{
+    const std::size_t before = events.size();
+    while (! body.empty())
+    {
+        std::string_view record = nextKeyRecord(body);
+        const std::string_view key = nextField(record);
+        const std::string_view url = nextField(record);
+        const unsigned int port = toUnsigned(nextField(record), 0);
+        const unsigned int count = toUnsigned(nextField(record), 1);
+        if (key.empty() || count == 0)
+            continue;
+
+        events.push_back({key, url, port, count * weight});
+    }
+
+    return events.size() - before;
+}
+
+std::string_view nextKeyRecord(std::string_view& body)
+{
+    const std::size_t newline = body.find('\n');
+    std::string_view record = body.substr(0, newline);
+    body.remove_prefix(newline == std::string_view::npos ? body.size() : newline + 1);
+    if (! record.empty() && record.back() == '\r')
+        record.remove_suffix(1);
+
+    return record;
+}
+
+std::size_t countKeyRecords(std::string_view body)
+{
+    std::size_t records = 0;
+    while (! body.empty())
+    {
+        const std::string_view record = nextKeyRecord(body);
+        records += (! record.empty() && record.front() != ',');
+    }
+
+    return records;
+}
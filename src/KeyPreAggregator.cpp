@@ -0,0 +1,194 @@
+/**
+ * @file KeyPreAggregator.cpp
+ * @brief KeyPreAggregator implementation. Per thread key counting ahead of the message queue.
+ * @author Guillermo M. Paris
+ * @date 2026-10-18
+ */
+
+#include <limits>
+#include "KeyPreAggregator.h"
+
+namespace
+{
+    std::atomic<uint64_t> ms_nextAggregatorId(1);
+}
+
+// The tables of one thread, one per aggregator it counted keys for. The tables belong to their
+// aggregator: the ones of a destroyed aggregator are never looked up again (ids are not reused).
+class KeyPreAggregator::ThreadTables
+{
+public:
+    Table* find(uint64_t id)
+    {
+        if (m_pLast != nullptr && m_lastId == id)
+            return m_pLast;
+
+        for (Entry& entry : m_entries)
+        {
+            if (entry.id == id)
+            {
+                m_lastId = id;
+                m_pLast = entry.pTable;
+                return m_pLast;
+            }
+        }
+
+        return nullptr;
+    }
+
+    void add(uint64_t id, Table* pTable)
+    {
+        m_entries.push_back({id, pTable});
+        m_lastId = id;
+        m_pLast = pTable;
+    }
+
+private:
+    struct Entry
+    {
+        uint64_t id;
+        Table*   pTable;
+    };
+
+    std::vector<Entry> m_entries;
+    uint64_t           m_lastId = 0;
+    Table*             m_pLast = nullptr;
+};
+
+KeyPreAggregator::KeyPreAggregator(MessageQueue& queue, std::chrono::microseconds staleness, size_t tableKeys)
+    : m_id(ms_nextAggregatorId.fetch_add(1, std::memory_order_relaxed)), m_queue(queue)
+    , m_staleness(staleness.count() > 0 ? staleness : std::chrono::microseconds(1))
+    , m_tableKeys(tableKeys > 0 ? tableKeys : 1), m_messages(0), m_dropped(0), m_lastDrop(0), m_stopping(false)
+{
+    m_flusher = std::thread([this]{runFlusher();});
+}
+
+KeyPreAggregator::~KeyPreAggregator()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_flusherMutex);
+        m_stopping = true;
+    }
+    m_flusherWakeUp.notify_one();
+    m_flusher.join();
+    flush();
+}
+
+KeyPreAggregator::Table* KeyPreAggregator::table()
+{
+    thread_local ThreadTables tables;
+    Table* pTable = tables.find(m_id);
+    if (pTable != nullptr)
+        return pTable;
+
+    std::lock_guard<std::mutex> lock(m_tablesMutex);
+    m_tables.emplace_back(new Table);
+    pTable = m_tables.back().get();
+    pTable->counts.reserve(m_tableKeys);
+    tables.add(m_id, pTable);
+    return pTable;
+}
+
+bool KeyPreAggregator::addKey(const std::string& key, const std::string& url, uint32_t port)
+{
+    // No clock read until the queue sheds a count.
+    const int64_t lastDrop = m_lastDrop.load(std::memory_order_relaxed);
+    if ( lastDrop != 0
+      && std::chrono::steady_clock::now().time_since_epoch().count() - lastDrop
+         < std::chrono::duration_cast<std::chrono::steady_clock::duration>(m_staleness).count() )
+        return false;
+
+    Table& t = *table();
+    std::lock_guard<std::mutex> lock(t.mutex);
+    t.events++;
+
+    auto it = t.counts.find(key);
+    if (it == t.counts.end())
+    {
+        if (t.counts.size() >= m_tableKeys)
+            flushTable(t);
+        if (t.counts.empty())
+            t.oldest = std::chrono::steady_clock::now();
+
+        t.counts.emplace(key, Count{url, port, 1});
+        return true;
+    }
+
+    Count& count = it->second;
+    if (count.port != port || count.url != url)
+    {
+        count.url = url;
+        count.port = port;
+    }
+
+    if (++count.count == std::numeric_limits<uint16_t>::max()) // the most a message carries
+    {
+        queueCount(key, count);
+        t.counts.erase(it);
+    }
+
+    return true;
+}
+
+void KeyPreAggregator::flush()
+{
+    std::lock_guard<std::mutex> lock(m_tablesMutex);
+    for (std::unique_ptr<Table>& pTable : m_tables)
+    {
+        std::lock_guard<std::mutex> tableLock(pTable->mutex);
+        flushTable(*pTable);
+    }
+}
+
+void KeyPreAggregator::flushTable(Table& table)
+{
+    for (auto& entry : table.counts)
+        queueCount(entry.first, entry.second);
+
+    table.counts.clear(); // the buckets are kept
+}
+
+void KeyPreAggregator::queueCount(const std::string& key, Count& count)
+{
+    if (m_queue.push(new Message(Message::Command::addKey, key, count.url, 0, count.count, count.port)))
+        m_messages.fetch_add(1, std::memory_order_relaxed);
+    else
+    {
+        m_dropped.fetch_add(count.count, std::memory_order_relaxed);
+        m_lastDrop.store(std::chrono::steady_clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+    }
+}
+
+void KeyPreAggregator::runFlusher()
+{
+    // Every half staleness, the tables holding counts older than half staleness are flushed:
+    // no count waits longer than staleness.
+    const std::chrono::microseconds period = m_staleness / 2 > std::chrono::microseconds(0)
+                                           ? m_staleness / 2 : m_staleness;
+    std::unique_lock<std::mutex> flusherLock(m_flusherMutex);
+    while (! m_flusherWakeUp.wait_for(flusherLock, period, [this]{ return m_stopping; }))
+    {
+        const std::chrono::steady_clock::time_point due = std::chrono::steady_clock::now() - period;
+        std::lock_guard<std::mutex> lock(m_tablesMutex);
+        for (std::unique_ptr<Table>& pTable : m_tables)
+        {
+            std::lock_guard<std::mutex> tableLock(pTable->mutex);
+            if (! pTable->counts.empty() && pTable->oldest <= due)
+                flushTable(*pTable);
+        }
+    }
+}
+
+KeyPreAggregator::Stats KeyPreAggregator::getStats() const
+{
+    std::lock_guard<std::mutex> lock(m_tablesMutex);
+    uint64_t events = 0;
+    for (const std::unique_ptr<Table>& pTable : m_tables)
+    {
+        std::lock_guard<std::mutex> tableLock(pTable->mutex);
+        events += pTable->events;
+    }
+
+    return {events, m_messages.load(std::memory_order_relaxed), m_dropped.load(std::memory_order_relaxed),
+            uint64_t(m_tables.size())};
+}
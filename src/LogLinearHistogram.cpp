@@ -0,0 +1,103 @@
+/**
+ * @file LogLinearHistogram.cpp
+ * @brief LogLinearHistogram and TickClock implementation.
+ * @author Guillermo M. Paris
+ * @date 2026-10-18
+ */
+
+#include <thread>
+#include "LogLinearHistogram.h"
+
+namespace
+{
+    // Both clocks read together at start up: the calibration base.
+    struct TickClockBase
+    {
+        TickClockBase() : ticks(TickClock::now()), time(std::chrono::steady_clock::now()) {}
+
+        uint64_t                              ticks;
+        std::chrono::steady_clock::time_point time;
+    };
+
+    const TickClockBase tickClockBase;
+}
+
+double TickClock::nanosecondsPerTick()
+{
+    const std::chrono::milliseconds minimum(10);
+    const auto elapsed = std::chrono::steady_clock::now() - tickClockBase.time;
+    if (elapsed < minimum)
+        std::this_thread::sleep_for(minimum - elapsed);
+
+    const uint64_t ticks = now() - tickClockBase.ticks;
+    const double nanoseconds = std::chrono::duration<double, std::nano>(
+                               std::chrono::steady_clock::now() - tickClockBase.time).count();
+    return ticks > 0 ? nanoseconds / double(ticks) : 1.0;
+}
+
+void LogLinearHistogram::add(const LogLinearHistogram& other)
+{
+    for (unsigned i = 0; i < ms_Buckets; i++)
+        m_buckets[i].store(m_buckets[i].load(std::memory_order_relaxed) +
+                           other.m_buckets[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+
+    m_count.store(getCount() + other.getCount(), std::memory_order_relaxed);
+    if (other.getMax() > getMax())
+        m_max.store(other.getMax(), std::memory_order_relaxed);
+}
+
+void LogLinearHistogram::reset()
+{
+    for (std::atomic<uint64_t>& bucket : m_buckets)
+        bucket.store(0, std::memory_order_relaxed);
+
+    m_count.store(0, std::memory_order_relaxed);
+    m_max.store(0, std::memory_order_relaxed);
+}
+
+uint64_t LogLinearHistogram::getBucketUpperBound(unsigned bucket)
+{
+    if (bucket < ms_SubBuckets)
+        return bucket;
+
+    const unsigned shift = (bucket >> ms_SubBucketBits) - 1;
+    const uint64_t low = uint64_t(ms_SubBuckets + (bucket & (ms_SubBuckets - 1))) << shift;
+    return low + ((uint64_t(1) << shift) - 1);
+}
+
+uint64_t LogLinearHistogram::getPercentile(double fraction) const
+{
+    // The buckets are read while they may still be recorded: their total is the one to rank.
+    uint64_t counts[ms_Buckets];
+    uint64_t total = 0;
+    for (unsigned i = 0; i < ms_Buckets; i++)
+        total += (counts[i] = m_buckets[i].load(std::memory_order_relaxed));
+
+    if (total == 0)
+        return 0;
+
+    uint64_t rank = uint64_t(fraction * double(total) + 0.5);
+    if (rank < 1) rank = 1;
+    if (rank > total) rank = total;
+
+    const uint64_t max = getMax();
+    uint64_t seen = 0;
+    for (unsigned i = 0; i < ms_Buckets; i++)
+    {
+        seen += counts[i];
+        if (seen >= rank)
+        {
+            const uint64_t bound = getBucketUpperBound(i);
+            return bound < max ? bound : max;
+        }
+    }
+
+    return max;
+}
+
+LogLinearHistogram::Summary LogLinearHistogram::getSummary(double scale) const
+{
+    auto scaled = [scale](uint64_t value) { return uint64_t(double(value) * scale + 0.5); };
+    return {getCount(), scaled(getPercentile(0.50)), scaled(getPercentile(0.99)),
+            scaled(getPercentile(0.999)), scaled(getMax())};
+}
@@ -9,97 +9,177 @@
 #include <iostream>
 #include "MapManager.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 MapManager::MapManager()
     : m_verbosity(0)
     , m_baseReportElementNumber(ms_DefaultTopKeySize), m_maxReportElementNumber(ms_MaxTopKeySize),
-      m_pKeyMap(new strdetailsMap), m_pFrequencyMap(new ulongstrMap), m_writingData(0)
+      m_pBackends(new BackendDictionary), m_ownsBackends(true), m_pKeyMap(new strdetailsMap), m_pRanking(new Ranking(ms_MaxTopKeySize)), m_writingData(0)
 {
+    initTopKeys();
 }
 
-MapManager::MapManager( unsigned int n,
-                        unsigned int m /* = 0 */, unsigned int logLevel /* = 0 */)
+MapManager::MapManager( unsigned int n, unsigned int m /* = 0 */, unsigned int logLevel /* = 0 */,
+                        BackendDictionary* backends /* = nullptr */ )
     : m_verbosity(logLevel)
     , m_baseReportElementNumber(n)
     , m_maxReportElementNumber(m > n + MIN_GAP_MAX_DEFAULT ? m : n + MIN_GAP_MAX_DEFAULT)
+    , m_pBackends(backends ? backends : new BackendDictionary)
+    , m_ownsBackends(backends == nullptr)
     , m_pKeyMap(new strdetailsMap)
-    , m_pFrequencyMap(new ulongstrMap)
+    , m_pRanking(new Ranking(m_maxReportElementNumber))
     , m_writingData(0)
 {
+    initTopKeys();
 }
 
 MapManager::~MapManager()
 {
     if (m_pKeyMap)       delete m_pKeyMap;
-    if (m_pFrequencyMap) delete m_pFrequencyMap;
+    if (m_pRanking)      delete m_pRanking;
+    if (m_ownsBackends)  delete m_pBackends;
 }
 
 void MapManager::addOrUpdateKey(const std::string& key, const std::string& url, unsigned int nPort)
 {
-    unsigned long prevOrderNo = 0L, orderNo = 1L;
+    std::lock_guard<std::mutex> lock(m_mapMutex);
+    m_writingData = 1;
+
+    if (updateKey(key, strdetailsMap::hash(key), url, nPort, 1))
+        publishTopKeys();
+
+    m_writingData = 0;
+    m_mapCondition.notify_one();
+}
+
+void MapManager::addOrUpdateKeys(const KeyEvent* pEvents, std::size_t n)
+{
+    // Duplicates are collapsed before taking the lock. The buffers are reused by the thread.
+    thread_local KeyBatch batch;
+    batch.aggregate(pEvents, n);
+    addOrUpdateKeys(batch.begin(), batch.size());
+}
+
+void MapManager::addOrUpdateKeys(const KeyBatch::Entry* pEntries, std::size_t n)
+{
+    if (n == 0) return;
 
     std::lock_guard<std::mutex> lock(m_mapMutex);
     m_writingData = 1;
 
-    // Search, insert or update on the key map.
-    strdetailsIterator itKeyEnd = m_pKeyMap->end();
-    strdetailsIterator itKeys = m_pKeyMap->lower_bound(key); // not parallel
+    bool rankingChanged = false;
+    for (const KeyBatch::Entry* pEntry = pEntries; pEntry != pEntries + n; ++pEntry)
+        rankingChanged |= updateKey(pEntry->key, pEntry->hash, pEntry->url, pEntry->port, pEntry->count);
 
-    if (itKeys != itKeyEnd)
-    {
-        if(itKeys->first.compare(key) == 0) // key found! Just increment the frequency count
-        {
-            prevOrderNo = itKeys->second.frequency;
-            if (m_verbosity >= Verbosity::debug)
-                std::cout << "Found Key " << key << "  " << prevOrderNo << " times.\n";
+    if (rankingChanged) // one snapshot for the whole batch
+        publishTopKeys();
 
-            orderNo = 1 + prevOrderNo;
-        }
+    m_writingData = 0;
+    m_mapCondition.notify_one();
+}
+
+bool MapManager::updateKey( std::string_view key, std::size_t h, std::string_view url,
+                            unsigned int nPort, unsigned long count )
+{
+    // Search, insert or update on the key map. One hash probe for both cases.
+    std::pair<strdetailsMap::Slot*, bool> itKeys = m_pKeyMap->tryEmplaceHashed(key, h);
+    KeyDetails& details = itKeys.first->value;
+    if (itKeys.second) // new key
+    {
+        details.frequency = count;
+        details.backend = m_pBackends->intern(url);
     }
-    // search shortened by hint (itKeys).
-    m_pKeyMap->insert_or_assign( itKeys, std::string(key), KeyDetails(url, nPort, orderNo) );
-
-    unsigned long lowestInTopRank = (m_pFrequencyMap->empty() ? 1L : m_pFrequencyMap->begin()->first);
-    unsigned int actualSize = m_pFrequencyMap->size();
-    if (orderNo <= lowestInTopRank && actualSize >= m_maxReportElementNumber)
-    {   // It is really not worth inserting but then later deleting by size maintenance.
-        m_writingData = 0;
-        m_mapCondition.notify_one();
-        return;
+    else // key found! Just increment the frequency count
+    {
+        if (m_verbosity >= Verbosity::debug)
+            std::cout << "Found Key " << key << "  " << details.frequency << " times.\n";
+
+        details.frequency += count;
+        if (m_pBackends->getUrl(details.backend) != url) // lock free check, usually the same backend
+            details.backend = m_pBackends->intern(url);
     }
 
-    // Search, delete and insert on the frequency map.
+    details.port = nPort;
+
+    if (details.rank != nullptr) // already in the ranking: move it to its new frequency bucket
+        m_pRanking->increment(details.rank, count);
+    else
+        rankKey(itKeys.first->key, details);
+
+    return details.rank != nullptr;
+}
 
-    if (prevOrderNo > 0) // if this key is already present in the ranking, the old record must be removed
+void MapManager::rankKey(std::string_view key, KeyDetails& details)
+{
+    if (m_pRanking->full())
     {
-        ulongstrIterator itRanking = m_pFrequencyMap->find(prevOrderNo);
-        ulongstrIterator itRankingEnd = m_pFrequencyMap->end();
+        // It is really not worth inserting but then later deleting by size maintenance.
+        if (details.frequency <= m_pRanking->minCount())
+            return;
 
-        while ( itRanking != itRankingEnd &&  // frequency number found in frequency table and ...
-                itRanking->second != key && itRanking->first == prevOrderNo )
-        {
-            ++itRanking;
-        }
+        // Size maintainance that keeps the ranking size constant: the oldest lowest one leaves.
+        Ranking::Node* pLowest = m_pRanking->minNode();
+        KeyDetails* pEvicted = m_pKeyMap->find(pLowest->item.key);
+        if (pEvicted) pEvicted->rank = nullptr;
 
-        if (itRanking != itRankingEnd && itRanking->first == prevOrderNo)
-        {
-            m_pFrequencyMap->erase(itRanking);  // combination {prevOrderNo, key} was really found.
-            if (m_verbosity >= Verbosity::debug)
-                std::cout << "Frequency " << prevOrderNo << ", Key: " << key << ", eliminated from the ranking.\n";
-        }
+        if (m_verbosity >= Verbosity::debug)
+            std::cout << "Frequency " << pLowest->count() << ", Key: " << pLowest->item.key
+                      << ", eliminated from the ranking.\n";
 
+        m_pRanking->remove(pLowest);
     }
 
-    m_pFrequencyMap->insert({orderNo, std::string(key)});
+    details.rank = m_pRanking->insert(details.frequency);
+    details.rank->item.key = key;
+    details.rank->item.fingerprint = hotKeyFingerprint(strdetailsMap::hash(key));
+}
 
-    while (m_pFrequencyMap->size() > m_maxReportElementNumber)
+bool MapManager::resolveBackend(const std::string& field, const std::vector<uint32_t>* pBackendIds, uint32_t& backend)
+{
+    // Without a dictionary header, a url starting with '#' is just a url.
+    unsigned long fileId = 0;
+    if (pBackendIds == nullptr || ! BackendDictionary::parseReference(field, fileId)) // full url
     {
-        // Size maintainance that keeps this map's size constant.
-        ulongstrIterator itRanking = m_pFrequencyMap->begin();
-        m_pFrequencyMap->erase(itRanking++);
+        backend = m_pBackends->intern(field);
+        return true;
     }
 
-    m_writingData = 0;
-    m_mapCondition.notify_one();
+    if (fileId >= pBackendIds->size())
+        return false;
+
+    backend = (*pBackendIds)[fileId];
+    return true;
+}
+
+void MapManager::initTopKeys()
+{
+    m_topKeys.initialize( [this](TopKeys& topKeys) {
+        topKeys.entries.resize(m_maxReportElementNumber);
+        topKeys.fingerprints.assign( (m_maxReportElementNumber + ms_fingerprintLanes - 1)
+                                     / ms_fingerprintLanes * ms_fingerprintLanes, 0 );
+        topKeys.base = m_baseReportElementNumber;
+    } );
+}
+
+void MapManager::publishTopKeys()
+{
+    // Only views of the interned keys are copied: no key string is duplicated.
+    TopKeys& topKeys = m_topKeys.beginWrite();
+    unsigned int index = 0;
+    m_pRanking->forEachDescending( [&](Ranking::Node& node) {
+        topKeys.entries[index] = KeyCount{node.item.key, node.count()};
+        topKeys.fingerprints[index] = node.item.fingerprint;
+        return ++index < m_maxReportElementNumber;
+    } );
+
+    topKeys.size = index;
+    for (unsigned int i = index; i < topKeys.fingerprints.size(); i++)
+        topKeys.fingerprints[i] = 0;
+
+    topKeys.base = m_baseReportElementNumber;
+    m_topKeys.commit();
 }
 
 void MapManager::setTopKeyReportBaseSize(unsigned short newBase)
@@ -116,51 +196,90 @@ void MapManager::setTopKeyReportBaseSize(unsigned short newBase)
         m_baseReportElementNumber = newBase;
     }
 
+    publishTopKeys();
     m_writingData = 0;
 }
 
-bool MapManager::isHotKey(const std::string& key)
+unsigned MapManager::findFingerprint(const TopKeys& topKeys, uint16_t fingerprint, unsigned from)
 {
-    std::unique_lock<std::mutex>  lock(m_mapMutex);
-    m_mapCondition.wait( lock, [this]{return this->m_writingData == 0;} );
+    const uint16_t* pLanes = topKeys.fingerprints.data();
+    unsigned group = from - from % ms_fingerprintLanes;
+    for ( ; group < topKeys.size; group += ms_fingerprintLanes)
+    {
+#if defined(__SSE2__)
+        __m128i lanes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pLanes + group));
+        __m128i equal = _mm_cmpeq_epi16(lanes, _mm_set1_epi16(static_cast<short>(fingerprint)));
+        uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(equal)) & 0x5555; // one bit per lane
+#else
+        uint32_t mask = 0;
+        for (unsigned i = 0; i < ms_fingerprintLanes; i++)
+            mask |= uint32_t(pLanes[group + i] == fingerprint) << (2 * i);
+#endif
+        unsigned skip = (from > group ? from - group : 0); // lanes before 'from'
+        mask &= ~0U << (2 * skip);
+        if (mask != 0)
+            return group + static_cast<unsigned>(__builtin_ctz(mask)) / 2;
+    }
 
-    strdetailsIterator itKeyEnd = m_pKeyMap->end();
-    strdetailsIterator itKeys = m_pKeyMap->find(key);
-    if (itKeys == itKeyEnd) return false; // supplied key not found in keyMap
+    return topKeys.size;
+}
 
-    unsigned long orderNo = itKeys->second.frequency;
-    unsigned long lowestInTopRank = (m_pFrequencyMap->empty() ? 0L : m_pFrequencyMap->begin()->first);
-    if (orderNo < lowestInTopRank)  return false; // orderNo would never be found, no worth searching for it.
+bool MapManager::isHotKey(const std::string& key)
+{
+    return getHotKeyCount(key) != 0;
+}
 
-    ulongstrIterator itRankingEnd = m_pFrequencyMap->end();
-    ulongstrIterator itRanking = m_pFrequencyMap->find(orderNo);
-    if (itRanking == itRankingEnd) return false; // orderNo not found. Should never happen!
+uint64_t MapManager::getHotKeyCount(const std::string& key)
+{
+    // One hash, then usually a single SIMD compare of the published fingerprints: a miss
+    // never reads a key string.
+    const uint16_t fingerprint = hotKeyFingerprint(strdetailsMap::hash(key));
 
-    while ( itRanking != itRankingEnd && itRanking->second != key
-            && itRanking->first == orderNo )
+    TopKeysPublisher::ReadGuard topKeys(m_topKeys);
+    for ( unsigned i = findFingerprint(*topKeys, fingerprint, 0); i < topKeys->size;
+          i = findFingerprint(*topKeys, fingerprint, i + 1) )
     {
-        ++itRanking;
+        if (topKeys->entries[i].key == key)
+            return topKeys->entries[i].count;
     }
 
-    return itRanking != itRankingEnd && itRanking->first == orderNo;
+    return 0;
+}
+
+bool MapManager::isRankedKey(const std::string& key)
+{
+    std::unique_lock<std::mutex>  lock(m_mapMutex);
+    m_mapCondition.wait( lock, [this]{return this->m_writingData == 0;} );
+
+    const KeyDetails* pDetails = m_pKeyMap->find(key);
+    return pDetails != nullptr && pDetails->rank != nullptr; // every key knows its ranking node
 }
 
 void MapManager::getTopHotkeys(KeyFrequencyVector& vec)
 {
-    unsigned int index = 0;
+    TopKeysPublisher::ReadGuard topKeys(m_topKeys);
+    copyTopKeys(*topKeys, vec, topKeys->base);
+}
 
-    std::unique_lock<std::mutex> lock(m_mapMutex);
-    m_mapCondition.wait( lock, [this]{return this->m_writingData == 0;} );
+void MapManager::getRanking(KeyFrequencyVector& vec, unsigned int count)
+{
+    TopKeysPublisher::ReadGuard topKeys(m_topKeys);
+    copyTopKeys(*topKeys, vec, count);
+}
 
-    ulongstrMap::reverse_iterator itRevRanking = m_pFrequencyMap->rbegin();
-    ulongstrMap::reverse_iterator itRevRankingEnd = m_pFrequencyMap->rend();
-    while (itRevRanking != itRevRankingEnd && index < m_baseReportElementNumber)
-    {
-        vec.push_back( KeyFrequency( // move to record, not a copy
-                       std::string(itRevRanking->second), std::to_string(itRevRanking->first) ));
-        ++itRevRanking;
-        ++index;
-    }
+unsigned int MapManager::getTopKeys(const TopKeysGuard& guard, KeyCountVector& out, unsigned int count)
+{
+    unsigned int size = (count < guard->size ? count : guard->size);
+    out.clear();
+    out.insert(out.end(), guard->entries.begin(), guard->entries.begin() + size);
+    return size;
+}
+
+void MapManager::copyTopKeys(const TopKeys& topKeys, KeyFrequencyVector& vec, unsigned int count)
+{
+    unsigned int size = (count < topKeys.size ? count : topKeys.size);
+    for (unsigned int i = 0; i < size; i++)
+        vec.emplace_back(topKeys.entries[i]);
 }
 
 bool MapManager::backupRequest(const std::string& keyFilename, const std::string& freqFilename)
@@ -189,46 +308,48 @@ bool MapManager::backupRequest(const std::string& keyFilename, const std::string
         return false;
     }
 
-    std::unique_lock<std::mutex>  lock(m_mapMutex);
-    m_mapCondition.wait( lock, [this]{return this->m_writingData == 0;} );
-
-    // Iterate and dump the frequency map.
-
-    ulongstrIterator itRanking = m_pFrequencyMap->begin();
-    ulongstrIterator itRankingEnd = m_pFrequencyMap->end();
-    while (itRanking != itRankingEnd)
+    // Every backend url is written once, in the header of the key file.
+    uint32_t knownBackends = m_pBackends->write(outKeyFile);
+    if (! backupRequest(outKeyFile, outFreqFile, knownBackends))
     {
-        outFreqFile << itRanking->first << ms_FieldSeparator << itRanking->second << '\n';
-
-        if (outFreqFile.bad())
-        {
-            logError(freqFilename, "writing");
-            return false;
-        }
-
-        ++itRanking;
+        logError(outFreqFile.bad() ? freqFilename : keyFilename, "writing");
+        return false;
     }
 
     outFreqFile.close();
+    outKeyFile.close();
+    return true;
+}
 
-    // Iterate and dump the key map.
-    strdetailsIterator itKeys = m_pKeyMap->begin();
-    strdetailsIterator itKeyEnd = m_pKeyMap->end();
-    while (itKeys != itKeyEnd)
-    {
-        outKeyFile << itKeys->first << ms_FieldSeparator << itKeys->second.frequency
-        << ms_FieldSeparator << itKeys->second.url << ms_FieldSeparator << itKeys->second.port << '\n';
+bool MapManager::backupRequest(std::ostream& outKeyStream, std::ostream& outFreqStream, uint32_t knownBackends)
+{
+    std::unique_lock<std::mutex>  lock(m_mapMutex);
+    m_mapCondition.wait( lock, [this]{return this->m_writingData == 0;} );
 
-        ++itKeys;
-    }
-    if (outKeyFile.bad())
-    {
-        logError(keyFilename, "writing");
+    // Iterate and dump the ranking, lowest frequency first.
+
+    m_pRanking->forEachAscending( [&](Ranking::Node& node) {
+        outFreqStream << node.count() << ms_FieldSeparator << node.item.key << '\n';
+        return ! outFreqStream.bad();
+    } );
+
+    if (outFreqStream.bad())
         return false;
+
+    // Dump the key map, sorted by key as it was when it was an ordered map.
+    std::vector<const strdetailsMap::Slot*> keys;
+    m_pKeyMap->sortedSlots(keys);
+    for (const strdetailsMap::Slot* pSlot : keys)
+    {
+        outKeyStream << pSlot->key << ms_FieldSeparator << pSlot->value.frequency << ms_FieldSeparator;
+        if (pSlot->value.backend < knownBackends)
+            outKeyStream << ms_BackendReference << pSlot->value.backend;
+        else // interned after the header was written
+            outKeyStream << m_pBackends->getUrl(pSlot->value.backend);
+        outKeyStream << ms_FieldSeparator << pSlot->value.port << '\n';
     }
 
-    outKeyFile.close();
-    return true;
+    return ! outKeyStream.bad();
 }
 
 bool MapManager::restoreRequest(const std::string& keyFilename, const std::string& freqFilename)
@@ -257,56 +378,92 @@ bool MapManager::restoreRequest(const std::string& keyFilename, const std::strin
         return false;
     }
 
+    // Files written before the backend dictionary have no header, and full urls in every line.
+    std::vector<uint32_t> backendIds;
+    const bool hasBackends = BackendDictionary::hasHeader(inKeyFile);
+    if (hasBackends && ! m_pBackends->read(inKeyFile, backendIds))
+    {
+        logError(keyFilename, "reading");
+        return false;
+    }
+
+    if (! restoreRequest(inKeyFile, inFreqFile, hasBackends ? &backendIds : nullptr))
+    {
+        logError(inKeyFile.eof() ? freqFilename : keyFilename, "reading");
+        inKeyFile.close();
+        inFreqFile.close();
+        return false;
+    }
+
+    inFreqFile.close();
+    inKeyFile.close();
+    return true;
+}
+
+bool MapManager::restoreRequest( std::istream& inKeyStream, std::istream& inFreqStream,
+                                 const std::vector<uint32_t>* pBackendIds )
+{
     std::string sKey, sOrderNum, sUrl, sPort;
+    uint32_t backend = 0;
 
     std::unique_lock<std::mutex>  lock(m_mapMutex);
     m_writingData = 1;
 
+    // Neither the ranking nor any published copy may point into the key map arena when it is cleared.
+    m_pRanking->clear();
+    publishTopKeys();
+    m_topKeys.synchronize();
     if (m_pKeyMap->size() > 0) m_pKeyMap->clear();
-    while (!inKeyFile.eof())
+    while (!inKeyStream.eof())
     {
-        std::getline(inKeyFile, sKey, ms_FieldSeparator);
-        std::getline(inKeyFile, sOrderNum, ms_FieldSeparator);
-        std::getline(inKeyFile, sUrl, ms_FieldSeparator);
-        std::getline(inKeyFile, sPort);
-        if (inKeyFile.eof())
+        std::getline(inKeyStream, sKey, ms_FieldSeparator);
+        std::getline(inKeyStream, sOrderNum, ms_FieldSeparator);
+        std::getline(inKeyStream, sUrl, ms_FieldSeparator);
+        std::getline(inKeyStream, sPort);
+        if (inKeyStream.eof())
             break;
 
-        if (inKeyFile.fail())
+        if (inKeyStream.fail() || ! resolveBackend(sUrl, pBackendIds, backend))
         {
-            logError(keyFilename, "reading");
-            inKeyFile.close();
-            inFreqFile.close();
+            publishTopKeys();
+            m_writingData = 0;
+            m_mapCondition.notify_one();
             return false;
         }
 
-        m_pKeyMap->insert( m_pKeyMap->end(),
-                           {sKey, KeyDetails(sUrl, unsigned(std::stoi(sPort)), std::stoul(sOrderNum))} );
+        m_pKeyMap->tryEmplace(sKey, backend, unsigned(std::stoi(sPort)), std::stoul(sOrderNum));
     }
-    inKeyFile.close();
 
-    if (m_pFrequencyMap->size() > 0) m_pFrequencyMap->clear();
-    while (!inFreqFile.eof())
+    while (!inFreqStream.eof())
     {
-        std::getline(inFreqFile, sOrderNum, ms_FieldSeparator);
-        std::getline(inFreqFile, sKey);
-        if (inFreqFile.eof())
+        std::getline(inFreqStream, sOrderNum, ms_FieldSeparator);
+        std::getline(inFreqStream, sKey);
+        if (inFreqStream.eof())
             break;
 
-        if (inFreqFile.fail())
+        if (inFreqStream.fail())
         {
-            logError(keyFilename, "reading");
-            inKeyFile.close();
-            inFreqFile.close();
+            publishTopKeys();
+            m_writingData = 0;
+            m_mapCondition.notify_one();
             return false;
         }
 
-        m_pFrequencyMap->insert({std::stoul(sOrderNum), sKey});
+        // A ranked key missing from the key file is added with the frequency of the ranking.
+        std::pair<strdetailsMap::Slot*, bool> itKeys = m_pKeyMap->tryEmplace(sKey);
+        if (itKeys.second)
+        {
+            itKeys.first->value.backend = m_pBackends->intern(std::string());
+            itKeys.first->value.frequency = std::stoul(sOrderNum);
+        }
+        if (itKeys.first->value.rank == nullptr)
+            rankKey(itKeys.first->key, itKeys.first->value);
     }
 
+    publishTopKeys();
+
     m_writingData = 0;
     m_mapCondition.notify_one();
-    inFreqFile.close();
     return true;
 }
 
@@ -320,33 +477,28 @@ void MapManager::purge(unsigned short newFrequencyMapLength) // purge n , N <= n
     std::lock_guard<std::mutex> lock(m_mapMutex);
     m_writingData = 1;
 
-    strdetailsIterator itKeys = m_pKeyMap->begin();
-    strdetailsIterator itKeyEnd = m_pKeyMap->end();
-    ulongstrMap::reverse_iterator itRevRanking = m_pFrequencyMap->rbegin();
-    ulongstrMap::reverse_iterator itRevRankingEnd = m_pFrequencyMap->rend();
-    while (itRevRanking != itRevRankingEnd && i < n)
-    {
-        std::string key(itRevRanking->second);
-        itKeys = m_pKeyMap->find(key);
-        if (itKeys == itKeyEnd) // should never happen
+    // Keep the top n keys in a fresh key map, drop the remaining ones from the ranking.
+    m_pRanking->forEachDescending( [&](Ranking::Node& node) {
+        if (i++ < n)
         {
-            m_pFrequencyMap->erase(--itRevRanking.base()); // erase the orphan key
-            std::cerr << "WARNING: Erasing orphan key from the ranking: " << key << std::endl;
+            const KeyDetails* pDetails = m_pKeyMap->find(node.item.key);
+            strdetailsMap::Slot* pSlot = pNewkeyMap->tryEmplace(node.item.key, *pDetails).first;
+            node.item.key = pSlot->key; // the old arena goes away with the old key map
         }
         else
         {
-            pNewkeyMap->insert(std::make_pair(key, itKeys->second));
+            m_pRanking->remove(&node);
         }
+        return true;
+    } );
 
-        ++i; ++itRevRanking;
-    }
-
-    if (itRevRanking != itRevRankingEnd) // There are still more elements in "the ranking table".
-        m_pFrequencyMap->erase(m_pFrequencyMap->begin(), --itRevRanking.base()); // purge them
-
-    if(m_pKeyMap) delete m_pKeyMap;
+    strdetailsMap* pOldKeyMap = m_pKeyMap;
     m_pKeyMap = pNewkeyMap;
 
+    publishTopKeys();
+    m_topKeys.synchronize(); // no reader left on the old arena
+    if(pOldKeyMap) delete pOldKeyMap;
+
     m_writingData = 0;
     m_mapCondition.notify_one();
 }
@@ -356,9 +508,17 @@ void MapManager::zap()
     std::lock_guard<std::mutex> lock(m_mapMutex);
     m_writingData = 1;
 
-    m_pFrequencyMap->clear();
+    m_pRanking->clear();
+    publishTopKeys();
+    m_topKeys.synchronize();
     m_pKeyMap->clear();
 
     m_writingData = 0;
     m_mapCondition.notify_one();
 }
+
+std::size_t MapManager::memoryUsage()
+{
+    std::lock_guard<std::mutex> lock(m_mapMutex);
+    return m_pKeyMap->memoryUsage() + (m_ownsBackends ? m_pBackends->memoryUsage() : 0);
+}
@@ -0,0 +1,213 @@
+/**
+ * @file MessagePool.cpp
+ * @brief MessagePool implementation. Lock free fixed size block pool for Message objects.
+ * @author Guillermo M. Paris
+ * @date 2026-10-18
+ */
+
+#include <new>
+#include "Message.h"
+#include "MessagePool.h"
+
+namespace
+{
+    constexpr std::size_t roundUp(std::size_t n, std::size_t to) { return (n + to - 1) / to * to; }
+
+    constexpr std::size_t ms_BlockSize = roundUp(sizeof(Message), alignof(Message));
+}
+
+static_assert(sizeof(Message) >= 3 * sizeof(void*), "a free block holds its chain links");
+
+std::atomic<MessagePool::Block*> MessagePool::ms_shared(nullptr);
+std::atomic<int64_t>             MessagePool::ms_sharedBlocks(0);
+std::atomic<uint64_t>            MessagePool::ms_hits(0);
+std::atomic<uint64_t>            MessagePool::ms_misses(0);
+std::atomic<uint64_t>            MessagePool::ms_blocks(0);
+std::atomic<uint64_t>            MessagePool::ms_released(0);
+
+// Free blocks of one thread: the chain being filled by release() and the chains taken from
+// the shared stack or the global allocator. Whatever is left when the thread ends is handed over.
+class MessagePool::ThreadCache
+{
+public:
+    ~ThreadCache()
+    {
+        handOver();
+        while (Block* chain = m_chains)
+        {
+            m_chains = chain->nextChain;
+            m_head = chain;
+            m_headCount = chain->count;
+            handOver();
+        }
+    }
+
+    Block* pop()
+    {
+        if (m_head == nullptr)
+        {
+            if (m_chains == nullptr) return nullptr;
+
+            m_head = m_chains;
+            m_headCount = m_head->count;
+            m_chains = m_head->nextChain;
+        }
+
+        Block* b = m_head;
+        m_head = b->next;
+        --m_headCount;
+        return b;
+    }
+
+    // Returns the length of the chain being filled.
+    std::size_t push(Block* b)
+    {
+        b->next = m_head;
+        m_head = b;
+        return ++m_headCount;
+    }
+
+    // Takes a stack of chains. Returns how many blocks they hold.
+    std::size_t adopt(Block* chains)
+    {
+        if (chains == nullptr) return 0;
+
+        std::size_t n = chains->count;
+        Block* last = chains;
+        for (; last->nextChain != nullptr; last = last->nextChain)
+            n += last->nextChain->count;
+
+        last->nextChain = m_chains;
+        m_chains = chains;
+        return n;
+    }
+
+    // The chain being filled goes to the shared stack, or to the global allocator when the
+    // stack is full.
+    void handOver()
+    {
+        Block* chain = m_head;
+        if (chain == nullptr) return;
+
+        if (ms_sharedBlocks.load(std::memory_order_relaxed) + int64_t(m_headCount) <= MESSAGEPOOL_SHARED_BLOCKS)
+        {
+            chain->count = m_headCount;
+            pushShared(chain);
+        }
+        else
+        {
+            ms_released.fetch_add(m_headCount, std::memory_order_relaxed);
+            while (chain != nullptr)
+            {
+                Block* next = chain->next;
+                ::operator delete(chain);
+                chain = next;
+            }
+        }
+
+        m_head = nullptr;
+        m_headCount = 0;
+    }
+
+private:
+    Block*      m_head = nullptr;
+    std::size_t m_headCount = 0;
+    Block*      m_chains = nullptr;
+};
+
+MessagePool::ThreadCache& MessagePool::threadCache()
+{
+    thread_local ThreadCache cache;
+    return cache;
+}
+
+std::size_t MessagePool::blockSize()
+{
+    return ms_BlockSize;
+}
+
+void* MessagePool::allocate(std::size_t size)
+{
+    if (size > ms_BlockSize) // a derived class: not pooled
+        return ::operator new(size);
+
+    ThreadCache& cache = threadCache();
+    Block* b = cache.pop();
+    if (b == nullptr)
+    {
+        if (std::size_t n = cache.adopt(takeShared()))
+            ms_sharedBlocks.fetch_sub(int64_t(n), std::memory_order_relaxed);
+        b = cache.pop();
+    }
+
+    if (b != nullptr)
+    {
+        ms_hits.fetch_add(1, std::memory_order_relaxed);
+        return b;
+    }
+
+    ms_misses.fetch_add(1, std::memory_order_relaxed);
+    cache.adopt(newBlocks());
+    return cache.pop();
+}
+
+void MessagePool::release(void* p, std::size_t size)
+{
+    if (p == nullptr) return;
+
+    if (size > ms_BlockSize)
+    {
+        ::operator delete(p);
+        return;
+    }
+
+    ThreadCache& cache = threadCache();
+    if (cache.push(static_cast<Block*>(p)) >= MESSAGEPOOL_CHAIN_BLOCKS) // usually the consumer thread: back to the producers
+        cache.handOver();
+}
+
+void MessagePool::pushShared(Block* chain)
+{
+    const std::size_t n = chain->count;
+    Block* top = ms_shared.load(std::memory_order_relaxed);
+    do
+    {
+        chain->nextChain = top;
+    }
+    while (! ms_shared.compare_exchange_weak(top, chain, std::memory_order_release, std::memory_order_relaxed));
+
+    ms_sharedBlocks.fetch_add(int64_t(n), std::memory_order_relaxed);
+}
+
+MessagePool::Block* MessagePool::takeShared()
+{
+    if (ms_shared.load(std::memory_order_relaxed) == nullptr)
+        return nullptr;
+
+    return ms_shared.exchange(nullptr, std::memory_order_acquire);
+}
+
+MessagePool::Block* MessagePool::newBlocks()
+{
+    // One by one, so each of them can go back to the global allocator on its own.
+    Block* head = nullptr;
+    for (std::size_t i = 0; i < MESSAGEPOOL_REFILL_BLOCKS; ++i)
+    {
+        Block* b = static_cast<Block*>(::operator new(ms_BlockSize));
+        b->next = head;
+        head = b;
+    }
+
+    head->nextChain = nullptr;
+    head->count = MESSAGEPOOL_REFILL_BLOCKS;
+    ms_blocks.fetch_add(MESSAGEPOOL_REFILL_BLOCKS, std::memory_order_relaxed);
+    return head;
+}
+
+MessagePool::Stats MessagePool::getStats()
+{
+    return { ms_hits.load(std::memory_order_relaxed),
+             ms_misses.load(std::memory_order_relaxed),
+             ms_blocks.load(std::memory_order_relaxed),
+             ms_released.load(std::memory_order_relaxed) };
+}
@@ -0,0 +1,150 @@
+/**
+ * @file PartitionedMessageQueue.cpp
+ * @brief PartitionedMessageQueue implementation. Key hash routed set of ThreadedMessageQueue.
+ * @author Guillermo M. Paris
+ * @date 2026-10-18
+ */
+
+#include <cassert>
+#include <functional>
+#include "PartitionedMessageQueue.h"
+
+PartitionedMessageQueue::PartitionedMessageQueue( unsigned int partitions, size_t initialSize,
+                                                  size_t batchSize /* = DEFAULT_KEY_BATCH_SIZE */ )
+{
+    if (partitions == 0) partitions = 1;
+
+    m_partitions.reserve(partitions);
+    for (unsigned int i = 0; i < partitions; ++i)
+        m_partitions.push_back(new ThreadedMessageQueue(initialSize / partitions, batchSize));
+}
+
+PartitionedMessageQueue::~PartitionedMessageQueue()
+{
+    for (ThreadedMessageQueue* pPartition : m_partitions)
+        delete pPartition;
+}
+
+void PartitionedMessageQueue::setConsumer(IMapManager* pMgr)
+{
+    for (ThreadedMessageQueue* pPartition : m_partitions)
+        pPartition->setConsumer(pMgr);
+}
+
+bool PartitionedMessageQueue::isEmpty()
+{
+    for (ThreadedMessageQueue* pPartition : m_partitions)
+        if (! pPartition->isEmpty())
+            return false;
+
+    return true;
+}
+
+bool PartitionedMessageQueue::start()
+{
+    for (ThreadedMessageQueue* pPartition : m_partitions)
+        if (! pPartition->start())
+            return false;
+
+    return true;
+}
+
+bool PartitionedMessageQueue::stop()
+{
+    bool stopped = true;
+    for (ThreadedMessageQueue* pPartition : m_partitions)
+        stopped = pPartition->stop() && stopped;
+
+    return stopped;
+}
+
+unsigned int PartitionedMessageQueue::getPartition(const std::string& key) const
+{
+    return keyPartition(std::hash<std::string>{}(key), m_partitions.size());
+}
+
+bool PartitionedMessageQueue::push(Message* pMsg)
+{
+    assert(pMsg != nullptr);
+
+    if (pMsg->getCommand() == Message::Command::addKey)
+        return m_partitions[getPartition(pMsg->getStringRef1())]->push(pMsg);
+    else if (pMsg->getCommand() == Message::Command::addKeys)
+        return pushBulk(pMsg) > 0;
+    else
+        return m_partitions[0]->push(pMsg);
+}
+
+size_t PartitionedMessageQueue::pushKeys(Message* pMsg, size_t keys)
+{
+    assert(pMsg != nullptr);
+
+    if (pMsg->getCommand() == Message::Command::addKeys)
+        return pushBulk(pMsg);
+    else
+        return push(pMsg) ? keys : 0;
+}
+
+size_t PartitionedMessageQueue::pushBulk(Message* pMsg)
+{
+    // The record lines are copied as they are into one bulk per partition: only the key of each
+    // one is looked for, to route it, and its consumer parses it once.
+    std::vector<std::string> bodies(m_partitions.size());
+    std::vector<uint32_t> records(m_partitions.size(), 0);
+    std::string_view body = pMsg->getStringRef1();
+    while (! body.empty())
+    {
+        const std::string_view record = nextKeyRecord(body);
+        const std::string_view key = record.substr(0, record.find(','));
+        if (key.empty())
+            continue;
+
+        const unsigned int partition = keyPartition(std::hash<std::string_view>{}(key), m_partitions.size());
+        bodies[partition].append(record.data(), record.size()).append(1, '\n');
+        records[partition]++;
+    }
+
+    // Every partition admits its part, and may shed it (dropNewest, sample): the records of the
+    // queued parts are returned, a retry of the whole bulk would count them twice.
+    const uint8_t weight = pMsg->getByte();
+    delete pMsg;
+    size_t queued = 0;
+    for (size_t i = 0; i < m_partitions.size(); i++)
+        if (records[i] > 0 && m_partitions[i]->push(new Message(Message::Command::addKeys, std::move(bodies[i]),
+                                                                std::string(), weight, 0, records[i])))
+            queued += records[i];
+
+    return queued;
+}
+
+void PartitionedMessageQueue::setOverloadPolicy(size_t capacity, OverloadGuard::Policy policy, unsigned sampleRate)
+{
+    const size_t partitionCapacity = (capacity + m_partitions.size() - 1) / m_partitions.size();
+    for (ThreadedMessageQueue* pPartition : m_partitions)
+        pPartition->setOverloadPolicy(partitionCapacity, policy, sampleRate);
+}
+
+OverloadGuard::Stats PartitionedMessageQueue::getOverloadStats()
+{
+    OverloadGuard::Stats total = {0, 0, 0, 0, 0};
+    for (ThreadedMessageQueue* pPartition : m_partitions)
+    {
+        OverloadGuard::Stats stats = pPartition->getOverloadStats();
+        total.capacity += stats.capacity;
+        total.size += stats.size;
+        total.dropped += stats.dropped;
+        total.sampled += stats.sampled;
+        total.blocked += stats.blocked;
+    }
+
+    return total;
+}
+
+QueueStats PartitionedMessageQueue::getQueueStats()
+{
+    LogLinearHistogram latency, depth;
+    for (ThreadedMessageQueue* pPartition : m_partitions)
+        pPartition->addQueueHistograms(latency, depth);
+
+    return {latency.getSummary(TickClock::nanosecondsPerTick()), depth.getSummary()};
+}
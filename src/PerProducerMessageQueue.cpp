@@ -0,0 +1,249 @@
+/**
+ * @file PerProducerMessageQueue.cpp
+ * @brief PerProducerMessageQueue implementation. One SPSC ring per producer thread, round robin
+ *        output thread.
+ * @author Guillermo M. Paris
+ * @date 2026-10-18
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+#include "PerProducerMessageQueue.h"
+
+namespace
+{
+    std::atomic<uint64_t> ms_nextQueueId(1);
+}
+
+// The rings of one producer thread, one per queue it pushed to. The rings are shared with
+// their queues: when the thread ends they are left for other threads, or freed if the queue
+// is already gone.
+class PerProducerMessageQueue::ProducerRings
+{
+public:
+    ~ProducerRings()
+    {
+        for (Entry& entry : m_entries)
+            entry.ring->owned.store(false, std::memory_order_release);
+    }
+
+    Ring* find(uint64_t queueId)
+    {
+        if (m_pLast != nullptr && m_lastId == queueId)
+            return m_pLast;
+
+        for (Entry& entry : m_entries)
+        {
+            if (entry.queueId == queueId)
+            {
+                m_lastId = queueId;
+                m_pLast = entry.ring.get();
+                return m_pLast;
+            }
+        }
+
+        return nullptr;
+    }
+
+    void add(uint64_t queueId, const std::shared_ptr<Ring>& ring)
+    {
+        // Rings of queues already destroyed are only held here.
+        m_entries.erase(std::remove_if(m_entries.begin(), m_entries.end(),
+                                       [](const Entry& entry) { return entry.ring.use_count() == 1; }),
+                        m_entries.end());
+        m_entries.push_back({queueId, ring});
+        m_lastId = queueId;
+        m_pLast = ring.get();
+    }
+
+private:
+    struct Entry
+    {
+        uint64_t              queueId;
+        std::shared_ptr<Ring> ring;
+    };
+
+    std::vector<Entry> m_entries;
+    uint64_t           m_lastId = 0;
+    Ring*              m_pLast = nullptr;
+};
+
+PerProducerMessageQueue::PerProducerMessageQueue(size_t ringSlots, size_t batchSize)
+    : m_id(ms_nextQueueId.fetch_add(1, std::memory_order_relaxed))
+    , m_ringSlots(ringSlots > 0 ? ringSlots : 1), m_batchSize(batchSize > 0 ? batchSize : 1)
+    , m_ringNumber(0), m_running(false), m_consumer(nullptr)
+{
+    for (std::atomic<Ring*>& ring : m_rings)
+        ring.store(nullptr, std::memory_order_relaxed);
+}
+
+PerProducerMessageQueue::~PerProducerMessageQueue()
+{
+    for (const std::shared_ptr<Ring>& ring : m_owners)
+    {
+        Message* pm = nullptr;
+        while (ring->pop(pm))
+            delete pm;
+    }
+}
+
+bool PerProducerMessageQueue::isEmpty()
+{
+    const size_t rings = m_ringNumber.load(std::memory_order_acquire);
+    for (size_t i = 0; i < rings; i++)
+        if (! m_rings[i].load(std::memory_order_acquire)->empty())
+            return false;
+
+    return true;
+}
+
+bool PerProducerMessageQueue::start()
+{
+    if (m_consumer == nullptr) return false;
+
+    m_running = true;
+    m_poper = std::thread([this]{run();});
+    return true;
+}
+
+bool PerProducerMessageQueue::stop()
+{
+    m_running = false;
+    m_parker.wakeUp();
+    m_poper.join();
+    return true; // this implementation always return true.
+}
+
+PerProducerMessageQueue::Ring* PerProducerMessageQueue::ring()
+{
+    thread_local ProducerRings rings;
+    Ring* pRing = rings.find(m_id);
+    if (pRing != nullptr)
+        return pRing;
+
+    std::shared_ptr<Ring> owner = registerRing();
+    rings.add(m_id, owner);
+    return owner.get();
+}
+
+std::shared_ptr<PerProducerMessageQueue::Ring> PerProducerMessageQueue::registerRing()
+{
+    std::lock_guard<std::mutex> lock(m_registerMutex);
+
+    // A ring left by an ended thread: its messages keep their order.
+    for (const std::shared_ptr<Ring>& owner : m_owners)
+    {
+        bool owned = false;
+        if (owner->owned.compare_exchange_strong(owned, true, std::memory_order_acquire))
+            return owner;
+    }
+
+    const size_t n = m_ringNumber.load(std::memory_order_relaxed);
+    if (n >= PRODUCER_RINGS_MAX)
+        throw std::length_error("PerProducerMessageQueue: too many producer threads");
+
+    m_owners.push_back(std::make_shared<Ring>(m_ringSlots));
+    m_rings[n].store(m_owners.back().get(), std::memory_order_release);
+    m_ringNumber.store(n + 1, std::memory_order_release);
+    return m_owners.back();
+}
+
+bool PerProducerMessageQueue::push(Message* pMsg)
+{
+    assert(pMsg != nullptr);
+
+    Ring* pRing = ring();
+    while (! pRing->push(pMsg))
+    {
+        if (! m_running)
+        {
+            delete pMsg;
+            return false;
+        }
+        std::this_thread::yield(); // full: the output thread is behind
+    }
+
+    m_parker.notify();
+    return true;
+}
+
+void PerProducerMessageQueue::run()
+{
+    std::vector<Message*> messages;
+    std::vector<KeyEvent> events;
+    messages.reserve(m_batchSize);
+    events.reserve(m_batchSize);
+
+    while (m_running)
+    {
+        size_t taken = 0;
+        const size_t rings = m_ringNumber.load(std::memory_order_acquire);
+        for (size_t i = 0; i < rings && m_running; i++)
+            taken += drain(*m_rings[i].load(std::memory_order_acquire), messages, events);
+
+        if (taken == 0) // every ring empty: the batch is over
+        {
+            if (! messages.empty())
+                flushKeys(messages, events);
+            else
+                m_parker.wait([this]{ return ! isEmpty() || ! m_running; });
+        }
+    }
+
+    flushKeys(messages, events);
+}
+
+size_t PerProducerMessageQueue::drain(Ring& ring, std::vector<Message*>& messages, std::vector<KeyEvent>& events)
+{
+    size_t taken = 0;
+    Message* pm = nullptr;
+    while (taken < m_batchSize && m_running && ring.pop(pm))
+    {
+        ++taken;
+        if (pm->getCommand() == Message::Command::addKey || pm->getCommand() == Message::Command::addKeys)
+        {
+            messages.push_back(pm);
+            if (pm->getCommand() == Message::Command::addKeys) // its records, viewing its body
+                parseKeyRecords(pm->getStringRef1(), events);
+            else
+                events.push_back({pm->getStringRef1(), pm->getStringRef2(), pm->getNumber(), pm->getKeyCount()});
+            if (events.size() >= m_batchSize)
+                flushKeys(messages, events);
+            continue;
+        }
+
+        // Keys queued before any other command are applied first.
+        flushKeys(messages, events);
+
+        switch (pm->getCommand())
+        {
+        case Message::Command::setRankingLength:
+            m_consumer->setTopKeyReportBaseSize(pm->getShort());
+            break;
+
+        case Message::Command::stop:
+            m_running = false;
+            break;
+
+        default:
+            break;
+        }
+
+        delete pm;
+    }
+
+    return taken;
+}
+
+void PerProducerMessageQueue::flushKeys(std::vector<Message*>& messages, std::vector<KeyEvent>& events)
+{
+    if (messages.empty()) return;
+
+    m_consumer->addOrUpdateKeys(events.data(), events.size());
+    for (Message* pm : messages)
+        delete pm;
+
+    messages.clear();
+    events.clear();
+}
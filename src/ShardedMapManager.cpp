@@ -0,0 +1,300 @@
+/**
+ * @file ShardedMapManager.cpp
+ * @brief ShardedMapManager implementation. Hash partitioned set of MapManager shards.
+ * @author Guillermo M. Paris
+ * @date 2026-10-18
+ */
+
+#include <algorithm>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include "ShardedMapManager.h"
+
+ShardedMapManager::ShardedMapManager()
+    : ShardedMapManager(ms_DefaultShardNumber, DEFAULT_TOPKEY_REPORTSIZE, MAX_TOPKEY_REPORTSIZE)
+{
+}
+
+ShardedMapManager::ShardedMapManager( unsigned int shards, unsigned int n,
+                                      unsigned int m /* = 0 */, unsigned int logLevel /* = 0 */)
+    : m_verbosity(logLevel)
+    , m_baseReportElementNumber(n)
+    , m_maxReportElementNumber(m > n + MIN_GAP_MAX_DEFAULT ? m : n + MIN_GAP_MAX_DEFAULT)
+    , m_hotThreshold(0)
+    , m_hotThresholdStale(false)
+{
+    if (shards == 0) shards = 1;
+
+    m_shards.reserve(shards);
+    for (unsigned int i = 0; i < shards; ++i)
+        m_shards.push_back(new MapManager(n, m, logLevel, &m_backends));
+}
+
+ShardedMapManager::~ShardedMapManager()
+{
+    for (MapManager* pShard : m_shards)
+        delete pShard;
+}
+
+unsigned int ShardedMapManager::getShardIndex(const std::string& key)
+{
+    return getShardIndex(std::hash<std::string>{}(key));
+}
+
+unsigned int ShardedMapManager::getShardIndex(std::size_t h)
+{
+    return keyPartition(h, m_shards.size()); // same routing than PartitionedMessageQueue
+}
+
+void ShardedMapManager::addOrUpdateKey(const std::string& key, const std::string& url, unsigned int nPort)
+{
+    m_shards[getShardIndex(key)]->addOrUpdateKey(key, url, nPort);
+    m_hotThresholdStale.store(true, std::memory_order_release);
+}
+
+void ShardedMapManager::addOrUpdateKeys(const KeyEvent* pEvents, std::size_t n)
+{
+    // Aggregated once, then every shard gets its part of the batch under one lock acquisition.
+    // std::hash of a string_view is the one of the equal string, so routing matches getShardIndex(key).
+    thread_local KeyBatch batch;
+    thread_local std::vector<std::vector<KeyBatch::Entry>> routed;
+    batch.aggregate(pEvents, n);
+
+    if (routed.size() < m_shards.size())
+        routed.resize(m_shards.size());
+
+    for (const KeyBatch::Entry& entry : batch)
+        routed[getShardIndex(entry.hash)].push_back(entry);
+
+    for (std::size_t i = 0; i < m_shards.size(); ++i)
+    {
+        m_shards[i]->addOrUpdateKeys(routed[i].data(), routed[i].size());
+        routed[i].clear();
+    }
+
+    m_hotThresholdStale.store(true, std::memory_order_release);
+}
+
+void ShardedMapManager::setTopKeyReportBaseSize(unsigned short newBase)
+{
+    m_baseReportElementNumber = (newBase > m_maxReportElementNumber ? m_maxReportElementNumber : newBase);
+
+    for (MapManager* pShard : m_shards)
+        pShard->setTopKeyReportBaseSize(newBase);
+}
+
+unsigned ShardedMapManager::getTopKeyReportActualSize()
+{
+    unsigned int total = 0;
+    for (MapManager* pShard : m_shards)
+        total += pShard->getTopKeyReportActualSize();
+
+    return total < m_maxReportElementNumber ? total : m_maxReportElementNumber;
+}
+
+unsigned ShardedMapManager::getTotalKeyNumber()
+{
+    unsigned int total = 0;
+    for (MapManager* pShard : m_shards)
+        total += pShard->getTotalKeyNumber();
+
+    return total;
+}
+
+void ShardedMapManager::getTopHotkeys(KeyFrequencyVector& vec)
+{
+    mergeRankings(vec, m_baseReportElementNumber);
+}
+
+bool ShardedMapManager::isHotKey(const std::string& key)
+{
+    // A key out of its own shard ranking can never be in the global one.
+    const uint64_t count = m_shards[getShardIndex(key)]->getHotKeyCount(key);
+    if (count == 0)
+        return false;
+
+    // Recomputed once after any number of updates: by the first reader that finds it stale.
+    if (m_hotThresholdStale.load(std::memory_order_acquire))
+        refreshHotThreshold();
+
+    return count >= m_hotThreshold.load(std::memory_order_relaxed);
+}
+
+void ShardedMapManager::refreshHotThreshold()
+{
+    // Refreshes never overlap: an older one can not store its threshold after a newer one.
+    // The flag is cleared before the rankings are read, an update meanwhile sets it again.
+    std::lock_guard<std::mutex> lock(m_hotThresholdMutex);
+    if (! m_hotThresholdStale.exchange(false, std::memory_order_acq_rel)) // refreshed meanwhile
+        return;
+
+    // Frequencies only: nothing is allocated once these buffers reached S * M elements.
+    thread_local KeyCountVector ranking;
+    thread_local std::vector<uint64_t> counts;
+    ranking.reserve(m_maxReportElementNumber);
+    counts.clear();
+    for (MapManager* pShard : m_shards)
+    {
+        MapManager::TopKeysGuard guard = pShard->pinTopKeys();
+        pShard->getTopKeys(guard, ranking, m_maxReportElementNumber);
+        for (const KeyCount& kc : ranking)
+            counts.push_back(kc.count);
+    }
+
+    // Fewer ranked keys than M: every one of them is in the global ranking.
+    uint64_t threshold = 0;
+    if (counts.size() >= m_maxReportElementNumber)
+    {
+        auto mth = counts.begin() + (m_maxReportElementNumber - 1);
+        std::nth_element(counts.begin(), mth, counts.end(), std::greater<uint64_t>());
+        threshold = *mth;
+    }
+
+    m_hotThreshold.store(threshold, std::memory_order_relaxed);
+}
+
+void ShardedMapManager::mergeRankings(KeyFrequencyVector& vec, unsigned int count)
+{
+    // Every key lives in exactly one shard, so the global top "count" is always
+    // contained in the union of the top "count" of each shard.
+    KeyFrequencyVector all;
+    all.reserve(count * m_shards.size());
+    for (MapManager* pShard : m_shards)
+        pShard->getRanking(all, count);
+
+    std::vector<std::pair<unsigned long, std::size_t>> order;
+    order.reserve(all.size());
+    for (std::size_t i = 0; i < all.size(); ++i)
+        order.emplace_back(std::stoul(all[i].frequency), i);
+
+    std::stable_sort( order.begin(), order.end(),
+                      [](const auto& a, const auto& b) { return a.first > b.first; } );
+
+    if (order.size() > count) order.resize(count);
+
+    vec.reserve(vec.size() + order.size());
+    for (const auto& o : order)
+        vec.push_back(std::move(all[o.second]));
+}
+
+bool ShardedMapManager::backupRequest(const std::string& keyFilename, const std::string& freqFilename)
+{
+    static const char* szMsg1 = "Error ";
+    static const char* szMsg2 =  " output file: ";
+    static const char* szMsg3 = " . Backup operation aborted.\n";
+    auto logError = [&](const std::string& fname, const char* verb) {
+        std::cerr << szMsg1 << verb << szMsg2 << fname << szMsg3 << std::endl;
+    };
+
+    std::ofstream  outKeyFile(keyFilename);
+    if (outKeyFile.bad())
+    {
+        logError(keyFilename, "opening");
+        return false;
+    }
+
+    std::ofstream  outFreqFile(freqFilename);
+    if (outFreqFile.bad())
+    {
+        logError(freqFilename, "opening");
+        return false;
+    }
+
+    // The shared backend dictionary goes once, in the header of the key file.
+    // Shards are dumped one after the other, so just one shard is locked at any time.
+    uint32_t knownBackends = m_backends.write(outKeyFile);
+    for (MapManager* pShard : m_shards)
+    {
+        if (! pShard->backupRequest(outKeyFile, outFreqFile, knownBackends))
+        {
+            logError(outFreqFile.bad() ? freqFilename : keyFilename, "writing");
+            return false;
+        }
+    }
+
+    outFreqFile.close();
+    outKeyFile.close();
+    return true;
+}
+
+bool ShardedMapManager::restoreRequest(const std::string& keyFilename, const std::string& freqFilename)
+{
+    static const char* szMsg1 = "Error ";
+    static const char* szMsg2 =  " input file: ";
+    static const char* szMsg3 = " . Restore operation aborted.\n";
+    auto logError = [&](const std::string& fname, const char* verb) {
+        std::cerr << szMsg1 << verb << szMsg2 << fname << szMsg3 << std::endl;
+    };
+
+    std::ifstream  inKeyFile(keyFilename);
+    if (inKeyFile.fail())
+    {
+        logError(keyFilename, "opening");
+        return false;
+    }
+
+    std::ifstream  inFreqFile(freqFilename);
+    if (inFreqFile.fail())
+    {
+        logError(freqFilename, "opening");
+        return false;
+    }
+
+    std::vector<uint32_t> backendIds;
+    const bool hasBackends = BackendDictionary::hasHeader(inKeyFile);
+    if (hasBackends && ! m_backends.read(inKeyFile, backendIds))
+    {
+        logError(keyFilename, "reading");
+        return false;
+    }
+
+    // Records are routed by key, so a backup taken with another shard number restores fine.
+    const std::size_t shards = m_shards.size();
+    std::vector<std::stringstream> keyStreams(shards), freqStreams(shards);
+    std::string line;
+
+    while (std::getline(inKeyFile, line)) // key,frequency,url,port
+    {
+        std::string key(line, 0, line.find(ms_FieldSeparator));
+        keyStreams[getShardIndex(key)] << line << '\n';
+    }
+
+    while (std::getline(inFreqFile, line)) // frequency,key
+    {
+        std::size_t pos = line.find(ms_FieldSeparator);
+        std::string key(line, pos == std::string::npos ? line.size() : pos + 1);
+        freqStreams[getShardIndex(key)] << line << '\n';
+    }
+
+    for (std::size_t i = 0; i < shards; ++i)
+    {
+        const bool restored = m_shards[i]->restoreRequest( keyStreams[i], freqStreams[i],
+                                                            hasBackends ? &backendIds : nullptr );
+        m_hotThresholdStale.store(true, std::memory_order_release);
+        if (! restored)
+        {
+            logError(keyFilename, "reading");
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void ShardedMapManager::purge(unsigned short newFrequencyMapLength)
+{
+    for (MapManager* pShard : m_shards)
+        pShard->purge(newFrequencyMapLength);
+
+    m_hotThresholdStale.store(true, std::memory_order_release);
+}
+
+void ShardedMapManager::zap()
+{
+    for (MapManager* pShard : m_shards)
+        pShard->zap();
+
+    m_hotThresholdStale.store(true, std::memory_order_release);
+}
@@ -0,0 +1,319 @@
+/**
+ * @file SpaceSavingManager.cpp
+ * @brief SpaceSavingManager implementation. Bounded memory approximate heavy hitter tracker.
+ * @author Guillermo M. Paris
+ * @date 2026-10-18
+ */
+
+#include <fstream>
+#include <iostream>
+#include "SpaceSavingManager.h"
+
+SpaceSavingManager::SpaceSavingManager( unsigned int counters, unsigned int n,
+                                        unsigned int m /* = 0 */, unsigned int logLevel /* = 0 */)
+    : m_verbosity(logLevel)
+    , m_baseReportElementNumber(n)
+    , m_maxReportElementNumber(m > n + MIN_GAP_MAX_DEFAULT ? m : n + MIN_GAP_MAX_DEFAULT)
+    , m_streamLength(0)
+    , m_summary(counters > m_maxReportElementNumber ? counters : m_maxReportElementNumber)
+{
+    m_index.reserve(m_summary.capacity());
+}
+
+void SpaceSavingManager::addOrUpdateKey(const std::string& key, const std::string& url, unsigned int nPort)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    update(key, url, nPort, 1, 0);
+}
+
+void SpaceSavingManager::addOrUpdateKeys(const KeyEvent* pEvents, std::size_t n)
+{
+    // Duplicates become one weighted update. The buffers are reused by the thread.
+    thread_local KeyBatch batch;
+    thread_local std::string sKey, sUrl;
+    batch.aggregate(pEvents, n);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const KeyBatch::Entry& entry : batch)
+    {
+        sKey.assign(entry.key);
+        sUrl.assign(entry.url);
+        update(sKey, sUrl, entry.port, entry.count, 0);
+    }
+}
+
+void SpaceSavingManager::update( const std::string& key, const std::string& url, unsigned int nPort,
+                                 unsigned long weight, unsigned long error )
+{
+    m_streamLength += weight;
+
+    MonitoredIndex::iterator it = m_index.find(key);
+    if (it != m_index.end()) // monitored key: exact increment
+    {
+        Summary::Node* pNode = it->second;
+        pNode->item.url = url;
+        pNode->item.port = nPort;
+        m_summary.increment(pNode, weight);
+        return;
+    }
+
+    if (! m_summary.full())
+    {
+        Summary::Node* pNode = m_summary.insert(weight);
+        pNode->item.key = key;
+        pNode->item.url = url;
+        pNode->item.port = nPort;
+        pNode->item.error = error;
+        m_index.emplace(key, pNode);
+        return;
+    }
+
+    // Every counter is taken: the new key replaces the one with the lowest count, whose count
+    // it inherits as overestimation error. The index node is recycled, not reallocated.
+    Summary::Node* pVictim = m_summary.minNode();
+    unsigned long minCount = pVictim->count();
+
+    if (m_verbosity >= Verbosity::debug)
+        std::cout << "Key " << key << " replaces " << pVictim->item.key << " (count " << minCount << ").\n";
+
+    MonitoredIndex::node_type nh = m_index.extract(pVictim->item.key);
+    nh.key() = key;
+    m_index.insert(std::move(nh));
+
+    pVictim->item.key = key;
+    pVictim->item.url = url;
+    pVictim->item.port = nPort;
+    pVictim->item.error = minCount + error;
+    m_summary.increment(pVictim, weight);
+}
+
+void SpaceSavingManager::setTopKeyReportBaseSize(unsigned short newBase)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_baseReportElementNumber = (newBase > m_maxReportElementNumber ? m_maxReportElementNumber : newBase);
+}
+
+unsigned SpaceSavingManager::getTopKeyReportActualSize()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    unsigned int size = m_summary.size();
+    return size < m_maxReportElementNumber ? size : m_maxReportElementNumber;
+}
+
+unsigned SpaceSavingManager::getTotalKeyNumber()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_summary.size();
+}
+
+void SpaceSavingManager::getTopHotkeys(KeyFrequencyVector& vec)
+{
+    unsigned int index = 0;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_summary.forEachDescending( [&](Summary::Node& n) {
+        if (index++ == m_baseReportElementNumber) return false;
+        vec.push_back( KeyFrequency( std::string(n.item.key), std::to_string(n.count()),
+                                     std::to_string(n.item.error) ) );
+        return true;
+    } );
+}
+
+bool SpaceSavingManager::isInTop(const Summary::Node* pNode, unsigned int m, unsigned long* pNext)
+{
+    unsigned int index = 0;
+    unsigned long next = 0;
+    bool found = false;
+
+    m_summary.forEachDescending( [&](Summary::Node& n) {
+        if (index++ == m)
+        {
+            next = n.count();
+            return false;
+        }
+
+        found = found || &n == pNode;
+        return ! found || pNext != nullptr;
+    } );
+
+    if (pNext) *pNext = next;
+    return found;
+}
+
+bool SpaceSavingManager::isHotKey(const std::string& key)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    MonitoredIndex::iterator it = m_index.find(key);
+    if (it == m_index.end()) return false; // not monitored: its count is below getMaxError()
+
+    return isInTop(it->second, m_maxReportElementNumber);
+}
+
+bool SpaceSavingManager::isGuaranteedHotKey(const std::string& key)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    MonitoredIndex::iterator it = m_index.find(key);
+    if (it == m_index.end()) return false;
+
+    // Guaranteed when even its lowest possible frequency reaches the highest possible
+    // frequency of the first key out of the top M.
+    unsigned long next = 0;
+    const Summary::Node* pNode = it->second;
+    return isInTop(pNode, m_maxReportElementNumber, &next) && pNode->count() - pNode->item.error >= next;
+}
+
+unsigned long SpaceSavingManager::getMaxError()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_summary.full() ? m_summary.minCount() : 0;
+}
+
+unsigned long SpaceSavingManager::getStreamLength()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_streamLength;
+}
+
+bool SpaceSavingManager::backupRequest(const std::string& keyFilename, const std::string& freqFilename)
+{
+    static const char* szMsg1 = "Error ";
+    static const char* szMsg2 =  " output file: ";
+    static const char* szMsg3 = " . Backup operation aborted.\n";
+    auto logError = [&](const std::string& fname, const char* verb) {
+        std::cerr << szMsg1 << verb << szMsg2 << fname << szMsg3 << std::endl;
+    };
+
+    std::ofstream  outKeyFile(keyFilename);
+    if (outKeyFile.bad())
+    {
+        logError(keyFilename, "opening");
+        return false;
+    }
+
+    std::ofstream  outFreqFile(freqFilename);
+    if (outFreqFile.bad())
+    {
+        logError(freqFilename, "opening");
+        return false;
+    }
+
+    unsigned int index = 0;
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // Counters are dumped from the lowest count up, so restoring them is O(1) each one and
+    // keys sharing a count keep their replacement order.
+    // key,count,url,port,error
+    m_summary.forEachAscending( [&](Summary::Node& n) {
+        outKeyFile << n.item.key << ms_FieldSeparator << n.count() << ms_FieldSeparator << n.item.url
+                   << ms_FieldSeparator << n.item.port << ms_FieldSeparator << n.item.error << '\n';
+        return true;
+    } );
+
+    m_summary.forEachDescending( [&](Summary::Node& n) {
+        if (index++ == m_maxReportElementNumber) return false;
+        outFreqFile << n.count() << ms_FieldSeparator << n.item.key << '\n';
+        return true;
+    } );
+
+    if (outKeyFile.bad() || outFreqFile.bad())
+    {
+        logError(outFreqFile.bad() ? freqFilename : keyFilename, "writing");
+        return false;
+    }
+
+    return true;
+}
+
+bool SpaceSavingManager::restoreRequest(const std::string& keyFilename, const std::string& /* freqFilename */)
+{
+    static const char* szMsg1 = "Error ";
+    static const char* szMsg2 =  " input file: ";
+    static const char* szMsg3 = " . Restore operation aborted.\n";
+    auto logError = [&](const std::string& fname, const char* verb) {
+        std::cerr << szMsg1 << verb << szMsg2 << fname << szMsg3 << std::endl;
+    };
+
+    // The ranking is rebuilt from the counters: the frequency file is not needed.
+    std::ifstream  inKeyFile(keyFilename);
+    if (inKeyFile.fail())
+    {
+        logError(keyFilename, "opening");
+        return false;
+    }
+
+    // MapManager backups (key,count,url,port) are accepted too. Theirs start with a backend
+    // dictionary, and their key lines refer to its urls as "#id". When they have more keys than
+    // counters, the extra ones are folded in as weighted Space-Saving updates.
+    BackendDictionary backends;
+    std::vector<uint32_t> backendIds;
+    const bool hasBackends = BackendDictionary::hasHeader(inKeyFile);
+    if (hasBackends && ! backends.read(inKeyFile, backendIds))
+    {
+        logError(keyFilename, "reading");
+        return false;
+    }
+
+    // The whole file is parsed before the counters are touched: a malformed one leaves them as they are.
+    std::vector<std::pair<Monitored, unsigned long>> records; // key, url, port, error and count
+    std::string sKey, sOrderNum, sUrl, sPort, sError;
+    unsigned long fileId = 0;
+
+    while (std::getline(inKeyFile, sKey, ms_FieldSeparator))
+    {
+        std::getline(inKeyFile, sOrderNum, ms_FieldSeparator);
+        std::getline(inKeyFile, sUrl, ms_FieldSeparator);
+        std::getline(inKeyFile, sPort);
+        if (inKeyFile.fail())
+        {
+            logError(keyFilename, "reading");
+            return false;
+        }
+
+        if (hasBackends && BackendDictionary::parseReference(sUrl, fileId))
+        {
+            if (fileId >= backendIds.size())
+            {
+                logError(keyFilename, "reading");
+                return false;
+            }
+
+            sUrl = backends.getUrl(backendIds[fileId]);
+        }
+
+        std::size_t pos = sPort.find(ms_FieldSeparator);
+        sError = (pos == std::string::npos ? "0" : sPort.substr(pos + 1));
+        if (pos != std::string::npos) sPort.resize(pos);
+
+        try
+        {
+            Monitored record;
+            record.key = sKey;
+            record.url = sUrl;
+            record.port = unsigned(std::stoi(sPort));
+            record.error = std::stoul(sError);
+            records.emplace_back(std::move(record), std::stoul(sOrderNum));
+        }
+        catch(const std::logic_error&) // invalid_argument or out_of_range
+        {
+            logError(keyFilename, "parsing");
+            return false;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_summary.clear();
+    m_index.clear();
+    m_streamLength = 0;
+    for (const auto& record : records)
+        update(record.first.key, record.first.url, record.first.port, record.second, record.first.error);
+
+    return true;
+}
+
+void SpaceSavingManager::zap()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_summary.clear();
+    m_index.clear();
+    m_streamLength = 0;
+}
@@ -7,21 +7,16 @@
  */
 
 #include <cassert>
-#include <thread>
 #include "ThreadedMessageQueue.h"
 
-const int ThreadedMessageQueue::firstPopLatency = FIRST_POPING_LATENCY;
-
 ThreadedMessageQueue::~ThreadedMessageQueue()
 {
-    while (!BLFMessageQueue::empty())
-    {
-        Message* pm = nullptr;
-        if (pop(pm))
-        {
-            delete pm;
-        }
-    }
+    Message* pm = nullptr;
+    while (SegmentedMessageQueue::pop(pm))
+        delete pm;
+
+    while (m_control.pop(pm))
+        delete pm;
 }
 
 bool ThreadedMessageQueue::start()
@@ -35,31 +30,66 @@ bool ThreadedMessageQueue::start()
 
 void ThreadedMessageQueue::run()
 {
+    std::vector<Message*> messages;
+    std::vector<KeyEvent> events;
+    messages.reserve(m_batchSize);
+    events.reserve(m_batchSize);
+
     while (m_running)
     {
-        if (empty())
+        // Before each batch: control commands do not wait for the keys queued ahead of them.
+        if (messages.empty() && ! m_control.empty())
         {
-            std::this_thread::sleep_for(std::chrono::milliseconds(firstPopLatency)); // 1 mSec
+            applyControl();
             continue;
         }
 
         Message* pm = nullptr;
-        if (! pop(pm)) // some unknown problem
+        if (! pop(pm)) // empty: the batch is over
         {
-            std::this_thread::sleep_for(std::chrono::milliseconds(firstPopLatency)); // 1 mSec
+            if (! messages.empty())
+            {
+                flushKeys(messages, events);
+            }
+            else if (! hasIdleSegments())
+            {
+                m_parker.wait([this]{ return ! empty() || ! m_control.empty() || ! m_running; });
+            }
+            else // quiet for m_idleRelease: the spare segments go back to the system
+            {
+                const std::chrono::steady_clock::time_point since = std::chrono::steady_clock::now();
+                m_parker.wait([this]{ return ! empty() || ! m_control.empty() || ! m_running; }, m_idleRelease);
+                if (empty() && std::chrono::steady_clock::now() - since >= m_idleRelease)
+                    releaseIdleSegments();
+            }
             continue;
         }
 
+        messages.push_back(pm);
+        if (pm->getCommand() == Message::Command::addKeys) // its records, viewing its body
+            parseKeyRecords(pm->getStringRef1(), events, pm->getByte() > 0 ? pm->getByte() : 1U);
+        else
+            events.push_back({pm->getStringRef1(), pm->getStringRef2(), pm->getNumber(), pm->getKeyCount()});
+        if (events.size() >= m_batchSize)
+            flushKeys(messages, events);
+    }
+
+    flushKeys(messages, events);
+}
+
+void ThreadedMessageQueue::applyControl()
+{
+    Message* pm = nullptr;
+    while (m_running && m_control.pop(pm))
+    {
+        m_depth.record(getDepth());
+        recordLatency(pm, TickClock::now());
+        m_applied++;
+
         switch (pm->getCommand())
         {
-        case Message::Command::addKey:
-            m_consumer->addOrUpdateKey(pm->getStringRef1(), pm->getStringRef2(), pm->getNumber());
-            delete pm;
-            break;
-
         case Message::Command::setRankingLength:
             m_consumer->setTopKeyReportBaseSize(pm->getShort());
-            delete pm;
             break;
 
         case Message::Command::stop:
@@ -69,22 +99,89 @@ void ThreadedMessageQueue::run()
         default:
             break;
         }
+
+        delete pm;
+        m_guard.release(1);
+    }
+}
+
+void ThreadedMessageQueue::flushKeys(std::vector<Message*>& messages, std::vector<KeyEvent>& events)
+{
+    if (messages.empty()) return;
+
+    m_depth.record(getDepth());
+    m_consumer->addOrUpdateKeys(events.data(), events.size());
+
+    const uint64_t ticks = TickClock::now(); // one clock read per batch
+    size_t keys = 0;
+    for (Message* pm : messages)
+    {
+        recordLatency(pm, ticks);
+        keys += getKeys(pm);
+        delete pm;
     }
+
+    m_applied += keys;
+    m_guard.release(keys);
+    messages.clear();
+    events.clear();
 }
 
 bool ThreadedMessageQueue::stop()
 {
     m_running = false;
+    m_parker.wakeUp();
     m_poper.join();
     return true; // this implementation always return true.
 }
 
-void ThreadedMessageQueue::push(Message* pMsg)
+bool ThreadedMessageQueue::push(Message* pMsg)
 {
     assert(pMsg != nullptr);
 
-    if (m_running)
+    if (! m_running)
     {
-        BLFMessageQueue::push(pMsg);
+        delete pMsg;
+        return false;
     }
+
+    const bool isKey = isKeyMessage(pMsg);
+    const size_t keys = getKeys(pMsg);
+    if (! isKey)
+    {
+        m_guard.admit(); // commands are never shed
+    }
+    else if (m_guard.isBounded())
+    {
+        const unsigned weight = m_guard.admitKey([this]{ return m_running.load(); }, keys);
+        if (weight == 0)
+        {
+            delete pMsg;
+            return false;
+        }
+
+        if (weight > 1)
+            pMsg->setByte(uint8_t(weight));
+    }
+
+    if (! m_guard.isBounded())
+        m_pushed.fetch_add(keys, std::memory_order_relaxed);
+
+    thread_local unsigned pushes = 0;
+    static_assert((QUEUE_LATENCY_SAMPLE_RATE & (QUEUE_LATENCY_SAMPLE_RATE - 1)) == 0, "power of 2");
+    if ((pushes++ & (QUEUE_LATENCY_SAMPLE_RATE - 1)) == 0)
+        pMsg->setTicks(TickClock::now());
+
+    if (isKey)
+        SegmentedMessageQueue::push(pMsg);
+    else
+        m_control.push(pMsg);
+
+    m_parker.notify();
+    return true;
+}
+
+QueueStats ThreadedMessageQueue::getQueueStats()
+{
+    return {m_latency.getSummary(TickClock::nanosecondsPerTick()), m_depth.getSummary()};
 }
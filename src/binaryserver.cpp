@@ -0,0 +1,267 @@
+/**
+ * @file binaryserver.cpp
+ * @brief BinaryServer implementation.
+ * @author Guillermo M. Paris
+ * @date 2026-10-18
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+
+#include "binaryserver.h"
+
+namespace net = boost::asio;       // from <boost/asio.hpp>
+using tcp = boost::asio::ip::tcp;  // from <boost/asio/ip/tcp.hpp>
+
+// One client: reads what arrived, replies to every complete frame in one write, reads again.
+// The socket runs on its own strand: its handlers never run concurrently.
+class BinaryServer::Connection : public std::enable_shared_from_this<Connection>
+{
+public:
+
+    Connection(tcp::socket socket, BinaryServer& server)
+    : m_socket(std::move(socket)), m_server(server), m_size(0)
+    {
+    }
+
+    void start() { read(); }
+
+
+private:
+
+    static const size_t ms_readSize = 64 * 1024;
+
+    void read()
+    {
+        if (m_in.size() < m_size + ms_readSize) // a frame longer than a read is gathered in place
+            m_in.resize(m_size + ms_readSize);
+
+        m_socket.async_read_some(net::buffer(m_in.data() + m_size, m_in.size() - m_size),
+            [self = shared_from_this()](boost::system::error_code ec, size_t bytes_read)
+            {
+                self->onRead(ec, bytes_read);
+            });
+    }
+
+    void onRead(boost::system::error_code ec, size_t bytes_read)
+    {
+        if (ec) // the last handler: the connection is released on return
+        {
+            if (ec != net::error::eof && m_server.m_verbosity >= Verbosity::info)
+                std::cerr << "Binary connection read error: " << ec.message() << '\n';
+            return;
+        }
+
+        m_size += bytes_read;
+        if (! processFrames())
+            return;
+
+        if (m_out.empty()) // only part of a frame so far
+            return read();
+
+        net::async_write(m_socket, net::buffer(m_out),
+            [self = shared_from_this()](boost::system::error_code ec, size_t)
+            {
+                if (ec)
+                {
+                    std::cerr << "Binary connection write error: " << ec.message() << '\n';
+                    return;
+                }
+
+                self->m_out.clear();
+                self->read();
+            });
+    }
+
+    // False on a protocol error, the connection is closed then.
+    bool processFrames()
+    {
+        size_t pos = 0;
+        while (m_size - pos >= 4)
+        {
+            const uint32_t length = readUint32(&m_in[pos]);
+            if (length == 0 || length > ms_maxFrameSize + 1)
+            {
+                std::cerr << "Binary connection closed, bad frame length: " << length << '\n';
+                boost::system::error_code ec;
+                m_socket.close(ec);
+                return false;
+            }
+
+            if (m_size - pos - 4 < length)
+                break;
+
+            m_server.processFrame(uint8_t(m_in[pos + 4]), std::string_view(&m_in[pos + 5], length - 1), m_out);
+            pos += 4 + length;
+        }
+
+        if (pos > 0)
+        {
+            std::memmove(m_in.data(), m_in.data() + pos, m_size - pos);
+            m_size -= pos;
+        }
+
+        return true;
+    }
+
+    tcp::socket        m_socket;
+    BinaryServer&      m_server;
+    std::vector<char>  m_in;   // m_size bytes received, not processed yet
+    size_t             m_size;
+    std::string        m_out;  // replies of the last read
+};
+
+BinaryServer::BinaryServer( net::ip::address ip, const unsigned short port,
+                            const unsigned short threads /*= 1*/, Verbosity v /*= 0*/ )
+    : m_verbosity(v)
+    , m_nThreads(threads > 0 ? threads : 1)
+    , m_ioc(m_nThreads)
+    , m_acceptor(m_ioc, {ip, port})
+{
+}
+
+BinaryServer::~BinaryServer()
+{
+    stop();
+}
+
+bool BinaryServer::start()
+{
+    accept();
+    m_threads.reserve(m_nThreads);
+    for (unsigned short i = 0; i < m_nThreads; i++)
+        m_threads.emplace_back([this] { m_ioc.run(); });
+
+    return true;
+}
+
+bool BinaryServer::stop()
+{
+    m_ioc.stop();
+    for (std::thread& t : m_threads)
+    {
+        if (t.joinable() && t.get_id() != std::this_thread::get_id())
+            t.join();
+    }
+
+    m_threads.clear();
+    return true;
+}
+
+void BinaryServer::accept()
+{
+    // The new connection gets its own strand.
+    m_acceptor.async_accept( net::make_strand(m_ioc),
+        [this](boost::system::error_code ec, tcp::socket socket)
+        {
+            if (ec)
+            {
+                std::cerr << "Binary acceptor error: " << ec.message() << std::endl;
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            else
+            {
+                // Replies leave in one write per read: nothing to coalesce by waiting.
+                socket.set_option(tcp::no_delay(true), ec);
+                std::make_shared<Connection>(std::move(socket), *this)->start();
+            }
+
+            accept();
+        });
+}
+
+void BinaryServer::processFrame(uint8_t opcode, std::string_view payload, std::string& reply)
+{
+    // The reporter takes strings: these keep their capacity from frame to frame.
+    thread_local std::string inData, outData;
+    auto report = [&](const char* target, std::string_view data) -> int
+    {
+        inData.assign(data.data(), data.size());
+        outData.clear();
+        return m_topMessageFunctor ? m_topMessageFunctor(target, inData, outData) : CMD_UNKNOWN;
+    };
+
+    if (m_verbosity >= Verbosity::trace)
+        std::cout << "Binary frame: opcode " << int(opcode) << ", " << payload.size() << " bytes payload.\n";
+
+    switch (opcode)
+    {
+    case Opcode::keySent:
+        reply += toStatus(report("keySent", payload));
+        break;
+
+    case Opcode::keysSent:
+        reply += toStatus(report("keysSent", payload));
+        break;
+
+    case Opcode::isHotKey:
+        reply += toStatus(report("isHotKey", payload));
+        reply += char(outData == "YES");
+        break;
+
+    case Opcode::isHotKeys:
+    {
+        // The status is the one of the first key that did not succeed, if any.
+        const size_t statusPos = reply.size();
+        char status = m_topMessageFunctor ? char(Status::succeeded) : char(Status::unknownCommand);
+        reply += status;
+        const size_t countPos = reply.size();
+        appendUint32(reply, 0);
+        uint32_t count = 0;
+        while (! payload.empty())
+        {
+            const size_t end = payload.find('\n');
+            std::string_view key = payload.substr(0, end);
+            payload.remove_prefix(end == std::string_view::npos ? payload.size() : end + 1);
+            if (! key.empty() && key.back() == '\r')
+                key.remove_suffix(1);
+            if (key.empty())
+                continue;
+
+            const char keyStatus = toStatus(report("isHotKey", key));
+            if (status == char(Status::succeeded))
+                status = keyStatus;
+            reply += char(outData == "YES");
+            count++;
+        }
+
+        reply[statusPos] = status;
+        std::string countBytes;
+        appendUint32(countBytes, count);
+        reply.replace(countPos, 4, countBytes);
+        break;
+    }
+
+    case Opcode::getTopHotKeys:
+        reply += toStatus(report("getTopHotKeys", std::string_view()));
+        appendUint32(reply, uint32_t(outData.size()));
+        reply += outData;
+        break;
+
+    case Opcode::totalKeys:
+        reply += toStatus(report("totalKeys", std::string_view()));
+        appendUint32(reply, uint32_t(std::strtoul(outData.c_str(), nullptr, 10)));
+        break;
+
+    default:
+        if (m_verbosity >= Verbosity::info)
+            std::cout << "Binary frame with unknown opcode : " << int(opcode) << '\n';
+
+        reply += char(Status::unknownOpcode);
+        break;
+    }
+}
+
+char BinaryServer::toStatus(int result)
+{
+    switch (result)
+    {
+    case CMD_FAILED:     return char(Status::failed);
+    case CMD_SUCCEEDED:  return char(Status::succeeded);
+    case CMD_OVERLOADED: return char(Status::overloaded);
+    default:             return char(Status::unknownCommand);
+    }
+}
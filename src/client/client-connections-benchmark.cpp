@@ -0,0 +1,219 @@
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+#include <boost/beast/version.hpp>
+#include <boost/asio/connect.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Opens many keep-alive connections at once, as a load balancer fleet does, and sends the same
+// number of /keySent requests through each one. A connection is kept open once done, until all
+// of them are: a server that serves one connection per thread leaves the connections beyond its
+// threads waiting. Reports the connections served, the request rate and the request latency,
+// within a time limit.
+
+namespace beast = boost::beast;  // from <boost/beast.hpp>
+namespace http = beast::http;    // from <boost/beast/http.hpp>
+namespace net = boost::asio;     // from <boost/asio.hpp>
+using tcp = net::ip::tcp;        // from <boost/asio/ip/tcp.hpp>
+using Clock = std::chrono::steady_clock;
+
+const int   VERSION = 11; // HTTP 1.1
+const char* host = "localhost";
+const char* port = "8080";
+
+struct Results
+{
+    std::mutex            mutex;
+    std::vector<uint32_t> latencies;  // uSec, every answered request
+    std::vector<std::shared_ptr<class Session>> idle; // done, kept open
+    Clock::duration       worstFirst = Clock::duration::zero(); // connect to first response, slowest connection
+    unsigned              connected = 0;
+    unsigned              served = 0; // connections that got every response
+    unsigned              failed = 0;
+};
+
+Results g_results;
+
+class Session : public std::enable_shared_from_this<Session>
+{
+public:
+
+    Session(net::io_context& ioc, unsigned id, unsigned requests)
+    : m_stream(ioc), m_id(id), m_requests(requests), m_sent(0), m_connected(false), m_first(Clock::duration::zero())
+    {
+        m_latencies.reserve(requests);
+    }
+
+    // Partial results too: the session is released when the time limit stops the context.
+    ~Session()
+    {
+        std::lock_guard<std::mutex> lock(g_results.mutex);
+        g_results.latencies.insert(g_results.latencies.end(), m_latencies.begin(), m_latencies.end());
+        g_results.connected += m_connected;
+        if (m_first > g_results.worstFirst || m_latencies.empty())
+            g_results.worstFirst = m_latencies.empty() ? Clock::duration::max() : m_first;
+    }
+
+    void start(const tcp::resolver::results_type& endpoints)
+    {
+        m_start = Clock::now();
+        m_stream.async_connect(endpoints,
+            [self = shared_from_this()](beast::error_code ec, const tcp::endpoint&)
+            {
+                if (ec)
+                    return self->fail("connect", ec);
+
+                self->m_connected = true;
+                self->send();
+            });
+    }
+
+private:
+
+    void send()
+    {
+        m_request = {http::verb::post, "/keySent", VERSION};
+        m_request.set(http::field::host, host);
+        m_request.set(http::field::user_agent, BOOST_BEAST_VERSION_STRING);
+        m_request.set(http::field::content_type, "text/plain");
+        m_request.body() = "benchmark_key_" + std::to_string(m_sent % 100) + ",www.connections.com:" +
+                           std::to_string(m_id % 1000);
+        m_request.prepare_payload();
+        m_sentTime = Clock::now();
+        m_sent++;
+
+        http::async_write(m_stream, m_request,
+            [self = shared_from_this()](beast::error_code ec, size_t)
+            {
+                if (ec)
+                    return self->fail("write", ec);
+
+                self->m_response = {};
+                http::async_read(self->m_stream, self->m_buffer, self->m_response,
+                    [self](beast::error_code ec, size_t)
+                    {
+                        if (ec)
+                            return self->fail("read", ec);
+
+                        self->onResponse();
+                    });
+            });
+    }
+
+    void onResponse()
+    {
+        const Clock::time_point now = Clock::now();
+        if (m_latencies.empty())
+            m_first = now - m_start;
+        m_latencies.push_back(uint32_t(std::chrono::duration_cast<std::chrono::microseconds>(now - m_sentTime).count()));
+
+        if (m_response.result() != http::status::ok)
+            std::cerr << "Request error. Code: " << m_response.result_int() << std::endl;
+
+        if (m_sent < m_requests)
+            return send();
+
+        std::lock_guard<std::mutex> lock(g_results.mutex);
+        g_results.served++;
+        g_results.idle.push_back(shared_from_this());
+    }
+
+    void fail(const char* what, beast::error_code ec)
+    {
+        std::lock_guard<std::mutex> lock(g_results.mutex);
+        if (g_results.failed++ < 5)
+            std::cerr << "Connection #" << m_id << " " << what << " error: " << ec.message() << std::endl;
+    }
+
+    beast::tcp_stream                  m_stream;
+    beast::flat_buffer                 m_buffer;
+    http::request<http::string_body>   m_request;
+    http::response<http::string_body>  m_response;
+    const unsigned                     m_id;
+    const unsigned                     m_requests;
+    unsigned                           m_sent;
+    bool                               m_connected;
+    Clock::time_point                  m_start;
+    Clock::time_point                  m_sentTime;
+    Clock::duration                    m_first;
+    std::vector<uint32_t>              m_latencies;
+};
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        std::cerr << "Usage: " << argv[0] << " <connections> [requests per connection] [threads] [time limit sec]\n"
+                  << "  Sends POST /keySent to " << host << ":" << port << " through every connection at once.\n"
+                  << "  Defaults: 20 requests, 1 thread, 60 sec.\n";
+        return EXIT_FAILURE;
+    }
+
+    const unsigned connections = unsigned(std::atoi(argv[1]));
+    const unsigned requests = argc > 2 && std::atoi(argv[2]) > 0 ? unsigned(std::atoi(argv[2])) : 20;
+    const unsigned threads = argc > 3 && std::atoi(argv[3]) > 0 ? unsigned(std::atoi(argv[3])) : 1;
+    const unsigned limit = argc > 4 && std::atoi(argv[4]) > 0 ? unsigned(std::atoi(argv[4])) : 60;
+
+    Clock::time_point start = Clock::now();
+    {
+        net::io_context ioc{int(threads)};
+        tcp::resolver resolver(ioc);
+        const tcp::resolver::results_type endpoints = resolver.resolve(host, port);
+
+        for (unsigned c = 0; c < connections; c++)
+            std::make_shared<Session>(ioc, c, requests)->start(endpoints);
+
+        net::steady_timer deadline(ioc, std::chrono::seconds(limit));
+        deadline.async_wait([&ioc](beast::error_code ec) { if (!ec) ioc.stop(); });
+
+        // The deadline is the last pending work once every session is done.
+        std::thread watcher([&] {
+            while (! ioc.stopped())
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                std::lock_guard<std::mutex> lock(g_results.mutex);
+                if (g_results.served + g_results.failed >= connections)
+                    break;
+            }
+            net::post(ioc, [&deadline] { deadline.cancel(); });
+        });
+
+        std::vector<std::thread> runners;
+        for (unsigned t = 1; t < threads; t++)
+            runners.emplace_back([&ioc] { ioc.run(); });
+        ioc.run();
+        for (std::thread& t : runners)
+            t.join();
+        watcher.join();
+        g_results.idle.clear(); // closes the kept connections
+    }
+    const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::vector<uint32_t>& lat = g_results.latencies;
+    std::sort(lat.begin(), lat.end());
+    auto percentile = [&lat](double f) { return lat.empty() ? 0U : lat[size_t(f * double(lat.size() - 1))]; };
+
+    std::cout << connections << " keep-alive connections x " << requests << " requests, " << threads << " client threads:\n"
+              << "  connected " << g_results.connected << ", fully served " << g_results.served
+              << ", failed " << g_results.failed << " in " << seconds << " sec"
+              << (g_results.served + g_results.failed < connections ? " (time limit)" : "") << "\n"
+              << "  " << lat.size() << " responses, " << unsigned(double(lat.size()) / seconds) << " requests/sec\n"
+              << "  latency uSec p50 " << percentile(0.50) << ", p99 " << percentile(0.99)
+              << ", max " << (lat.empty() ? 0U : lat.back()) << "\n";
+    if (g_results.worstFirst != Clock::duration::max())
+        std::cout << "  slowest connection got its first response after "
+                  << std::chrono::duration_cast<std::chrono::milliseconds>(g_results.worstFirst).count() << " mSec\n";
+    else
+        std::cout << "  some connections got no response at all\n";
+
+    return EXIT_SUCCESS;
+}
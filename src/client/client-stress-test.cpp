@@ -3,11 +3,19 @@
 #include <boost/beast/version.hpp>
 #include <boost/asio/connect.hpp>
 #include <boost/asio/ip/tcp.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
 #include <cstdlib>
+#include <iomanip>
 #include <iostream>
 #include <mutex>
+#include <sstream>
 #include <string>
 #include <thread>
+#include <vector>
+
+#include "binaryserver.h"
 
 //#define SERVER_CLOSE_CONNECTION_AFTER_EVERY_REQUEST 1
 
@@ -105,6 +113,51 @@ void test_keySent( beast::tcp_stream & stream, beast::flat_buffer & buffer,
     buffer.clear();
 }
 
+void test_keysSent( beast::tcp_stream & stream, beast::flat_buffer & buffer,
+                    const std::string& records, bool log = true )
+{
+    clock_t start = 0, finish = 0;
+
+    if (log)
+    {
+        std::cout << "Test for POST request to http://localhost:8080/keysSent\n";
+        start = clock();
+    }
+
+    http::request<http::string_body>  request(http::verb::post, "/keysSent", VERSION);
+    request.set(http::field::host, host);
+    request.set(http::field::user_agent, BOOST_BEAST_VERSION_STRING);
+    request.set(http::field::content_type, "text/plain");
+    request.body() = records;
+    request.prepare_payload();
+
+    // Send the HTTP request to the remote host
+    http::write(stream, request);
+
+    // Declare a container to hold the response
+    http::response<http::dynamic_body>  response;
+
+    // Receive the HTTP response
+    http::read(stream, buffer, response);
+
+    if (log) finish = clock();
+
+    if (response.result() == http::status::ok)
+    {
+        if (log)      // Write the message to standard out
+        {
+            std::cout << "Response content: " << response << '\n'
+                      << "It took " <<  (finish - start) << " uSec.\n" << std::endl;
+        }
+    }
+    else
+    {
+        std::cerr << "Request error. Code: " << response.result_int() << std::endl;
+    }
+
+    buffer.clear();
+}
+
 void test_isHotKey( beast::tcp_stream & stream, beast::flat_buffer & buffer,
                     const char* key, bool log = true, bool multithread = false )
 {
@@ -304,6 +357,262 @@ void tryConnect(net::io_context & ioc, beast::tcp_stream & stream, int step)
 
 bool g_reconnect = false; // connection lives allowing undefined number of requests.
 
+// Keys per second through /keysSent for every batch size (keys per request), on one connection.
+int bulkTest(net::io_context & ioc, const std::vector<unsigned>& batchSizes, unsigned totalKeys)
+{
+    beast::tcp_stream stream(ioc);
+    tryConnect(ioc, stream, 0);
+    beast::flat_buffer buffer;
+
+    std::cout << "\nBulk test: " << totalKeys << " keys through /keysSent per batch size.\n\n";
+    try
+    {
+        for (unsigned batchSize : batchSizes)
+        {
+            // Bodies are built before the clock starts: the figure is the HTTP and server side.
+            std::vector<std::string> bodies;
+            char record[64];
+            for (unsigned i = 0; i < totalKeys; i++)
+            {
+                if (i % batchSize == 0)
+                    bodies.emplace_back();
+                snprintf(record, sizeof(record), "testing_keysSent_%05u,www.bulk.com,%u\n", i % 20000, 8000 + i % 100);
+                bodies.back() += record;
+            }
+
+            auto start = std::chrono::steady_clock::now();
+            for (const std::string& body : bodies)
+                test_keysSent(stream, buffer, body, false);
+            const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            std::cout << "  " << batchSize << " keys per request: " << bodies.size() << " requests in "
+                      << seconds << " sec, " << unsigned(totalKeys / seconds) << " keys/sec\n";
+        }
+    }
+    catch(const std::exception & e)
+    {
+        std::cerr << "Client request error: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    disconnect(stream);
+    return EXIT_SUCCESS;
+}
+
+// Keys per second through /keySent for every pipelining depth, on one connection: depth requests,
+// /keySent and /isHotKey alternated, are written back to back before any response is read. The
+// responses must come back in request order: every /keySent one names its own key.
+int pipelineTest(net::io_context & ioc, const std::vector<unsigned>& depths, unsigned totalKeys)
+{
+    beast::tcp_stream stream(ioc);
+    tryConnect(ioc, stream, 0);
+    beast::flat_buffer buffer;
+
+    std::cout << "\nPipeline test: " << totalKeys << " keys through /keySent, each one followed by"
+              << " an /isHotKey, per pipelining depth.\n\n";
+    try
+    {
+        for (unsigned depth : depths)
+        {
+            // Requests are serialized before the clock starts: the figure is the HTTP and server side.
+            std::vector<std::string> bursts;
+            std::vector<std::string> keys;
+            for (unsigned i = 0; i < 2 * totalKeys; i++)
+            {
+                if (i % depth == 0)
+                    bursts.emplace_back();
+
+                const std::string key = "testing_pipeline_" + std::to_string(i / 2 % 20000);
+                http::request<http::string_body>  request(http::verb::post, i % 2 ? "/isHotKey" : "/keySent", VERSION);
+                request.set(http::field::host, host);
+                request.set(http::field::user_agent, BOOST_BEAST_VERSION_STRING);
+                request.set(http::field::content_type, "text/plain");
+                request.body() = i % 2 ? key : key + ",www.pipeline.com," + std::to_string(8000 + i % 100);
+                request.prepare_payload();
+
+                std::ostringstream out;
+                out << request;
+                bursts.back() += out.str();
+                keys.push_back(key);
+            }
+
+            unsigned failed = 0, misordered = 0, request = 0;
+            auto start = std::chrono::steady_clock::now();
+            for (const std::string& burst : bursts)
+            {
+                net::write(stream.socket(), net::buffer(burst));
+                const unsigned end = std::min<unsigned>(request + depth, unsigned(keys.size()));
+                for (; request < end; request++)
+                {
+                    http::response<http::string_body>  response;
+                    http::read(stream, buffer, response);
+                    if (response.result() != http::status::ok)
+                        failed++;
+                    else if (request % 2 == 0 ? response.body().find(keys[request]) == std::string::npos
+                                              : response.body().find("YES") == std::string::npos &&
+                                                response.body().find("NO") == std::string::npos)
+                        misordered++;
+                }
+            }
+            const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            std::cout << "  depth " << depth << ": " << keys.size() << " requests in " << seconds << " sec, "
+                      << unsigned(totalKeys / seconds) << " keys/sec";
+            if (failed || misordered)
+                std::cout << ", " << failed << " failed, " << misordered << " out of order";
+            std::cout << "\n";
+        }
+    }
+    catch(const std::exception & e)
+    {
+        std::cerr << "Client request error: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    disconnect(stream);
+    return EXIT_SUCCESS;
+}
+
+// Sends the frames and reads back replyBytes bytes, the replies of all of them.
+void binaryCall(tcp::socket & socket, const std::string& frames, std::string& reply, size_t replyBytes)
+{
+    net::write(socket, net::buffer(frames));
+    reply.resize(replyBytes);
+    net::read(socket, net::buffer(&reply[0], replyBytes));
+}
+
+// Keys per second through the binary protocol against HTTP, one key and 100 keys per request,
+// each on one keep-alive connection.
+int binaryTest(net::io_context & ioc, const char* binaryPort, unsigned totalKeys)
+{
+    beast::tcp_stream stream(ioc);
+    tryConnect(ioc, stream, 0);
+    beast::flat_buffer buffer;
+
+    tcp::socket socket(ioc);
+    tcp::resolver resolver(ioc);
+    try
+    {
+        net::connect(socket, resolver.resolve(host, binaryPort));
+        socket.set_option(tcp::no_delay(true));
+    }
+    catch(const std::exception & e)
+    {
+        std::cerr << "Binary connection error (tracker started with -b ?): " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::vector<std::string> keys, records;
+    for (unsigned i = 0; i < totalKeys; i++)
+    {
+        keys.push_back("testing_binary_" + std::to_string(i % 20000));
+        records.push_back(keys.back() + ",www.binary.com," + std::to_string(8000 + i % 100));
+    }
+
+    const unsigned batch = 100;
+    auto keysPerSec = [totalKeys](std::chrono::steady_clock::time_point start) {
+        return unsigned(totalKeys / std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    };
+
+    std::cout << "\nBinary protocol test: " << totalKeys << " keys per row, HTTP on port " << port
+              << ", binary on port " << binaryPort << " (keys/sec).\n\n";
+    try
+    {
+        std::string frames, reply, body;
+        unsigned failed = 0;
+
+        auto start = std::chrono::steady_clock::now();
+        for (const std::string& record : records)
+            test_keySent(stream, buffer, record.c_str(), false);
+        const unsigned httpKeySent = keysPerSec(start);
+
+        start = std::chrono::steady_clock::now();
+        for (const std::string& record : records)
+        {
+            frames.clear();
+            BinaryServer::appendFrame(frames, BinaryServer::Opcode::keySent, record);
+            binaryCall(socket, frames, reply, 1);
+            failed += (reply[0] != char(BinaryServer::Status::succeeded));
+        }
+        const unsigned binaryKeySent = keysPerSec(start);
+
+        start = std::chrono::steady_clock::now();
+        for (const std::string& key : keys)
+            test_isHotKey(stream, buffer, key.c_str(), false);
+        const unsigned httpIsHotKey = keysPerSec(start);
+
+        start = std::chrono::steady_clock::now();
+        for (const std::string& key : keys)
+        {
+            frames.clear();
+            BinaryServer::appendFrame(frames, BinaryServer::Opcode::isHotKey, key);
+            binaryCall(socket, frames, reply, 2);
+            failed += (reply[0] != char(BinaryServer::Status::succeeded));
+        }
+        const unsigned binaryIsHotKey = keysPerSec(start);
+
+        start = std::chrono::steady_clock::now();
+        for (unsigned i = 0; i < totalKeys; i += batch)
+        {
+            body.clear();
+            for (unsigned j = i; j < i + batch && j < totalKeys; j++)
+                body += records[j] + '\n';
+            test_keysSent(stream, buffer, body, false);
+        }
+        const unsigned httpKeysSent = keysPerSec(start);
+
+        start = std::chrono::steady_clock::now();
+        for (unsigned i = 0; i < totalKeys; i += batch)
+        {
+            body.clear();
+            for (unsigned j = i; j < i + batch && j < totalKeys; j++)
+                body += records[j] + '\n';
+            frames.clear();
+            BinaryServer::appendFrame(frames, BinaryServer::Opcode::keysSent, body);
+            binaryCall(socket, frames, reply, 1);
+            failed += (reply[0] != char(BinaryServer::Status::succeeded));
+        }
+        const unsigned binaryKeysSent = keysPerSec(start);
+
+        start = std::chrono::steady_clock::now();
+        for (unsigned i = 0; i < totalKeys; i += batch)
+        {
+            body.clear();
+            unsigned n = 0;
+            for (unsigned j = i; j < i + batch && j < totalKeys; j++, n++)
+                body += keys[j] + '\n';
+            frames.clear();
+            BinaryServer::appendFrame(frames, BinaryServer::Opcode::isHotKeys, body);
+            binaryCall(socket, frames, reply, 5 + n);
+            failed += (reply[0] != char(BinaryServer::Status::succeeded) || BinaryServer::readUint32(&reply[1]) != n);
+        }
+        const unsigned binaryIsHotKeys = keysPerSec(start);
+
+        frames.clear();
+        BinaryServer::appendFrame(frames, BinaryServer::Opcode::totalKeys, std::string_view());
+        binaryCall(socket, frames, reply, 5);
+
+        auto row = [](const std::string& what, const std::string& http, unsigned binary) {
+            std::cout << "  " << std::left << std::setw(24) << what << std::right << std::setw(10) << http
+                      << std::setw(10) << binary << "\n";
+        };
+        std::cout << "  " << std::setw(34) << "HTTP" << std::setw(10) << "binary" << "\n";
+        row("keySent, 1 per call", std::to_string(httpKeySent), binaryKeySent);
+        row("isHotKey, 1 per call", std::to_string(httpIsHotKey), binaryIsHotKey);
+        row("keySent, " + std::to_string(batch) + " per call", std::to_string(httpKeysSent), binaryKeysSent);
+        row("isHotKey, " + std::to_string(batch) + " per call", "-", binaryIsHotKeys);
+        std::cout << "  total keys " << BinaryServer::readUint32(&reply[1]) << ", failed binary calls " << failed << "\n";
+    }
+    catch(const std::exception & e)
+    {
+        std::cerr << "Client request error: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    disconnect(stream);
+    return EXIT_SUCCESS;
+}
+
 int main(int argc, char* argv[])
 {
     if(argc > 1 && 0 == std::string(argv[1]).compare("--server-connection-lives-for-one-request"))
@@ -314,6 +623,39 @@ int main(int argc, char* argv[])
     // The io_context is required for all I/O
     net::io_context ioc;
 
+    // --bulk [keys per request ...]: keys/sec against batch size, instead of the tests below.
+    if(argc > 1 && 0 == std::string(argv[1]).compare("--bulk"))
+    {
+        std::vector<unsigned> batchSizes;
+        for (int i = 2; i < argc; i++)
+            if (std::atoi(argv[i]) > 0)
+                batchSizes.push_back(unsigned(std::atoi(argv[i])));
+        if (batchSizes.empty())
+            batchSizes = {1, 10, 100, 1000, 10000};
+
+        return bulkTest(ioc, batchSizes, 200000);
+    }
+
+    // --pipeline [requests per write ...]: keys/sec against pipelining depth, instead of the tests below.
+    if(argc > 1 && 0 == std::string(argv[1]).compare("--pipeline"))
+    {
+        std::vector<unsigned> depths;
+        for (int i = 2; i < argc; i++)
+            if (std::atoi(argv[i]) > 0)
+                depths.push_back(unsigned(std::atoi(argv[i])));
+        if (depths.empty())
+            depths = {1, 2, 8, 32, 128};
+
+        return pipelineTest(ioc, depths, 50000);
+    }
+
+    // --binary [binary port]: the binary protocol (tracker -b) against HTTP, instead of the tests below.
+    if(argc > 1 && 0 == std::string(argv[1]).compare("--binary"))
+    {
+        const std::string binaryPort = argc > 2 ? argv[2] : std::to_string(std::atoi(port) + 1);
+        return binaryTest(ioc, binaryPort.c_str(), 50000);
+    }
+
     // These objects perform our I/O
     beast::tcp_stream stream(ioc);
 
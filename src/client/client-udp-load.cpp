@@ -0,0 +1,183 @@
+#include <boost/beast/core.hpp>
+#include <boost/beast/http.hpp>
+#include <boost/beast/version.hpp>
+#include <boost/asio/connect.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <netdb.h>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+// Sends fire and forget key records to the tracker UDP port (tracker option -u) for some seconds,
+// flat out or at a given datagram rate, in sendmmsg() batches. The tracker counters (GET
+// /udpStats) before and after give the keys it queued: sustained keys/sec and the loss rate,
+// with the datagrams the kernel dropped for lack of socket buffer.
+
+namespace beast = boost::beast;  // from <boost/beast.hpp>
+namespace http = beast::http;    // from <boost/beast/http.hpp>
+namespace net = boost::asio;     // from <boost/asio.hpp>
+using tcp = net::ip::tcp;        // from <boost/asio/ip/tcp.hpp>
+using Clock = std::chrono::steady_clock;
+
+const int   VERSION = 11; // HTTP 1.1
+const char* host = "localhost";
+const char* port = "8080";
+const unsigned sendBatch = 64;
+
+struct UdpStats
+{
+    uint64_t datagrams = 0, keys = 0, malformed = 0, shed = 0, kernelDropped = 0;
+};
+
+uint64_t jsonNumber(const std::string& body, const char* name)
+{
+    const std::string field = std::string("\"") + name + "\": ";
+    const size_t pos = body.find(field);
+    return pos == std::string::npos ? 0 : std::strtoull(body.c_str() + pos + field.size(), nullptr, 10);
+}
+
+bool getUdpStats(UdpStats& stats)
+{
+    try
+    {
+        net::io_context ioc;
+        tcp::resolver resolver(ioc);
+        beast::tcp_stream stream(ioc);
+        stream.connect(resolver.resolve(host, port));
+
+        http::request<http::string_body>  request(http::verb::get, "/udpStats", VERSION);
+        request.set(http::field::host, host);
+        request.set(http::field::user_agent, BOOST_BEAST_VERSION_STRING);
+        http::write(stream, request);
+
+        beast::flat_buffer buffer;
+        http::response<http::string_body>  response;
+        http::read(stream, buffer, response);
+
+        beast::error_code ec;
+        stream.socket().shutdown(tcp::socket::shutdown_both, ec);
+
+        const std::string& body = response.body();
+        stats.datagrams = jsonNumber(body, "Datagrams");
+        stats.keys = jsonNumber(body, "Keys");
+        stats.malformed = jsonNumber(body, "Malformed");
+        stats.shed = jsonNumber(body, "Shed");
+        stats.kernelDropped = jsonNumber(body, "KernelDropped");
+        return response.result() == http::status::ok;
+    }
+    catch(const std::exception & e)
+    {
+        std::cerr << "GET /udpStats error: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        std::cerr << "Usage: " << argv[0] << " <records per datagram> [seconds] [datagrams/sec] [udp port]\n"
+                  << "  Sends key records by UDP to " << host << " (tracker option -u) and reads GET /udpStats\n"
+                  << "  from port " << port << ". Defaults: 5 sec, 0 datagrams/sec (flat out), udp port " << port << ".\n";
+        return EXIT_FAILURE;
+    }
+
+    const unsigned records = std::atoi(argv[1]) > 0 ? unsigned(std::atoi(argv[1])) : 1;
+    const unsigned seconds = argc > 2 && std::atoi(argv[2]) > 0 ? unsigned(std::atoi(argv[2])) : 5;
+    const unsigned rate = argc > 3 && std::atoi(argv[3]) > 0 ? unsigned(std::atoi(argv[3])) : 0;
+    const char* udpPort = argc > 4 ? argv[4] : port;
+
+    addrinfo hints;
+    std::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_DGRAM;
+    addrinfo* pAddress = nullptr;
+    if (getaddrinfo(host, udpPort, &hints, &pAddress) != 0)
+    {
+        std::cerr << "Cannot resolve " << host << ":" << udpPort << "\n";
+        return EXIT_FAILURE;
+    }
+
+    int fd = socket(pAddress->ai_family, SOCK_DGRAM, 0);
+    if (fd < 0 || connect(fd, pAddress->ai_addr, pAddress->ai_addrlen) < 0)
+    {
+        std::cerr << "UDP socket error: " << std::strerror(errno) << "\n";
+        freeaddrinfo(pAddress);
+        return EXIT_FAILURE;
+    }
+    freeaddrinfo(pAddress);
+
+    // The datagrams of one batch, built once: keys differ from datagram to datagram.
+    std::vector<std::string> datagrams(sendBatch);
+    for (unsigned d = 0; d < sendBatch; d++)
+        for (unsigned r = 0; r < records; r++)
+            datagrams[d] += "udp_key_" + std::to_string((d * records + r) % 20000) + ",www.udp.com," +
+                            std::to_string(8000 + r % 100) + "\n";
+
+    mmsghdr messages[sendBatch];
+    iovec   iovecs[sendBatch];
+    std::memset(messages, 0, sizeof(messages));
+    for (unsigned d = 0; d < sendBatch; d++)
+    {
+        iovecs[d].iov_base = &datagrams[d][0];
+        iovecs[d].iov_len = datagrams[d].size();
+        messages[d].msg_hdr.msg_iov = &iovecs[d];
+        messages[d].msg_hdr.msg_iovlen = 1;
+    }
+
+    UdpStats before, after;
+    if (! getUdpStats(before))
+        return EXIT_FAILURE;
+
+    uint64_t sent = 0, sendErrors = 0;
+    const Clock::time_point start = Clock::now();
+    const Clock::time_point end = start + std::chrono::seconds(seconds);
+    for (Clock::time_point now = start; now < end; now = Clock::now())
+    {
+        if (rate > 0) // paced per batch
+        {
+            const Clock::time_point due = start + std::chrono::duration_cast<Clock::duration>(
+                                                  std::chrono::duration<double>(double(sent) / rate));
+            if (due > now)
+            {
+                std::this_thread::sleep_until(due);
+                continue;
+            }
+        }
+
+        int n = sendmmsg(fd, messages, sendBatch, 0);
+        if (n > 0)
+            sent += unsigned(n);
+        else
+            sendErrors++;
+    }
+    const double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    close(fd);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(500)); // the tracker drains its sockets
+    if (! getUdpStats(after))
+        return EXIT_FAILURE;
+
+    const uint64_t received = after.datagrams - before.datagrams;
+    const uint64_t keys = after.keys - before.keys;
+    const uint64_t lost = sent > received ? sent - received : 0;
+    std::cout << records << " records per datagram, " << elapsed << " sec"
+              << (rate > 0 ? ", paced at " + std::to_string(rate) + " datagrams/sec" : ", flat out") << ":\n"
+              << "  sent     " << sent << " datagrams, " << sent * records << " keys, "
+              << unsigned(double(sent * records) / elapsed) << " keys/sec"
+              << (sendErrors ? ", " + std::to_string(sendErrors) + " send errors" : "") << "\n"
+              << "  queued   " << keys << " keys, " << unsigned(double(keys) / elapsed) << " keys/sec sustained\n"
+              << "  lost     " << lost << " datagrams (" << (sent ? 100.0 * double(lost) / double(sent) : 0.0)
+              << " %), kernel dropped " << after.kernelDropped - before.kernelDropped
+              << ", shed " << after.shed - before.shed << " keys, malformed " << after.malformed - before.malformed << "\n";
+
+    return EXIT_SUCCESS;
+}
@@ -14,17 +14,25 @@
 #include <iomanip>
 #include <sstream>
 #include <thread>
+#include <vector>
 
 #include "backupmanager.h"
+#include "KeyBatch.h"
+#include "KeyPreAggregator.h"
 #include "messageserver.h"
+#include "udpserver.h"
 
 MessageServer*  MessageServer::ms_pInstance(nullptr);
 
 MessageServer::MessageServer( IMapManager* mgr, IMessageQueue* queue, BackupManager* bkp,
-                              ICommunicationServer* comsrv, Verbosity v /* = 0 */ )
+                              ICommunicationServer* comsrv, Verbosity v /* = 0 */,
+                              KeyPreAggregator* agg /* = nullptr */,
+                              UdpServer* udp /* = nullptr */ )
     : m_verbosity(v)
     , m_pMapManager(mgr)
     , m_pMessageQueue(queue)
+    , m_pAggregator(agg)
+    , m_pUdpServer(udp)
     , m_pBackupManager(bkp)
     , m_pCommServer(comsrv)
     , m_topMessageServerFunctor(onMessage)
@@ -33,15 +41,30 @@ MessageServer::MessageServer( IMapManager* mgr, IMessageQueue* queue, BackupMana
 
     // initialize the top event functor and set it to commServer
     m_pCommServer->setReporter(m_topMessageServerFunctor);
+    if (m_pUdpServer != nullptr)
+        addCommServer(m_pUdpServer);
+}
+
+void MessageServer::addCommServer(ICommunicationServer* comsrv)
+{
+    comsrv->setReporter(m_topMessageServerFunctor);
+    m_extraCommServers.push_back(comsrv);
 }
 
 bool MessageServer::start()
 {
+    for (ICommunicationServer* comsrv : m_extraCommServers)
+        if (! comsrv->start())
+            return false;
+
     return m_pCommServer->start();
 }
 
 bool MessageServer::stop()
 {
+    for (ICommunicationServer* comsrv : m_extraCommServers)
+        comsrv->stop();
+
     return m_pCommServer->stop();
 }
 
@@ -63,7 +86,7 @@ int MessageServer::onMessage(const std::string& inTarget, const std::string& inD
         {
             key = inData.substr(start, end - start);
             start = end + 1;
-            end = inData.find(payloadDelimiter);
+            end = inData.find(payloadDelimiter, start);
             if (end == std::string::npos) // not found
             {
                 url = inData.substr(start);
@@ -90,14 +113,62 @@ int MessageServer::onMessage(const std::string& inTarget, const std::string& inD
             std::cout << "keySent :  Key=" << key << ", url=" << url
                       << ", port=" << port << '\n';
 
+        if (ms_pInstance->m_pAggregator != nullptr) // counted, queued within the staleness bound
+        {
+            if (! ms_pInstance->m_pAggregator->addKey(key, url, port)) // the queue is shedding
+            {
+                outData = "queue overloaded, key not reported : ";
+                outData += key;
+                return CMD_OVERLOADED;
+            }
+
+            outData = "reported key sent : ";
+            outData += key;
+            return CMD_SUCCEEDED;
+        }
+
+        // The reply names the key (pipelining clients match replies by it): built before the move.
+        outData = "reported key sent : ";
+        outData += key;
         Message* pMessage = new Message( Message::Command::addKey,
-                                         std::move(key), std::move(url), 0, port );
+                                         std::move(key), std::move(url), 0, 0, port );
 //      std::thread alone( [&] () { // NOT IN SEPARATE THREAD ANYMORE
-                ms_pInstance->m_pMessageQueue->push(pMessage);
+        if (! ms_pInstance->m_pMessageQueue->push(pMessage)) // shed (and deleted) by the queue
+        {
+            outData.replace(0, outData.find(':'), "queue overloaded, key not reported ");
+            return CMD_OVERLOADED;
+        }
 //          } );
 //      alone.detach(); // queue's pop() will get garbage pointers time to time if using separate thread ?!?!
-        outData = "reported key sent : ";
-        outData += key;
+        return CMD_SUCCEEDED;
+    }
+    else if (inTarget == "keysSent")
+    {
+        // Bulk of key[,url,port[,count]] records, one per line, queued as one message and parsed
+        // once, in place, by the queue thread: here they are only counted by a newline scan.
+        // Already one message for many keys: not pre-aggregated.
+        const size_t n = countKeyRecords(inData);
+        if (n == 0)
+        {
+            outData = "no key record found";
+            return CMD_FAILED;
+        }
+
+        if (ms_pInstance->m_verbosity >= Verbosity::info)
+            std::cout << "keysSent :  " << n << " keys, " << inData.size() << " bytes\n";
+
+        Message* pMessage = new Message( Message::Command::addKeys, inData, std::string(), 0, 0, uint32_t(n) );
+        const size_t queued = ms_pInstance->m_pMessageQueue->pushKeys(pMessage, n);
+        if (queued == 0) // shed (and deleted) by the queue
+        {
+            outData = "queue overloaded, keys not reported : " + std::to_string(n);
+            return CMD_OVERLOADED;
+        }
+
+        // Partly queued (a partition shed its part): not overloaded, a retry would count the rest twice.
+        outData = "reported keys sent : " + std::to_string(queued);
+        if (queued < n)
+            outData += ", keys shed : " + std::to_string(n - queued);
         return CMD_SUCCEEDED;
     }
     else if (inTarget == "isHotKey")
@@ -119,7 +190,10 @@ int MessageServer::onMessage(const std::string& inTarget, const std::string& inD
         std::size_t max = (v.size() >= 10 ? 10 : v.size());
         for (std::size_t i = 0; i < max; i++)
         {
-            ss << "{\"Key\": \"" << v[i].key << "\",\"Frequency\": " << v[i].frequency << '}';
+            ss << "{\"Key\": \"" << v[i].key << "\",\"Frequency\": " << v[i].frequency;
+            if (! v[i].error.empty()) // approximate engines report their overestimation bound
+                ss << ",\"Error\": " << v[i].error;
+            ss << '}';
             if (i < max - 1) ss << ',';
         }
         ss << "]}";
@@ -140,6 +214,83 @@ int MessageServer::onMessage(const std::string& inTarget, const std::string& inD
 
         return CMD_SUCCEEDED;
     }
+    else if (inTarget == "messagePoolStats")
+    {
+        MessagePool::Stats stats = MessagePool::getStats();
+        std::stringstream ss;
+        ss << "{\"Hits\": " << stats.hits << ",\"Misses\": " << stats.misses
+           << ",\"Blocks\": " << stats.blocks << ",\"Released\": " << stats.released
+           << ",\"BlockSize\": " << MessagePool::blockSize() << '}';
+        outData = ss.str();
+
+        if (ms_pInstance->m_verbosity >= Verbosity::info)
+            std::cout << "messagePoolStats :  " << outData << '\n';
+
+        return CMD_SUCCEEDED;
+    }
+    else if (inTarget == "overloadStats")
+    {
+        OverloadGuard::Stats stats = ms_pInstance->m_pMessageQueue->getOverloadStats();
+        std::stringstream ss;
+        ss << "{\"Capacity\": " << stats.capacity << ",\"Size\": " << stats.size
+           << ",\"Dropped\": " << stats.dropped << ",\"Sampled\": " << stats.sampled
+           << ",\"Blocked\": " << stats.blocked << '}';
+        outData = ss.str();
+
+        if (ms_pInstance->m_verbosity >= Verbosity::info)
+            std::cout << "overloadStats :  " << outData << '\n';
+
+        return CMD_SUCCEEDED;
+    }
+    else if (inTarget == "preAggregationStats")
+    {
+        KeyPreAggregator::Stats stats = {0, 0, 0, 0};
+        if (ms_pInstance->m_pAggregator != nullptr)
+            stats = ms_pInstance->m_pAggregator->getStats();
+
+        std::stringstream ss;
+        ss << "{\"Events\": " << stats.events << ",\"Messages\": " << stats.messages
+           << ",\"Dropped\": " << stats.dropped << ",\"Tables\": " << stats.tables << '}';
+        outData = ss.str();
+
+        if (ms_pInstance->m_verbosity >= Verbosity::info)
+            std::cout << "preAggregationStats :  " << outData << '\n';
+
+        return CMD_SUCCEEDED;
+    }
+    else if (inTarget == "udpStats")
+    {
+        UdpServer::Stats stats = {0, 0, 0, 0, 0};
+        if (ms_pInstance->m_pUdpServer != nullptr)
+            stats = ms_pInstance->m_pUdpServer->getStats();
+
+        std::stringstream ss;
+        ss << "{\"Datagrams\": " << stats.datagrams << ",\"Keys\": " << stats.keys
+           << ",\"Malformed\": " << stats.malformed << ",\"Shed\": " << stats.shed
+           << ",\"KernelDropped\": " << stats.kernelDropped << '}';
+        outData = ss.str();
+
+        if (ms_pInstance->m_verbosity >= Verbosity::info)
+            std::cout << "udpStats :  " << outData << '\n';
+
+        return CMD_SUCCEEDED;
+    }
+    else if (inTarget == "queueStats")
+    {
+        QueueStats stats = ms_pInstance->m_pMessageQueue->getQueueStats();
+        std::stringstream ss;
+        ss << "{\"LatencyNanoSec\": {\"Count\": " << stats.latency.count << ",\"P50\": " << stats.latency.p50
+           << ",\"P99\": " << stats.latency.p99 << ",\"P999\": " << stats.latency.p999
+           << ",\"Max\": " << stats.latency.max << "},\"Depth\": {\"Count\": " << stats.depth.count
+           << ",\"P50\": " << stats.depth.p50 << ",\"P99\": " << stats.depth.p99
+           << ",\"P999\": " << stats.depth.p999 << ",\"Max\": " << stats.depth.max << "}}";
+        outData = ss.str();
+
+        if (ms_pInstance->m_verbosity >= Verbosity::info)
+            std::cout << "queueStats :  " << outData << '\n';
+
+        return CMD_SUCCEEDED;
+    }
     else if (inTarget == "setTopHotKeys" || inTarget == "setKeyReportBaseSize")
     {
         int num = 0;
@@ -2,14 +2,23 @@
 //#include <csignal>
 #include <cstdlib>
 #include <iostream>
+#include <memory>
+#include <thread>
 #include <unistd.h>
 
 #include <boost/beast.hpp>
 
 #include "backupmanager.h"
+#include "binaryserver.h"
+#include "KeyPreAggregator.h"
 #include "MapManager.h"
 #include "messageserver.h"
+#include "PartitionedMessageQueue.h"
+#include "PerProducerMessageQueue.h"
+#include "ShardedMapManager.h"
+#include "SpaceSavingManager.h"
 #include "ThreadedMessageQueue.h"
+#include "udpserver.h"
 #include "web/webserver.h"
 
 #define DEFAULT_REPORTSIZE 10
@@ -19,18 +28,47 @@
 namespace net = boost::asio;    // from <boost/asio.hpp>
 namespace beast = boost::beast; // from <boost/beast.hpp>
 
-const size_t initialQueueNodes = 10000000; // 10M
-
 int main(int argc, char* argv[])
 {
     // 0:warnings & errors,  1:info,  2:trace,  3:debug
     Verbosity verbosity = 0;
     unsigned short threadQty = Listener::max_threads;
+    unsigned int counters = 0; // 0: exact MapManager, otherwise Space-Saving counter number
+    unsigned int batchSize = DEFAULT_KEY_BATCH_SIZE; // keys handed by the queue to the map manager at once
+    unsigned int partitions = 0; // 0: one queue and one MapManager, otherwise K queues and K shards
+    unsigned int ringSlots = 0; // 0: one queue shared by the listener threads, otherwise one ring per thread
+    size_t capacity = 0; // keys the queue holds at most, 0: unbounded
+    OverloadGuard::Policy policy = OverloadGuard::Policy::block; // what to do with a key beyond capacity
+    bool policyGiven = false;
+    unsigned int sampleRate = DEFAULT_OVERLOAD_SAMPLE_RATE;
+    long staleness = 0; // 0: keys queued one by one, otherwise pre-aggregated within this many uSec
+    bool asyncConnections = false; // every connection blocks one thread, otherwise served by handlers
+    bool threadQtyGiven = false;
+    int binaryPort = -1; // -1: no binary protocol server, 0: on the web port + 1
+    int udpPort = -1; // -1: no UDP key reports, 0: on the web port number
 
     // Check command line arguments.
     if(argc < 3)
     {
-        std::cerr << "Usage: " << argv[0] << " <IP address filter> <port> [threadsQTY] [-v[level]]\n";
+        std::cerr << "Usage: " << argv[0] << " <IP address filter> <port> [threadsQTY] [-v[level]] [-s[counters]] [-q[batch]] [-k[consumers]] [-r[slots]] [-c<capacity>] [-o<b|d|s>[rate]] [-a[uSec]] [-n] [-b[port]] [-u[port]]\n";
+        std::cerr << "  -s selects the bounded memory (Space-Saving) engine, default counters: "
+                  << SpaceSavingManager::ms_DefaultCounters << "\n";
+        std::cerr << "  -q sets the queue batch size (1: one key at a time), default: "
+                  << DEFAULT_KEY_BATCH_SIZE << "\n";
+        std::cerr << "  -k sets K key hash routed queues, each one with its consumer thread and its own\n"
+                  << "     map shard, default K: hardware threads\n";
+        std::cerr << "  -r gives every listener thread its own queue ring, default slots per ring: "
+                  << PRODUCER_RING_SLOTS << "\n";
+        std::cerr << "  -c bounds the queue to capacity keys, default: unbounded\n";
+        std::cerr << "  -o sets the policy beyond -c capacity: b(lock the listener), d(rop the newest key, 503 reply)\n"
+                  << "     or s(ample 1 of every rate keys from half the capacity on), default: b, rate: "
+                  << DEFAULT_OVERLOAD_SAMPLE_RATE << "\n";
+        std::cerr << "  -a counts the keys per listener thread and queues the counts at most uSec later,\n"
+                  << "     default uSec: " << PREAGGREGATION_STALENESS_MICROSECONDS << "\n";
+        std::cerr << "  -n serves the connections asynchronously: threadsQTY (default: hardware threads) serve\n"
+                  << "     thousands of keep-alive clients, instead of one blocked thread per client\n";
+        std::cerr << "  -b serves the compact binary protocol on a second port, default: the web port + 1\n";
+        std::cerr << "  -u takes fire and forget key records by UDP, default port: the web port number\n";
         std::cerr << "  For IPv4, try:\n";
         std::cerr << "    receiver 0.0.0.0 8080\n";
         std::cerr << "  For IPv6, try:\n";
@@ -42,29 +80,173 @@ int main(int argc, char* argv[])
     {
         unsigned short t = static_cast<unsigned short>(std::atoi(argv[3]));
         if (t > 0) threadQty = (threadQty > t ? t : threadQty);
+        threadQtyGiven = (t > 0);
 
-        if (argc >= 5 && argv[4][0] == '-' && argv[4][1] == 'v' && '0' <= argv[4][2] && argv[4][2] <= '9')
+        for (int i = 4; i < argc; i++)
         {
-            verbosity = argv[4][2] - '0';
+            if (argv[i][0] == '-' && argv[i][1] == 'v' && '0' <= argv[i][2] && argv[i][2] <= '9')
+            {
+                verbosity = argv[i][2] - '0';
+            }
+            else if (argv[i][0] == '-' && argv[i][1] == 's')
+            {
+                int c = std::atoi(argv[i] + 2);
+                counters = (c > 0 ? unsigned(c) : SpaceSavingManager::ms_DefaultCounters);
+            }
+            else if (argv[i][0] == '-' && argv[i][1] == 'q')
+            {
+                int b = std::atoi(argv[i] + 2);
+                batchSize = (b > 0 ? unsigned(b) : DEFAULT_KEY_BATCH_SIZE);
+            }
+            else if (argv[i][0] == '-' && argv[i][1] == 'k')
+            {
+                int k = std::atoi(argv[i] + 2);
+                unsigned int hw = std::thread::hardware_concurrency();
+                partitions = (k > 0 ? unsigned(k) : (hw > 0 ? hw : 1));
+            }
+            else if (argv[i][0] == '-' && argv[i][1] == 'r')
+            {
+                int r = std::atoi(argv[i] + 2);
+                ringSlots = (r > 0 ? unsigned(r) : PRODUCER_RING_SLOTS);
+            }
+            else if (argv[i][0] == '-' && argv[i][1] == 'c')
+            {
+                long c = std::atol(argv[i] + 2);
+                capacity = (c > 0 ? size_t(c) : 0);
+            }
+            else if (argv[i][0] == '-' && argv[i][1] == 'o' && OverloadGuard::parsePolicy(argv[i][2], policy))
+            {
+                int r = std::atoi(argv[i] + 3);
+                sampleRate = (r > 0 ? unsigned(r) : DEFAULT_OVERLOAD_SAMPLE_RATE);
+                policyGiven = true;
+            }
+            else if (argv[i][0] == '-' && argv[i][1] == 'a')
+            {
+                long a = std::atol(argv[i] + 2);
+                staleness = (a > 0 ? a : PREAGGREGATION_STALENESS_MICROSECONDS);
+            }
+            else if (argv[i][0] == '-' && argv[i][1] == 'n')
+            {
+                asyncConnections = true;
+            }
+            else if (argv[i][0] == '-' && argv[i][1] == 'b')
+            {
+                int b = std::atoi(argv[i] + 2);
+                binaryPort = (b > 0 && b <= 65535 ? b : 0);
+            }
+            else if (argv[i][0] == '-' && argv[i][1] == 'u')
+            {
+                int u = std::atoi(argv[i] + 2);
+                udpPort = (u > 0 && u <= 65535 ? u : 0);
+            }
         }
     }
 
     if (verbosity >= Verbosity::info)
         std::cout << "\nRequired verbosity: " << int(verbosity) << "\n";
 
+    if (partitions > 0 && ringSlots > 0)
+    {
+        std::cerr << "Warning: -r ignored, the -k partitioned queues take the keys.\n";
+        ringSlots = 0;
+    }
+
+    if (ringSlots > 0 && (capacity > 0 || policyGiven))
+        std::cerr << "Warning: -c and -o ignored, the -r rings are the capacity and their listeners wait for room.\n";
+    else if (policyGiven && capacity == 0)
+        std::cerr << "Warning: -o ignored, the queue is unbounded without -c<capacity>.\n";
+
+    if (asyncConnections && ! threadQtyGiven)
+    {
+        unsigned int hw = std::thread::hardware_concurrency();
+        threadQty = static_cast<unsigned short>(hw > 0 ? hw : 1);
+    }
+
     auto const addressFilter = net::ip::make_address(argv[1]);
     unsigned short port = static_cast<unsigned short>(std::atoi(argv[2]));
 
     // Print pid, so that we can send signals from other shells.
     std::cout << "tracker pid is: " << getpid() << '\n';
 
-    MapManager mapMgr(DEFAULT_REPORTSIZE, MAX_REPORTSIZE, verbosity);
-    ThreadedMessageQueue queue(initialQueueNodes);
-    queue.setConsumer(&mapMgr);
-    BackupManager backupMgr(&mapMgr, ONE_HOUR, verbosity); // ONLY TEST: every 10 sec !!
+    std::unique_ptr<IMapManager> pMapMgr;
+    if (counters > 0)
+        pMapMgr.reset(new SpaceSavingManager(counters, DEFAULT_REPORTSIZE, MAX_REPORTSIZE, verbosity));
+    else if (partitions > 0) // shard i is only touched by the consumer of queue i
+        pMapMgr.reset(new ShardedMapManager(partitions, DEFAULT_REPORTSIZE, MAX_REPORTSIZE, verbosity));
+    else
+        pMapMgr.reset(new MapManager(DEFAULT_REPORTSIZE, MAX_REPORTSIZE, verbosity));
+
+    if (verbosity >= Verbosity::info && counters > 0)
+        std::cout << "Space-Saving engine with " << counters << " counters.\n";
+
+    // Queue storage is mapped on demand: one segment is kept while idle.
+    const size_t queueNodes = SegmentedMessageQueue::ms_SegmentSlots;
+    std::unique_ptr<MessageServer::IMessageQueue> pQueue;
+    if (partitions > 0)
+    {
+        PartitionedMessageQueue* pPartitioned = new PartitionedMessageQueue(partitions, queueNodes, batchSize);
+        pPartitioned->setOverloadPolicy(capacity, policy, sampleRate);
+        pQueue.reset(pPartitioned);
+    }
+    else if (ringSlots > 0) // the rings are the capacity: listeners wait for room
+    {
+        pQueue.reset(new PerProducerMessageQueue(ringSlots, batchSize));
+    }
+    else
+    {
+        ThreadedMessageQueue* pThreaded = new ThreadedMessageQueue(queueNodes, batchSize);
+        pThreaded->setOverloadPolicy(capacity, policy, sampleRate);
+        pQueue.reset(pThreaded);
+    }
+
+    if (verbosity >= Verbosity::info && capacity > 0 && ringSlots == 0)
+        std::cout << "Queue capacity " << capacity << " keys, overload policy "
+                  << OverloadGuard::getPolicyName(policy) << ".\n";
+
+    if (verbosity >= Verbosity::info && partitions > 0)
+        std::cout << partitions << " key partitioned queues and consumers.\n";
+    else if (verbosity >= Verbosity::info && ringSlots > 0)
+        std::cout << "One queue ring of " << ringSlots << " slots per listener thread.\n";
+
+    MessageServer::IMessageQueue& queue = *pQueue;
+    queue.setConsumer(pMapMgr.get());
+    BackupManager backupMgr(pMapMgr.get(), ONE_HOUR, verbosity); // ONLY TEST: every 10 sec !!
     backupMgr.setFilenames("keys", "frequencies", "csv");
-    WebServer webSrv(addressFilter, port, threadQty, verbosity);
-    MessageServer msgSrv(&mapMgr, &queue, &backupMgr, &webSrv, verbosity);
+    WebServer webSrv(addressFilter, port, threadQty, verbosity, asyncConnections);
+    if (verbosity >= Verbosity::info && asyncConnections)
+        std::cout << "Asynchronous connections served by " << threadQty << " threads.\n";
+    std::unique_ptr<KeyPreAggregator> pAggregator;
+    if (staleness > 0)
+    {
+        pAggregator.reset(new KeyPreAggregator(queue, std::chrono::microseconds(staleness)));
+        if (verbosity >= Verbosity::info)
+            std::cout << "Keys pre-aggregated per listener thread, queued within " << staleness << " uSec.\n";
+    }
+
+    std::unique_ptr<UdpServer> pUdpSrv;
+    if (udpPort >= 0)
+    {
+        // One socket and thread each: hardware threads unless a thread quantity was given.
+        unsigned int hw = std::thread::hardware_concurrency();
+        unsigned short udpThreads = threadQtyGiven ? threadQty : static_cast<unsigned short>(hw > 0 ? hw : 1);
+        unsigned short uPort = static_cast<unsigned short>(udpPort > 0 ? udpPort : port);
+        pUdpSrv.reset(new UdpServer(argv[1], uPort, queue, udpThreads, verbosity));
+        std::cout << "UDP key reports on port " << uPort << ".\n";
+    }
+
+    MessageServer msgSrv(pMapMgr.get(), &queue, &backupMgr, &webSrv, verbosity, pAggregator.get(), pUdpSrv.get());
+
+    std::unique_ptr<BinaryServer> pBinarySrv;
+    if (binaryPort >= 0)
+    {
+        // Served by handlers, like -n: hardware threads unless a thread quantity was given.
+        unsigned int hw = std::thread::hardware_concurrency();
+        unsigned short binaryThreads = threadQtyGiven ? threadQty : static_cast<unsigned short>(hw > 0 ? hw : 1);
+        unsigned short binPort = static_cast<unsigned short>(binaryPort > 0 ? binaryPort : port + 1);
+        pBinarySrv.reset(new BinaryServer(addressFilter, binPort, binaryThreads, verbosity));
+        msgSrv.addCommServer(pBinarySrv.get());
+        std::cout << "Binary protocol on port " << binPort << ".\n";
+    }
 
     int signal = 0;
     // Capture SIGHUP for restarting this process, or SIGINT and SIGQUIT to perform a clean shutdown.
@@ -110,6 +292,7 @@ int main(int argc, char* argv[])
     if (verbosity >= Verbosity::info)
         std::cout << "Done.\nStopping message queue...\n";
 
+    pAggregator.reset(); // the last counts are queued
     queue.stop();
 
     if (verbosity >= Verbosity::info)
@@ -0,0 +1,193 @@
+/**
+ * @file udpserver.cpp
+ * @brief UdpServer implementation. recvmmsg() batches straight into the message queue.
+ * @author Guillermo M. Paris
+ * @date 2026-10-18
+ */
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "KeyBatch.h"
+#include "udpserver.h"
+
+UdpServer::UdpServer( const std::string& address, unsigned short port, IMessageQueue& queue,
+                      unsigned short threads /*= 1*/, Verbosity v /*= 0*/,
+                      size_t maxDatagram /*= UDP_MAX_DATAGRAM*/ )
+    : m_verbosity(v)
+    , m_address(address)
+    , m_nPort(port)
+    , m_nThreads(threads > 0 ? threads : 1)
+    , m_maxDatagram(maxDatagram > 0 ? maxDatagram : UDP_MAX_DATAGRAM)
+    , m_queue(queue)
+    , m_running(false)
+    , m_datagrams(0)
+    , m_keys(0)
+    , m_malformed(0)
+    , m_shed(0)
+    , m_kernelDropped(m_nThreads)
+{
+}
+
+UdpServer::~UdpServer()
+{
+    stop();
+}
+
+bool UdpServer::start()
+{
+    addrinfo hints;
+    std::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_DGRAM;
+    hints.ai_flags = AI_PASSIVE | AI_NUMERICHOST;
+    addrinfo* pAddress = nullptr;
+    int rc = getaddrinfo(m_address.c_str(), std::to_string(m_nPort).c_str(), &hints, &pAddress);
+    if (rc != 0)
+    {
+        std::cerr << "UDP address " << m_address << " error: " << gai_strerror(rc) << '\n';
+        return false;
+    }
+
+    m_running = true;
+    for (unsigned short i = 0; i < m_nThreads; i++)
+    {
+        int fd = socket(pAddress->ai_family, SOCK_DGRAM, 0);
+        int on = 1, buffer = UDP_SOCKET_BUFFER;
+        timeval timeout = {0, 100000}; // the threads check m_running every 100 mSec when idle
+        if ( fd < 0
+          || setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on)) < 0
+          || setsockopt(fd, SOL_SOCKET, SO_RXQ_OVFL, &on, sizeof(on)) < 0
+          || setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &buffer, sizeof(buffer)) < 0
+          || setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout)) < 0
+          || bind(fd, pAddress->ai_addr, pAddress->ai_addrlen) < 0 )
+        {
+            std::cerr << "UDP socket on port " << m_nPort << " error: " << std::strerror(errno) << '\n';
+            if (fd >= 0)
+                close(fd);
+            freeaddrinfo(pAddress);
+            stop();
+            return false;
+        }
+
+        m_sockets.push_back(fd);
+    }
+
+    freeaddrinfo(pAddress);
+    for (size_t i = 0; i < m_sockets.size(); i++)
+        m_threads.emplace_back([this, i] { receive(m_sockets[i], i); });
+
+    return true;
+}
+
+bool UdpServer::stop()
+{
+    m_running = false;
+    for (std::thread& t : m_threads)
+    {
+        if (t.joinable())
+            t.join();
+    }
+
+    for (int fd : m_sockets)
+        close(fd);
+
+    m_threads.clear();
+    m_sockets.clear();
+    return true;
+}
+
+void UdpServer::receive(int fd, size_t socketIndex)
+{
+    // One buffer, iovec and control block per datagram of a batch, reused from call to call.
+    std::vector<char> buffers(UDP_RECV_BATCH * m_maxDatagram);
+    mmsghdr  messages[UDP_RECV_BATCH];
+    iovec    iovecs[UDP_RECV_BATCH];
+    char     controls[UDP_RECV_BATCH][CMSG_SPACE(sizeof(uint32_t))];
+    std::memset(messages, 0, sizeof(messages));
+    for (unsigned i = 0; i < UDP_RECV_BATCH; i++)
+    {
+        iovecs[i].iov_base = &buffers[i * m_maxDatagram];
+        iovecs[i].iov_len = m_maxDatagram;
+        messages[i].msg_hdr.msg_iov = &iovecs[i];
+        messages[i].msg_hdr.msg_iovlen = 1;
+        messages[i].msg_hdr.msg_control = controls[i];
+    }
+
+    while (m_running)
+    {
+        for (unsigned i = 0; i < UDP_RECV_BATCH; i++)
+        {
+            messages[i].msg_hdr.msg_controllen = sizeof(controls[i]);
+            messages[i].msg_hdr.msg_flags = 0;
+        }
+
+        // Waits for the first datagram only, then takes whatever else is already there.
+        int n = recvmmsg(fd, messages, UDP_RECV_BATCH, MSG_WAITFORONE, nullptr);
+        if (n < 0)
+        {
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+                continue;
+
+            std::cerr << "UDP receive error: " << std::strerror(errno) << '\n';
+            break;
+        }
+
+        for (int i = 0; i < n; i++)
+        {
+            msghdr& header = messages[i].msg_hdr;
+            processDatagram(static_cast<const char*>(iovecs[i].iov_base), messages[i].msg_len,
+                            (header.msg_flags & MSG_TRUNC) != 0);
+
+            for (cmsghdr* c = CMSG_FIRSTHDR(&header); c != nullptr; c = CMSG_NXTHDR(&header, c))
+            {
+                if (c->cmsg_level == SOL_SOCKET && c->cmsg_type == SO_RXQ_OVFL)
+                {
+                    uint32_t dropped = 0; // the socket total so far
+                    std::memcpy(&dropped, CMSG_DATA(c), sizeof(dropped));
+                    m_kernelDropped[socketIndex].store(dropped, std::memory_order_relaxed);
+                }
+            }
+        }
+    }
+}
+
+void UdpServer::processDatagram(const char* data, size_t size, bool truncated)
+{
+    m_datagrams.fetch_add(1, std::memory_order_relaxed);
+    if (m_verbosity >= Verbosity::trace)
+        std::cout << "UDP datagram of " << size << " bytes" << (truncated ? ", truncated" : "") << ".\n";
+
+    // Only counted here: the queue thread parses the records of the copy, in place.
+    const size_t n = truncated ? 0 : countKeyRecords(std::string_view(data, size));
+    if (n == 0)
+    {
+        m_malformed.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    // As a /keysSent bulk.
+    Message* pMessage = new Message( Message::Command::addKeys, std::string(data, size), std::string(),
+                                     0, 0, uint32_t(n) );
+    // A partitioned queue may shed only part of the records.
+    const size_t queued = m_queue.pushKeys(pMessage, n);
+    m_keys.fetch_add(queued, std::memory_order_relaxed);
+    if (queued < n)
+        m_shed.fetch_add(n - queued, std::memory_order_relaxed);
+}
+
+UdpServer::Stats UdpServer::getStats() const
+{
+    uint64_t kernelDropped = 0;
+    for (const std::atomic<uint32_t>& dropped : m_kernelDropped)
+        kernelDropped += dropped.load(std::memory_order_relaxed);
+
+    return { m_datagrams.load(std::memory_order_relaxed), m_keys.load(std::memory_order_relaxed),
+             m_malformed.load(std::memory_order_relaxed), m_shed.load(std::memory_order_relaxed),
+             kernelDropped };
+}
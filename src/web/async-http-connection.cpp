@@ -0,0 +1,79 @@
+/**
+ * @file async-http-connection.cpp
+ * @brief AsyncHttpConnection implementation.
+ * @author Guillermo M. Paris
+ * @date 2026-10-18
+ */
+
+#include <iostream>
+#include "web/async-http-connection.h"
+
+namespace beast = boost::beast;    // from <boost/beast.hpp>
+namespace http = beast::http;      // from <boost/beast/http.hpp>
+namespace net = boost::asio;       // from <boost/asio.hpp>
+
+void AsyncHttpConnection::start()
+{
+    m_running = true;
+    readRequestAsync();
+}
+
+void AsyncHttpConnection::readRequestAsync()
+{
+    m_writeReady = false;
+    m_request = {}; // the body reader appends: no body left from the previous request
+
+    http::async_read(m_socket, m_buffer, m_request,
+        [self = self()](beast::error_code ec, size_t bytes_read)
+        {
+            self->onRead(ec, bytes_read);
+        });
+}
+
+void AsyncHttpConnection::onRead(beast::error_code ec, size_t bytes_read)
+{
+    if (ec)
+    {
+        reportReadError(ec, bytes_read);
+        stop(); // the last handler: the connection is released on return
+        return;
+    }
+
+    if (m_verbosity >= Verbosity::trace)
+        std::cout << "Procesing incomming request of " << bytes_read << " bytes.\n";
+
+    processRequest();
+    queueResponse();
+    processBufferedRequests(); // pipelined behind: answered in the same write
+    writeResponseAsync();
+}
+
+void AsyncHttpConnection::writeResponseAsync()
+{
+    net::async_write(m_socket, getPendingBuffers(),
+        [self = self()](beast::error_code ec, size_t bytes_written)
+        {
+            self->onWrite(ec, bytes_written);
+        });
+}
+
+void AsyncHttpConnection::onWrite(beast::error_code ec, size_t bytes_written)
+{
+    if (ec)
+    {
+        std::cerr << "\nWrite error: "
+                  << "code " << ec.value()
+                  << ", reason: "<< ec.message()
+                  << ", bytes written " << bytes_written
+                  << "\n";
+        stop();
+        return;
+    }
+
+    if (m_verbosity >= Verbosity::trace)
+        std::cout << bytes_written << " bytes were just sent for " << m_pendingNumber << " responses.\n";
+
+    clearPendingResponses();
+    if (m_running)
+        readRequestAsync();
+}
@@ -1,10 +1,12 @@
 
 #include <boost/beast/version.hpp>
+#include <algorithm>
 #include <chrono>
 #include <ctime>
 #include <fstream>
 #include <iostream>
 #include <string>
+#include <thread>
 #include "web/http-connection.h"
 
 namespace beast = boost::beast;    // from <boost/beast.hpp>
@@ -15,6 +17,7 @@ using bsys_error_code = boost::system::error_code;
 using tcp = boost::asio::ip::tcp;  // from <boost/asio/ip/tcp.hpp>
 
 // Initiate the synchronous operations associated with the connection.
+// Every request already read is answered in one write: pipelined requests cost no round trip.
 void HttpConnection::run()
 {
     m_running = true;
@@ -40,24 +43,14 @@ void HttpConnection::stop()
 void HttpConnection::readRequest()
 {
     m_writeReady = false;
-    m_buffer.consume(10000);
+    m_request = {}; // the body reader appends: no body left from the previous request
     auto self = shared_from_this();
 
     boost::beast::error_code ec;
     size_t bytes_read = http::read(m_socket, m_buffer, m_request, ec);
     if(ec)
     {
-        if ( (  ec != http::error::end_of_stream &&
-                ec.value() != bsys_errc::connection_reset &&
-                ec.value() != bsys_errc::connection_aborted )
-                || m_verbosity >= Verbosity::debug )
-        {
-            std::cerr << "\nRead error: "
-                      << "code " << ec.value()
-                      << ", reason: "<< ec.message()
-                      << ", bytes read "
-                      << bytes_read << "\n";
-        }
+        reportReadError(ec, bytes_read);
         self->stop();
     }
     else if (bytes_read == 0) // should never happen
@@ -71,6 +64,23 @@ void HttpConnection::readRequest()
             std::cout << "Procesing incomming request of " << bytes_read << " bytes.\n";
 
         self->processRequest();
+        self->queueResponse();
+        self->processBufferedRequests();
+    }
+}
+
+void HttpConnection::reportReadError(const beast::error_code& ec, size_t bytes_read)
+{
+    if ( (  ec != http::error::end_of_stream &&
+            ec.value() != bsys_errc::connection_reset &&
+            ec.value() != bsys_errc::connection_aborted )
+            || m_verbosity >= Verbosity::debug )
+    {
+        std::cerr << "\nRead error: "
+                  << "code " << ec.value()
+                  << ", reason: "<< ec.message()
+                  << ", bytes read "
+                  << bytes_read << "\n";
     }
 }
 
@@ -116,7 +126,7 @@ void HttpConnection::processRequest()
         break;
     }
 
-    m_buffer.clear();
+    // The buffer is kept: it may already hold the next requests (pipelining).
     // Workaround to get rid previous m_response not able to clear itself.
     m_response = std::move(response);
     m_writeReady = true;
@@ -156,7 +166,7 @@ void HttpConnection::createGetResponse(http::response<http::dynamic_body> & resp
 
         if ( (retval = m_getFunctor(target, reply)) >= 0)  // process the request
         {
-            response.result(retval == 0 ? http::status::internal_server_error : http::status::ok);
+            setResult(response, retval);
             target.push_back(':');
             insertHtmlInResponse( response, reply.c_str(),
                                   "Reply from Hotspot Tracker", target.c_str() );
@@ -192,7 +202,7 @@ void HttpConnection::createPostResponse(http::response<http::dynamic_body> & res
     if ( found && (retval = m_postFunctor(target, data, reply)) >= 0 )  // process the request
     {
         target.push_back(':');
-        response.result(retval == 0 ? http::status::internal_server_error : http::status::ok);
+        setResult(response, retval);
         insertHtmlInResponse( response, reply.c_str(),
                               "Reply from Hotspot Tracker", target.c_str() );
     }
@@ -205,20 +215,13 @@ void HttpConnection::createPostResponse(http::response<http::dynamic_body> & res
     }
 }
 
-// Synchronously transmit the response message.
+// Synchronously transmit the pending responses in one gathered write.
 void HttpConnection::writeResponse()
 {
     auto self = shared_from_this();
-    size_t size = m_response.body().size();
-
-    m_response.set(http::field::content_length, size);
-
-    if (m_verbosity >= Verbosity::debug)
-        std::cout << "What it is about to send to the client: Sending response of "
-                  << size << " body's bytes:\n\n"  << m_response << "\n\n";
 
     boost::beast::error_code ec;
-    size_t bytes_written = http::write(m_socket, m_response, ec);
+    size_t bytes_written = net::write(m_socket, getPendingBuffers(), ec);
     if (ec)
     {
         std::cerr << "\nWrite error: "
@@ -231,41 +234,140 @@ void HttpConnection::writeResponse()
     }
 
     if (m_verbosity >= Verbosity::trace)
-        std::cout << bytes_written << " bytes were just sent.\n";
+        std::cout << bytes_written << " bytes were just sent for " << m_pendingNumber << " responses.\n";
 
-    m_response.clear(); // useless !!
+    clearPendingResponses();
 }
 
-bool HttpConnection::retrieveBody(std::string& sBody)
+void HttpConnection::prepareResponse()
 {
-    size_t bodylength = std::stoul(m_request[http::field::content_length].data());
-    if (bodylength == 0 || bodylength >= ms_maxBufferSize)
-    {
+    size_t size = m_response.body().size();
+
+    m_response.content_length(size);
+
+    if (m_verbosity >= Verbosity::debug)
+        std::cout << "What it is about to send to the client: Sending response of "
+                  << size << " body's bytes:\n\n"  << m_response << "\n\n";
+}
+
+bool HttpConnection::parseBufferedRequest()
+{
+    if (m_buffer.size() == 0)
         return false;
+
+    http::request_parser<http::dynamic_body> parser;
+    parser.eager(true);
+    parser.body_limit(ms_maxBodySize);
+
+    const char* data = static_cast<const char*>(m_buffer.data().data());
+    const size_t size = m_buffer.size();
+    size_t used = 0;
+    beast::error_code ec;
+    while (! parser.is_done())
+    {
+        const size_t n = parser.put(net::buffer(data + used, size - used), ec);
+        if (ec || n == 0) // need_more: the rest is read by the next readRequest, errors too
+            return false;
+        used += n;
     }
 
-    const char* pmsg = static_cast<const char*>( m_buffer.data().data() );
-    size_t msglen = strlen(pmsg);
-    if (msglen <= bodylength || msglen >= ms_maxBufferSize)
+    m_buffer.consume(used);
+    m_request = parser.release();
+    return true;
+}
+
+void HttpConnection::queueResponse()
+{
+    prepareResponse();
+
+    if (m_pending.size() == m_pendingNumber)
+        m_pending.emplace_back();
+    std::string& out = m_pending[m_pendingNumber++];
+    out.clear();
+
+    http::response_serializer<http::dynamic_body> serializer(m_response);
+    beast::error_code ec;
+    do
     {
+        serializer.next(ec, [&](beast::error_code& ec, const auto& buffers)
+        {
+            ec = {};
+            for (net::const_buffer b : beast::buffers_range_ref(buffers))
+                out.append(static_cast<const char*>(b.data()), b.size());
+            serializer.consume(beast::buffer_bytes(buffers));
+        });
+    }
+    while (! ec && ! serializer.is_done());
+
+    m_response.clear();
+    m_writeReady = true;
+}
+
+bool HttpConnection::readAvailable()
+{
+    boost::system::error_code ec;
+    const size_t available = m_socket.available(ec);
+    const size_t room = m_buffer.max_size() - m_buffer.size();
+    if (ec || available == 0 || room == 0)
         return false;
+
+    const size_t n = m_socket.read_some(m_buffer.prepare(std::min(available, room)), ec);
+    m_buffer.commit(n);
+    return ! ec && n > 0;
+}
+
+void HttpConnection::processBufferedRequests()
+{
+    // The first read may take only part of a burst: the rest is picked up before writing.
+    while (m_running)
+    {
+        bool parsed = parseBufferedRequest();
+        while (! parsed && readAvailable())
+            parsed = parseBufferedRequest();
+        if (! parsed)
+            break;
+
+        if (m_verbosity >= Verbosity::trace)
+            std::cout << "Procesing pipelined request.\n";
+
+        processRequest();
+        queueResponse();
     }
+}
+
+const std::vector<net::const_buffer>& HttpConnection::getPendingBuffers()
+{
+    m_pendingBuffers.clear();
+    for (size_t i = 0; i < m_pendingNumber; i++)
+        m_pendingBuffers.push_back(net::buffer(m_pending[i]));
 
-    std::string_view   msgView(pmsg, msglen);
-    const std::size_t  NPOS = std::string::npos;
-    std::size_t        pos = msgView.rfind("Content-Length: ");
-    if (pos == NPOS || (pos = msgView.find("\r\n", pos)) == NPOS)
+    return m_pendingBuffers;
+}
+
+void HttpConnection::setResult(http::response<http::dynamic_body> & response, int retval)
+{
+    if (retval == CMD_OVERLOADED) // shed: the client should come back later
     {
-        return false;
+        response.result(http::status::service_unavailable);
+        response.set(http::field::retry_after, std::to_string(RETRY_AFTER_SECONDS));
     }
+    else
+    {
+        response.result(retval == CMD_FAILED ? http::status::internal_server_error : http::status::ok);
+    }
+}
 
-    if ((pos = msgView.find_first_not_of("\r\n", pos)) != NPOS)
+bool HttpConnection::retrieveBody(std::string& sBody)
+{
+    // The parsed body: the read buffer may already hold the next request.
+    size_t bodylength = m_request.body().size();
+    if (bodylength == 0 || bodylength > ms_maxBodySize)
     {
-        sBody.assign(msgView, pos, bodylength);
-        return true;
+        return false;
     }
 
-    return false;
+    sBody = beast::buffers_to_string(m_request.body().data());
+    return true;
 }
 
 void HttpConnection::insertHtmlInResponse( http::response<http::dynamic_body> & response,
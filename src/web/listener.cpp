@@ -1,6 +1,8 @@
 
 #include <iostream>
+#include <thread>
 
+#include "web/async-http-connection.h"
 #include "web/http-connection.h"
 #include "web/listener.h"
 
@@ -10,8 +12,9 @@ namespace net = boost::asio;       // from <boost/asio.hpp>
 using tcp = boost::asio::ip::tcp;  // from <boost/asio/ip/tcp.hpp>
 
 Listener::Listener( net::ip::address address, unsigned short port,
-                    unsigned short threadQty, Verbosity v /* = 0 */ )
+                    unsigned short threadQty, Verbosity v /* = 0 */, bool async /* = false */ )
     : m_verbosity(v)
+    , m_async(async)
     , m_ioc(threadQty)
     , m_acceptor(m_ioc, {address, port})
     , m_threadQty(threadQty)
@@ -54,6 +57,14 @@ void Listener::accept()
                 std::cerr << "Acceptor error: " << ec.message() << std::endl;
                 std::this_thread::sleep_for(std::chrono::milliseconds(1));
             }
+            else if (self->m_async)
+            {
+                std::shared_ptr<AsyncHttpConnection> http = std::make_shared<AsyncHttpConnection>(socket);
+                http->setReporters(self->m_getFunctor, self->m_postFunctor);
+
+                // Arms its first read and returns: accept again right away.
+                http->start();
+            }
             else
             {
                 if (self->m_verbosity >= Verbosity::trace)
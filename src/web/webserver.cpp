@@ -23,14 +23,15 @@ namespace net = boost::asio;     // from <boost/asio.hpp>
 WebServer*  WebServer::ms_pInstance(nullptr);
 
 WebServer::WebServer( net::ip::address ip, const unsigned short port,
-                      const unsigned short threads /*= 1*/, Verbosity v /*= 0*/ )
+                      const unsigned short threads /*= 1*/, Verbosity v /*= 0*/,
+                      bool async /*= false*/ )
     : m_ipAddress(ip)
     , m_nPort(port)
     , m_nThreads(threads)
     , m_verbosity(v)
     , m_localFunctor(onGetMessage)
 {
-    m_qListener = std::make_shared<Listener>(m_ipAddress, m_nPort, m_nThreads, v);
+    m_qListener = std::make_shared<Listener>(m_ipAddress, m_nPort, m_nThreads, v, async);
 
 /*  None of this worked to create a functor on non static member function.
     m_qListener->setReporters( std::function<bool (const std::string&, std::string&)>(onGetMessage),
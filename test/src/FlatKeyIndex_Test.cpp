@@ -0,0 +1,144 @@
+/**
+ * @file FlatKeyIndex_Test.cpp
+ * @brief Unit tests for FlatKeyIndex, and benchmark against the former std::map key index.
+ * @author Guillermo M. Paris
+ * @date 2026-10-18
+ */
+
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+#include "test-macros.h"
+#include "test.h"
+#include "FlatKeyIndex_Test.h"
+#include "MapManager.h"
+
+extern uint8_t genRandomNumbers[];
+extern const char* firstHundred[100];
+
+/*****************************
+ *    FlatKeyIndex Tests     *
+*****************************/
+
+void flatkeyindex_functionalTest(TEST_REF)
+{
+    FlatKeyIndex<unsigned long> index;
+    EXPECT_TRUE(index.empty());
+    EXPECT_NULL(index.find("missing"));
+
+    // Enough keys to force several rehashes; a few of them longer than an arena block.
+    const unsigned int keys = 100000;
+    unsigned int inserted = 0;
+    for (unsigned int i = 0; i < keys; ++i)
+    {
+        std::string key("key-" + std::to_string(i));
+        if (i % 20000 == 7) key.append(FLATKEYINDEX_ARENA_BLOCK, 'x');
+        if (index.tryEmplace(key, i).second) ++inserted;
+    }
+
+    EXPECT_EQ(inserted, keys);
+    EXPECT_EQ(index.size(), size_t(keys));
+    EXPECT_LE(index.size(), index.capacity() - index.capacity() / 8);
+
+    unsigned int found = 0;
+    for (unsigned int i = 0; i < keys; ++i)
+    {
+        std::string key("key-" + std::to_string(i));
+        if (i % 20000 == 7) key.append(FLATKEYINDEX_ARENA_BLOCK, 'x');
+        unsigned long* pValue = index.find(key);
+        if (pValue != nullptr && *pValue == i) ++found;
+    }
+    EXPECT_EQ(found, keys);
+
+    auto r = index.tryEmplace("key-42", 0UL);
+    EXPECT_FALSE(r.second);
+    EXPECT_EQ(r.first->value, 42UL);
+    EXPECT_NULL(index.find("key-"));
+    EXPECT_NULL(index.find("key-100000"));
+
+    std::vector<const FlatKeyIndex<unsigned long>::Slot*> sorted;
+    index.sortedSlots(sorted);
+    EXPECT_EQ(sorted.size(), size_t(keys));
+    bool ordered = true;
+    for (size_t i = 1; i < sorted.size(); ++i)
+        ordered = ordered && sorted[i - 1]->key < sorted[i]->key;
+    EXPECT_TRUE(ordered);
+
+    index.clear();
+    EXPECT_Z(index.size());
+    EXPECT_NULL(index.find("key-42"));
+}
+
+// Same "insert or increment" job MapManager does per key, on both containers.
+void flatkeyindex_benchmark(TEST_REF, const char* title, const std::vector<std::string>& keys)
+{
+    using Details = MapManager::KeyDetails;
+    using clock = std::chrono::steady_clock;
+
+    std::map<std::string, Details> orderedMap;
+    FlatKeyIndex<Details> flatIndex;
+
+    auto start = clock::now();
+    for (const std::string& key : keys)
+    {
+        auto it = orderedMap.lower_bound(key);
+        if (it != orderedMap.end() && it->first == key)
+            ++it->second.frequency;
+        else
+            orderedMap.emplace_hint(it, key, Details(0U, 80, 1));
+    }
+    auto middle = clock::now();
+    for (const std::string& key : keys)
+    {
+        auto r = flatIndex.tryEmplace(key, 0U, 80U, 1UL);
+        if (! r.second) ++r.first->value.frequency;
+    }
+    auto finish = clock::now();
+
+    EXPECT_EQ(flatIndex.size(), orderedMap.size());
+    unsigned int mismatches = 0;
+    for (const auto& kv : orderedMap)
+    {
+        const Details* pDetails = flatIndex.find(kv.first);
+        if (pDetails == nullptr || pDetails->frequency != kv.second.frequency) ++mismatches;
+    }
+    EXPECT_Z(mismatches);
+
+    double mapMs = std::chrono::duration<double, std::milli>(middle - start).count();
+    double flatMs = std::chrono::duration<double, std::milli>(finish - middle).count();
+    std::cout << title << ": " << keys.size() << " updates over " << orderedMap.size() << " distinct keys\n"
+              << "  std::map     : " << mapMs << " mSec\n"
+              << "  FlatKeyIndex : " << flatMs << " mSec (x" << (flatMs > 0 ? mapMs / flatMs : 0) << ")\n";
+}
+
+void FlatKeyIndexTests(TEST_REF)
+{
+    std::cout << "\nFlat key index functional test starting ...\n";
+    flatkeyindex_functionalTest(TEST);
+    std::cout << "Flat key index functional test finished.\n";
+
+    std::cout << "\nFlat key index vs std::map benchmark starting ...\n";
+    std::vector<std::string> keys;
+    const size_t updates = 4000000;
+    keys.reserve(updates);
+
+    // The test key set: few thousand distinct keys, heavily repeated.
+    for (size_t i = 0, j = 0; i < updates; ++i)
+    {
+        unsigned idx0 = genRandomNumbers[j++];
+        unsigned idx1 = genRandomNumbers[j++];
+        keys.emplace_back(firstHundred[idx0%100]);
+        keys.back() += ' ';
+        keys.back() += firstHundred[idx1%100];
+    }
+    flatkeyindex_benchmark(TEST, "Low cardinality", keys);
+
+    // High cardinality: every key seen twice.
+    keys.clear();
+    for (size_t i = 0; i < updates; ++i)
+        keys.emplace_back("backend-key-" + std::to_string((i * 2654435761U) % (updates / 2)));
+    flatkeyindex_benchmark(TEST, "High cardinality", keys);
+    std::cout << "Flat key index vs std::map benchmark finished.\n" << std::endl;
+}
@@ -0,0 +1,10 @@
+/**
+ * @file FlatKeyIndex_Test.h
+ * @brief Flat key index test prototypes.
+ * @author Guillermo M. Paris
+ * @date 2026-10-18
+ */
+
+#include "FlatKeyIndex.h"
+
+void FlatKeyIndexTests(TEST_REF);
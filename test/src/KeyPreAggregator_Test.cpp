@@ -0,0 +1,205 @@
+/**
+ * @file KeyPreAggregator_Test.cpp
+ * @brief Unit tests and skewed traffic benchmark for KeyPreAggregator.
+ * @author Guillermo M. Paris
+ * @date 2026-10-18
+ */
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "test-macros.h"
+#include "test.h"
+#include "KeyPreAggregator_Test.h"
+
+/**************************
+ * KeyPreAggregator Tests *
+**************************/
+
+// Skewed traffic: hotShare of the events go to 20 hot keys, the rest spread over coldKeys keys.
+void preaggregation_buildTraffic(std::vector<std::string>& keys, std::vector<uint32_t>& events,
+                                 size_t eventNumber, double hotShare, uint32_t coldKeys)
+{
+    const uint32_t hotKeys = 20;
+    keys.clear();
+    for (uint32_t i = 0; i < hotKeys + coldKeys; i++)
+        keys.push_back((i < hotKeys ? "hot key " : "cold key ") + std::to_string(i));
+
+    std::mt19937 generator(2026);
+    std::bernoulli_distribution hot(hotShare);
+    std::uniform_int_distribution<uint32_t> hotKey(0, hotKeys - 1), coldKey(hotKeys, hotKeys + coldKeys - 1);
+    events.resize(eventNumber);
+    for (uint32_t& event : events)
+        event = hot(generator) ? hotKey(generator) : coldKey(generator);
+}
+
+void preaggregation_waitApplied(ThreadedMessageQueue& q)
+{
+    while (! q.isEmpty())
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    q.stop(); // applies the last batch
+}
+
+// Every thread sends its share of the events, pre-aggregated or one message each. Returns the
+// seconds until the map manager applied the last one.
+double preaggregation_run(MapManager& m, const std::vector<std::string>& keys, const std::vector<uint32_t>& events,
+                          unsigned threads, bool aggregate, KeyPreAggregator::Stats& stats)
+{
+    ThreadedMessageQueue q(1024);
+    q.setConsumer(&m);
+    q.start();
+
+    auto start = std::chrono::steady_clock::now();
+    {
+        KeyPreAggregator aggregator(q);
+        std::vector<std::thread> senders;
+        const size_t share = events.size() / threads;
+        for (unsigned t = 0; t < threads; t++)
+        {
+            senders.emplace_back([&, t]
+            {
+                for (size_t i = t * share; i < (t + 1) * share; i++)
+                {
+                    const std::string& key = keys[events[i]];
+                    if (aggregate)
+                        aggregator.addKey(key, "www.preaggregation.com", events[i]);
+                    else
+                        q.push(new Message(Message::Command::addKey, key, "www.preaggregation.com", 0, 0, events[i]));
+                }
+            });
+        }
+
+        for (std::thread& sender : senders)
+            sender.join();
+
+        aggregator.flush();
+        stats = aggregator.getStats();
+    }
+
+    preaggregation_waitApplied(q);
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void preaggregation_functionalTest(TEST_REF)
+{
+    // Same counts with and without pre-aggregation, every event accounted.
+    std::vector<std::string> keys;
+    std::vector<uint32_t> events;
+    preaggregation_buildTraffic(keys, events, 400000, 0.35, 5000);
+
+    KeyPreAggregator::Stats direct, aggregated;
+    MapManager mDirect(DEFAULT_TOPKEY_REPORTSIZE, MAX_TOPKEY_REPORTSIZE);
+    MapManager mAggregated(DEFAULT_TOPKEY_REPORTSIZE, MAX_TOPKEY_REPORTSIZE);
+    preaggregation_run(mDirect, keys, events, 4, false, direct);
+    preaggregation_run(mAggregated, keys, events, 4, true, aggregated);
+
+    EXPECT_EQ(direct.events, 0U);
+    EXPECT_EQ(aggregated.events, uint64_t(events.size()));
+    EXPECT_EQ(aggregated.dropped, 0U);
+    EXPECT_EQ(aggregated.tables, 4U);
+    EXPECT_LW(aggregated.messages, aggregated.events);
+    EXPECT_EQ(mAggregated.getTotalKeyNumber(), mDirect.getTotalKeyNumber());
+
+    KeyFrequencyVector vDirect, vAggregated;
+    mDirect.getTopHotkeys(vDirect);
+    mAggregated.getTopHotkeys(vAggregated);
+    EXPECT_EQ(vAggregated.size(), vDirect.size());
+    unsigned same = 0;
+    for (size_t i = 0; i < vDirect.size() && i < vAggregated.size(); i++)
+        same += (vDirect[i].frequency == vAggregated[i].frequency);
+    EXPECT_EQ(same, unsigned(vDirect.size()));
+}
+
+void preaggregation_stalenessTest(TEST_REF)
+{
+    // A lone key is queued by the flusher within the staleness bound.
+    const std::chrono::microseconds staleness(2000);
+    MapManager m(DEFAULT_TOPKEY_REPORTSIZE, MAX_TOPKEY_REPORTSIZE);
+    ThreadedMessageQueue q(1024);
+    q.setConsumer(&m);
+    q.start();
+
+    std::chrono::steady_clock::duration worst(0);
+    {
+        KeyPreAggregator aggregator(q, staleness);
+        for (unsigned i = 0; i < 20; i++)
+        {
+            const unsigned before = m.getTotalKeyNumber();
+            auto start = std::chrono::steady_clock::now();
+            aggregator.addKey("lone key " + std::to_string(i), "www.preaggregation.com", i);
+            while (m.getTotalKeyNumber() == before)
+                std::this_thread::yield();
+
+            auto age = std::chrono::steady_clock::now() - start;
+            if (age > worst) worst = age;
+        }
+    }
+    preaggregation_waitApplied(q);
+
+    const long long worstMicros = std::chrono::duration_cast<std::chrono::microseconds>(worst).count();
+    std::cout << "Staleness bound " << staleness.count() << " uSec, worst key to map manager " << worstMicros << " uSec\n";
+    EXPECT_EQ(m.getTotalKeyNumber(), 20U);
+    EXPECT_LW(worstMicros, staleness.count() + 20000LL); // bound, plus the queue and a loaded host
+}
+
+void preaggregation_overloadTest(TEST_REF)
+{
+    // A queue not started refuses every message: once a count is shed, events are refused for staleness.
+    const std::chrono::microseconds staleness(50000);
+    ThreadedMessageQueue q(1024);
+    KeyPreAggregator aggregator(q, staleness);
+
+    EXPECT_TRUE(aggregator.addKey("shed key", "www.preaggregation.com", 80));
+    aggregator.flush();
+    EXPECT_EQ(aggregator.getStats().dropped, 1ULL);
+    EXPECT_FALSE(aggregator.addKey("shed key", "www.preaggregation.com", 80));
+
+    std::this_thread::sleep_for(staleness + std::chrono::milliseconds(10));
+    EXPECT_TRUE(aggregator.addKey("shed key", "www.preaggregation.com", 80));
+}
+
+void preaggregation_benchmark(TEST_REF)
+{
+    // Top 20 keys are 35 % of the events.
+    const size_t eventNumber = 4000000;
+    const unsigned threads = 4;
+    std::vector<std::string> keys;
+    std::vector<uint32_t> events;
+    preaggregation_buildTraffic(keys, events, eventNumber, 0.35, 20000);
+
+    KeyPreAggregator::Stats direct, aggregated;
+    MapManager mDirect(DEFAULT_TOPKEY_REPORTSIZE, MAX_TOPKEY_REPORTSIZE);
+    MapManager mAggregated(DEFAULT_TOPKEY_REPORTSIZE, MAX_TOPKEY_REPORTSIZE);
+    const double directSeconds = preaggregation_run(mDirect, keys, events, threads, false, direct);
+    const double aggregatedSeconds = preaggregation_run(mAggregated, keys, events, threads, true, aggregated);
+
+    const double reduction = double(aggregated.events) / double(aggregated.messages);
+    const std::streamsize precision = std::cout.precision();
+    std::cout << std::fixed << std::setprecision(2)
+              << eventNumber << " events from " << threads << " threads, top 20 keys 35 % of them:\n"
+              << "  one message per event : " << eventNumber << " messages, " << eventNumber / directSeconds / 1e6 << " MKeys/sec\n"
+              << "  pre-aggregated        : " << aggregated.messages << " messages (x" << reduction << " fewer), "
+              << eventNumber / aggregatedSeconds / 1e6 << " MKeys/sec\n";
+    std::cout.unsetf(std::ios_base::floatfield);
+    std::cout.precision(precision);
+
+    EXPECT_EQ(mAggregated.getTotalKeyNumber(), mDirect.getTotalKeyNumber());
+    EXPECT_GT(reduction, 1.5); // throughput is printed only: it depends on the cores the consumer gets
+}
+
+void KeyPreAggregatorTests(TEST_REF)
+{
+    std::cout << "\nKey pre-aggregation test starting ...\n";
+    preaggregation_functionalTest(TEST);
+    preaggregation_stalenessTest(TEST);
+    preaggregation_overloadTest(TEST);
+    std::cout << "Key pre-aggregation test finished.\n";
+
+    std::cout << "\nKey pre-aggregation benchmark starting ...\n";
+    preaggregation_benchmark(TEST);
+    std::cout << "Key pre-aggregation benchmark finished.\n" << std::endl;
+}
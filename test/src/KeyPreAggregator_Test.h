@@ -0,0 +1,10 @@
+/**
+ * @file KeyPreAggregator_Test.h
+ * @brief Key pre-aggregation test prototypes.
+ * @author Guillermo M. Paris
+ * @date 2026-10-18
+ */
+
+#include "KeyPreAggregator.h"
+
+void KeyPreAggregatorTests(TEST_REF);
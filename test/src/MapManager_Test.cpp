@@ -5,12 +5,16 @@
  * @date 2019-12-15
  */
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <ctime>
 #include <chrono>
+#include <fstream>
 #include <iostream>
 #include <string>
 #include <thread>
+#include <vector>
 #include "test-macros.h"
 #include "test.h"
 #include "KeyFrequency.h"
@@ -19,6 +23,8 @@
 
 extern const long CLOCKS_PER_MILLISEC;
 extern const size_t maxNumbers;
+extern uint8_t genRandomNumbers[];
+extern const char* firstHundred[100];
 
 /*****************************
  *    MapManager Tests       *
@@ -59,10 +65,25 @@ size_t mapmanager_rankingTest(MapManager& mgr)
     return vecResults.size();
 }
 
+// Memory taken by the key map, and what interning the backend urls saves on it.
+void mapmanager_memoryReport(TEST_REF, MapManager& mgr)
+{
+    const std::size_t keys = mgr.getTotalKeyNumber();
+    const std::size_t backends = mgr.getBackends().size();
+    EXPECT_LE(backends, 10U);
+
+    // At least one std::string per key was replaced by an id (url heap buffers not counted).
+    const std::size_t saved = keys * (sizeof(std::string) - sizeof(uint32_t));
+    std::cout << "Keys: " << keys << ", backends: " << backends
+              << ", memory used: " << mgr.memoryUsage() << " bytes, "
+              << "saved by backend interning: at least " << saved << " bytes\n";
+}
+
 void mapmanager_fullSequentialTest(TEST_REF, MapManager& mgr)
 {
     mapmanager_massiveDirectKeyInsertion(mgr);
     EXPECT_LE(mgr.getTotalKeyNumber(), 40000U);
+    mapmanager_memoryReport(TEST, mgr);
 
     mapmanager_backupTest(mgr);
 
@@ -71,8 +92,45 @@ void mapmanager_fullSequentialTest(TEST_REF, MapManager& mgr)
     EXPECT_EQ(mgr.getTopKeyReportMaxSize(), 20U);
 }
 
+// Times isHotKey() (published snapshot) and isRankedKey() (map lock) until stop is set.
+void mapmanager_readLatencySampler( MapManager& mgr, const std::atomic<bool>& stop,
+                                    std::vector<long>& snapshotNs, std::vector<long>& lockedNs )
+{
+    const std::string keys[] = {"letter in the middle", "impossible to be found"};
+    for (unsigned i = 0; ! stop.load(std::memory_order_relaxed); i++)
+    {
+        const std::string& key = keys[i % 2];
+        auto start = std::chrono::steady_clock::now();
+        mgr.isHotKey(key);
+        auto middle = std::chrono::steady_clock::now();
+        mgr.isRankedKey(key);
+        auto finish = std::chrono::steady_clock::now();
+
+        snapshotNs.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(middle - start).count());
+        lockedNs.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(finish - middle).count());
+        std::this_thread::sleep_for(std::chrono::microseconds(50)); // a load balancer, not a spinner
+    }
+}
+
+void mapmanager_printLatency(const char* title, std::vector<long>& samples)
+{
+    if (samples.empty()) return;
+
+    std::sort(samples.begin(), samples.end());
+    std::cout << title << " (" << samples.size() << " reads)  p50: " << samples[samples.size() / 2]
+              << " nSec,  p99: " << samples[samples.size() * 99 / 100]
+              << " nSec,  max: " << samples.back() << " nSec\n";
+}
+
 void mapmanager_concurrencyTest(MapManager& mgr, bool directWriteTest)
 {
+    std::atomic<bool> stopSampler(false);
+    std::vector<long> snapshotNs, lockedNs;
+    snapshotNs.reserve(1000000);
+    lockedNs.reserve(1000000);
+    std::thread sampler( mapmanager_readLatencySampler, std::ref(mgr), std::cref(stopSampler),
+                         std::ref(snapshotNs), std::ref(lockedNs) );
+
     auto searchWords =  [] (MapManager& mgr, const char* k) {
         clock_t start = clock();
         bool b = mgr.isHotKey(k);
@@ -103,11 +161,16 @@ void mapmanager_concurrencyTest(MapManager& mgr, bool directWriteTest)
     rt6.join();
 
     if (directWriteTest) wt1.join();
+
+    stopSampler = true;
+    sampler.join();
+    std::cout << "\nRead latency during the ingest burst:\n";
+    mapmanager_printLatency("isHotKey   , published snapshot", snapshotNs);
+    mapmanager_printLatency("isRankedKey, locked ranking    ", lockedNs);
 }
 
-void mapmanager_functionalTest(TEST_REF)
+void mapmanager_functionalTest(TEST_REF, IMapManager& m)
 {
-    MapManager m(12, 24);
     EXPECT_Z(m.getTopKeyReportActualSize());
     EXPECT_EQ(m.getTopKeyReportBaseSize(), 12U);
     EXPECT_EQ(m.getTopKeyReportMaxSize(), 24U);
@@ -182,11 +245,219 @@ void mapmanager_functionalTest(TEST_REF)
     EXPECT_EQ(std::stoi(v[3].frequency), 4);
 }
 
+void mapmanager_heavyTiesTest(TEST_REF)
+{
+    // Hundreds of thousands of keys tied at frequency 1 and 2: every increment is a bucket move.
+    const unsigned keys = 400000;
+    MapManager m(10, 20);
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned pass = 0; pass < 2; ++pass)
+        for (unsigned i = 0; i < keys; ++i)
+        {
+            m.addOrUpdateKey("tied key " + std::to_string(i), "tie.com", i);
+            if (i % 1000 == 0) m.addOrUpdateKey("hot key", "hot.com", 80);
+        }
+    auto finish = std::chrono::steady_clock::now();
+    std::cout << 2 * keys << " updates over " << keys << " tied keys took "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(finish - start).count() << " mSec\n";
+
+    EXPECT_EQ(m.getTotalKeyNumber(), keys + 1);
+    EXPECT_EQ(m.getTopKeyReportActualSize(), 20U);
+    EXPECT_TRUE(m.isHotKey("hot key"));
+    EXPECT_TRUE(m.isHotKey("tied key 0"));       // first one reaching frequency 2
+    EXPECT_FALSE(m.isHotKey("tied key 399999")); // a tie does not displace a ranked key
+
+    KeyFrequencyVector v;
+    m.getRanking(v, 20);
+    EXPECT_EQ(v.size(), 20U);
+    EXPECT_EQ(v[0].key, std::string("hot key"));
+    EXPECT_EQ(std::stoul(v[0].frequency), 2UL * (keys / 1000));
+    EXPECT_EQ(std::stoul(v[19].frequency), 2UL);
+
+    // The ranking survives a backup/restore round trip, ties included.
+    EXPECT_TRUE(m.backupRequest("TiesKeys.csv", "TiesFrequencies.csv"));
+    MapManager restored(10, 20);
+    EXPECT_TRUE(restored.restoreRequest("TiesKeys.csv", "TiesFrequencies.csv"));
+    KeyFrequencyVector vRestored;
+    restored.getRanking(vRestored, 20);
+    EXPECT_EQ(vRestored.size(), v.size());
+    unsigned same = 0;
+    for (size_t i = 0; i < v.size() && i < vRestored.size(); ++i)
+        same += (vRestored[i].key == v[i].key && vRestored[i].frequency == v[i].frequency);
+    EXPECT_EQ(same, 20U);
+
+    // Purge keeps the top n keys, still ranked.
+    restored.purge(10);
+    EXPECT_EQ(restored.getTotalKeyNumber(), 10U);
+    EXPECT_EQ(restored.getTopKeyReportActualSize(), 10U);
+    EXPECT_TRUE(restored.isHotKey("hot key"));
+    restored.addOrUpdateKey("hot key", "hot.com", 80);
+    vRestored.clear();
+    restored.getTopHotkeys(vRestored);
+    EXPECT_EQ(std::stoul(vRestored[0].frequency), 2UL * (keys / 1000) + 1);
+}
+
+void mapmanager_batchTest(TEST_REF, IMapManager& batched, IMapManager& single)
+{
+    // Duplicates inside a batch are counted once per event, the last url and port win.
+    std::vector<KeyEvent> events = { {"batch a", "www.a.com", 1}, {"batch b", "www.b.com", 2},
+                                     {"batch a", "www.a.com", 3}, {"batch a", "www.c.com", 4} };
+    batched.addOrUpdateKeys(events.data(), events.size());
+    for (const KeyEvent& e : events)
+        single.addOrUpdateKey(std::string(e.key), std::string(e.url), e.port);
+
+    // Then many batches of random pairs of words, same events one at a time on the other manager.
+    std::vector<std::string> keys(64);
+    for (unsigned int i = 0, j = 0; i < 200000; i += unsigned(keys.size()))
+    {
+        events.clear();
+        for (std::string& key : keys)
+        {
+            unsigned idx0 = genRandomNumbers[j++], idx1 = genRandomNumbers[j++];
+            key = std::string(firstHundred[idx0 % 100]) + ' ' + firstHundred[idx1 % 10]; // many repeats
+            events.push_back({key, "www.batch.com", idx0});
+            single.addOrUpdateKey(key, "www.batch.com", idx0);
+        }
+        batched.addOrUpdateKeys(events.data(), events.size());
+    }
+
+    EXPECT_EQ(batched.getTotalKeyNumber(), single.getTotalKeyNumber());
+    EXPECT_EQ(batched.getTopKeyReportActualSize(), single.getTopKeyReportActualSize());
+
+    // Ties may rank different keys, but never different frequencies.
+    KeyFrequencyVector vBatched, vSingle;
+    batched.getTopHotkeys(vBatched);
+    single.getTopHotkeys(vSingle);
+    EXPECT_EQ(vBatched.size(), vSingle.size());
+    unsigned same = 0;
+    for (size_t i = 0; i < vBatched.size() && i < vSingle.size(); ++i)
+        same += (vBatched[i].frequency == vSingle[i].frequency);
+    EXPECT_EQ(same, unsigned(vSingle.size()));
+}
+
+void mapmanager_backendDictionaryTest(TEST_REF)
+{
+    // A backup written before backend interning: full urls on every key line.
+    {
+        std::ofstream keyFile("LegacyKeys.csv"), freqFile("LegacyFrequencies.csv");
+        keyFile << "alpha,3,www.a.com,80\n" << "beta,2,www.b.com,81\n" << "gamma,1,www.a.com,82\n";
+        freqFile << "3,alpha\n" << "2,beta\n" << "1,gamma\n";
+    }
+
+    MapManager m(2, 4);
+    EXPECT_TRUE(m.restoreRequest("LegacyKeys.csv", "LegacyFrequencies.csv"));
+    EXPECT_EQ(m.getTotalKeyNumber(), 3U);
+    EXPECT_EQ(m.getBackends().size(), 2U);
+    EXPECT_TRUE(m.isHotKey("alpha"));
+    EXPECT_TRUE(m.isHotKey("beta"));
+
+    // New backups carry the dictionary once, and key lines refer to it.
+    EXPECT_TRUE(m.backupRequest("BackendKeys.csv", "BackendFrequencies.csv"));
+    std::ifstream keyFile("BackendKeys.csv");
+    std::string header;
+    std::getline(keyFile, header);
+    EXPECT_EQ(header, std::string("#backends,2"));
+    keyFile.close();
+
+    MapManager restored(2, 4);
+    EXPECT_TRUE(restored.restoreRequest("BackendKeys.csv", "BackendFrequencies.csv"));
+    EXPECT_EQ(restored.getTotalKeyNumber(), 3U);
+    EXPECT_EQ(restored.getBackends().size(), 2U);
+    KeyFrequencyVector v;
+    restored.getRanking(v, 4);
+    EXPECT_EQ(v.size(), 3U);
+    EXPECT_EQ(v[0].key, std::string("alpha"));
+    EXPECT_EQ(std::stoul(v[0].frequency), 3UL);
+
+    // Without a header, a key or a url starting with '#' is no dictionary reference.
+    {
+        std::ofstream keyFile("HashKeys.csv"), freqFile("HashFrequencies.csv");
+        keyFile << "#tag,2,#anchor,80\n" << "delta,1,#0,81\n";
+        freqFile << "2,#tag\n" << "1,delta\n";
+    }
+
+    MapManager hashes(2, 4);
+    EXPECT_TRUE(hashes.restoreRequest("HashKeys.csv", "HashFrequencies.csv"));
+    EXPECT_EQ(hashes.getTotalKeyNumber(), 2U);
+    EXPECT_EQ(hashes.getBackends().size(), 2U);
+    EXPECT_TRUE(hashes.isHotKey("#tag"));
+}
+
+// Average nanoseconds per call of lookup over keys, and how many of them it found.
+template<class Lookup>
+double mapmanager_lookupLatency(const std::vector<std::string>& keys, Lookup lookup, unsigned& found)
+{
+    const unsigned reps = 2000000;
+    found = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned i = 0; i < reps; i++)
+        found += lookup(keys[i % keys.size()]);
+    auto finish = std::chrono::steady_clock::now();
+
+    found = found / (reps / unsigned(keys.size()));
+    return std::chrono::duration<double, std::nano>(finish - start).count() / reps;
+}
+
+void mapmanager_hotKeyLookupBenchmark(TEST_REF)
+{
+    MapManager m(10, 20);
+    std::string sKey;
+    for (unsigned i = 0, j = 0; i < 2000000; i++)
+    {
+        unsigned idx0 = genRandomNumbers[j++];
+        unsigned idx1 = genRandomNumbers[j++];
+        sKey = (firstHundred[idx0%100]);
+        sKey += ' ';
+        sKey += firstHundred[idx1%100];
+        m.addOrUpdateKey(sKey, "bench.com", i);
+    }
+
+    KeyFrequencyVector v;
+    m.getRanking(v, 20);
+    std::vector<std::string> hits, misses;
+    for (const KeyFrequency& kf : v) hits.push_back(kf.key);
+    for (unsigned i = 0; i < 10; i++) // known but cold keys, and unknown ones
+    {
+        misses.push_back(std::string(firstHundred[i]) + ' ' + firstHundred[99 - i]);
+        misses.push_back("never sent key number " + std::to_string(i));
+    }
+
+    unsigned found = 0;
+    auto hotSet = [&m](const std::string& k) { return m.isHotKey(k); };
+    auto ranked = [&m](const std::string& k) { return m.isRankedKey(k); };
+
+    std::cout << "isHotKey lookup latency (nSec per call)   hit     miss\n";
+    double hotHit = mapmanager_lookupLatency(hits, hotSet, found);
+    EXPECT_EQ(found, unsigned(hits.size()));
+    double hotMiss = mapmanager_lookupLatency(misses, hotSet, found);
+    EXPECT_Z(found);
+    std::cout << "  published fingerprint hot set       " << hotHit << "   " << hotMiss << '\n';
+
+    double rankedHit = mapmanager_lookupLatency(hits, ranked, found);
+    EXPECT_EQ(found, unsigned(hits.size()));
+    double rankedMiss = mapmanager_lookupLatency(misses, ranked, found);
+    EXPECT_Z(found);
+    std::cout << "  isRankedKey (lock + key map)        " << rankedHit << "   " << rankedMiss << '\n';
+}
+
 void MapManagerTests(TEST_REF, MapManager& mm)
 {
     // This test assumes uses their own freshly created map manager.
     // It does not interfere will all other sequential tests.
-    mapmanager_functionalTest(TEST);
+    MapManager m(12, 24);
+    mapmanager_functionalTest(TEST, m);
+
+    mapmanager_backendDictionaryTest(TEST);
+    MapManager batched(10, 20), single(10, 20);
+    mapmanager_batchTest(TEST, batched, single);
+
+    std::cout << "\nHeavy ties ranking test starting ...\n";
+    mapmanager_heavyTiesTest(TEST);
+    std::cout << "Heavy ties ranking test finished.\n";
+
+    std::cout << "\nHot key lookup benchmark starting ...\n";
+    mapmanager_hotKeyLookupBenchmark(TEST);
+    std::cout << "Hot key lookup benchmark finished.\n";
 
     std::cout << "\nLimited word set test starting ...\n";
     mapmanager_fullSequentialTest(TEST, mm);
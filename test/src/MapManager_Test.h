@@ -7,5 +7,7 @@
 
 #include "MapManager.h"
 
+void mapmanager_functionalTest(TEST_REF, IMapManager& m); // m must be fresh and built with (12, 24)
+void mapmanager_batchTest(TEST_REF, IMapManager& batched, IMapManager& single); // both fresh, same sizes
 void mapmanager_concurrencyTest(MapManager& mgr, bool directWriteTest);
 void MapManagerTests(TEST_REF, MapManager& mm);
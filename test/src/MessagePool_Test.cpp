@@ -0,0 +1,134 @@
+/**
+ * @file MessagePool_Test.cpp
+ * @brief Unit tests and benchmark for MessagePool.
+ * @author Guillermo M. Paris
+ * @date 2026-10-18
+ */
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "test-macros.h"
+#include "MapManager.h"
+#include "Message.h"
+#include "MessagePool_Test.h"
+#include "ThreadedMessageQueue.h"
+
+/*****************************
+ *    MessagePool Tests      *
+*****************************/
+
+void messagepool_sameThreadTest(TEST_REF)
+{
+    // Warm up, then new/delete pairs never need a new slab.
+    delete new Message(Message::Command::addKey, "key", "url", 0, 0, 1);
+    MessagePool::Stats before = MessagePool::getStats();
+    for (unsigned i = 0; i < 100000; i++)
+        delete new Message(Message::Command::addKey, "key", "url", 0, 0, i);
+    MessagePool::Stats after = MessagePool::getStats();
+
+    EXPECT_EQ(after.misses, before.misses);
+    EXPECT_EQ(after.hits - before.hits, 100000UL);
+    EXPECT_GE(MessagePool::blockSize(), sizeof(Message));
+}
+
+void messagepool_crossThreadTest(TEST_REF)
+{
+    // A producer thread allocates, another thread deletes: the blocks come back to the producer.
+    const unsigned messages = MESSAGEPOOL_SHARED_BLOCKS / 2, rounds = 20;
+    std::vector<Message*> inFlight(messages);
+    MessagePool::Stats afterFirstRound{0, 0, 0, 0};
+
+    std::thread producer([&] {
+        for (unsigned r = 0; r < rounds; r++)
+        {
+            for (unsigned i = 0; i < messages; i++)
+                inFlight[i] = new Message(Message::Command::addKey, "key", "url", 0, 0, i);
+
+            std::thread consumer([&] {
+                for (Message* pm : inFlight)
+                    delete pm;
+            });
+            consumer.join(); // the consumer cache goes to the shared stack when it ends
+
+            if (r == 0) afterFirstRound = MessagePool::getStats();
+        }
+    });
+    producer.join();
+
+    MessagePool::Stats stats = MessagePool::getStats();
+    std::cout << "Message pool: " << stats.hits << " hits, " << stats.misses << " misses, "
+              << stats.blocks << " blocks of " << MessagePool::blockSize() << " bytes, "
+              << stats.released << " released\n";
+    EXPECT_EQ(stats.misses, afterFirstRound.misses);
+    EXPECT_EQ(stats.blocks, afterFirstRound.blocks);
+}
+
+void messagepool_queueTest(TEST_REF)
+{
+    // Through the queue: producer new, output thread delete, in steady state (almost) no miss:
+    // only a refill now and then, when the output thread holds a few more blocks than before.
+    MapManager m(10, 20);
+    ThreadedMessageQueue q(1024);
+    q.setConsumer(&m);
+    q.start();
+
+    // Chunks of 10000: the number of messages in flight stays bounded.
+    auto pushKeys = [&q](unsigned n) {
+        for (unsigned i = 0; i < n; i++)
+        {
+            q.push(new Message(Message::Command::addKey, "pooled key " + std::to_string(i % 100), "url", 0, 0, i));
+            if (i % 10000 == 9999)
+                while (! q.isEmpty())
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    };
+
+    pushKeys(100000);
+    MessagePool::Stats before = MessagePool::getStats();
+    auto start = std::chrono::steady_clock::now();
+    pushKeys(1000000);
+    auto finish = std::chrono::steady_clock::now();
+    q.stop();
+    MessagePool::Stats after = MessagePool::getStats();
+
+    std::cout << "1000000 pooled messages through the queue took "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(finish - start).count() << " mSec, "
+              << (after.misses - before.misses) << " misses\n";
+    EXPECT_LE(after.misses - before.misses, 10UL);
+    EXPECT_EQ(m.getTotalKeyNumber(), 100U);
+}
+
+void messagepool_boundedTest(TEST_REF)
+{
+    // A burst far beyond the shared stack bound: the excess goes back to the global allocator.
+    const unsigned messages = 4 * MESSAGEPOOL_SHARED_BLOCKS;
+    std::vector<Message*> inFlight(messages);
+    for (unsigned i = 0; i < messages; i++)
+        inFlight[i] = new Message(Message::Command::addKey, "key", "url", 0, 0, i);
+
+    MessagePool::Stats before = MessagePool::getStats();
+    std::thread consumer([&inFlight] {
+        for (Message* pm : inFlight)
+            delete pm;
+    });
+    consumer.join();
+    MessagePool::Stats after = MessagePool::getStats();
+
+    std::cout << "Burst of " << messages << " messages: " << (after.released - before.released)
+              << " blocks released to the global allocator\n";
+    EXPECT_GE(after.released - before.released, uint64_t(messages - MESSAGEPOOL_SHARED_BLOCKS));
+    EXPECT_LE(after.blocks - after.released, uint64_t(2 * MESSAGEPOOL_SHARED_BLOCKS));
+}
+
+void MessagePoolTests(TEST_REF)
+{
+    std::cout << "\nMessage pool test starting ...\n";
+    messagepool_sameThreadTest(TEST);
+    messagepool_crossThreadTest(TEST);
+    messagepool_queueTest(TEST);
+    messagepool_boundedTest(TEST);
+    std::cout << "Message pool test finished.\n" << std::endl;
+}
@@ -0,0 +1,10 @@
+/**
+ * @file MessagePool_Test.h
+ * @brief Message pool test prototypes.
+ * @author Guillermo M. Paris
+ * @date 2026-10-18
+ */
+
+#include "MessagePool.h"
+
+void MessagePoolTests(TEST_REF);
@@ -0,0 +1,83 @@
+/**
+ * @file MessageServer_Test.cpp
+ * @brief Unit tests for MessageServer: the targets reported by the communication servers.
+ * @author Guillermo M. Paris
+ * @date 2026-10-18
+ */
+
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include "test-macros.h"
+#include "test.h"
+#include "messageserver.h"
+#include "MessageServer_Test.h"
+
+/**************************
+ * MessageServer Tests    *
+**************************/
+
+// Keeps the reporter: requests are made straight through MessageServer::onMessage().
+class NullCommServer : public ICommunicationServer
+{
+public:
+    virtual void  setReporter(IncommingMessageFunctor&) {}
+    virtual bool  start() { return true; }
+    virtual bool  stop() { return true; }
+};
+
+class MessageServerTester
+{
+public:
+    MessageServerTester(IMapManager* pMgr, MessageServer::IMessageQueue* pQueue)
+        : m_server(pMgr, pQueue, nullptr, &m_commServer) {}
+    ~MessageServerTester() { MessageServer::ms_pInstance = nullptr; }
+
+    int request(const std::string& target, const std::string& inData, std::string& outData)
+        { return MessageServer::onMessage(target, inData, outData); }
+
+private:
+    NullCommServer  m_commServer;
+    MessageServer   m_server;
+};
+
+// Waits until the queue applied every key, then stops it.
+void messageserver_drain(ThreadedMessageQueue& q)
+{
+    while (! q.isEmpty())
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    q.stop();
+}
+
+void messageserver_keySentTest(TEST_REF)
+{
+    // Every field of key[,url,port] reaches the map manager.
+    MapManager m(10, 20);
+    ThreadedMessageQueue q(1024);
+    q.setConsumer(&m);
+    q.start();
+    {
+        MessageServerTester server(&m, &q);
+        std::string out;
+        EXPECT_EQ(server.request("keySent", "k,u,80", out), CMD_SUCCEEDED);
+        EXPECT_EQ(out, std::string("reported key sent : k"));
+        EXPECT_EQ(server.request("keySent", "k2,www.b.com", out), CMD_SUCCEEDED);
+        EXPECT_EQ(server.request("keySent", "k3", out), CMD_SUCCEEDED);
+    }
+    messageserver_drain(q);
+
+    // Ordered by key, urls in full.
+    std::stringstream keys, frequencies;
+    EXPECT_TRUE(m.backupRequest(keys, frequencies));
+    EXPECT_EQ(keys.str(), std::string("k,1,u,80\nk2,1,www.b.com,0\nk3,1,,0\n"));
+    EXPECT_EQ(m.getBackends().size(), 3U);
+}
+
+void MessageServerTests(TEST_REF)
+{
+    std::cout << "\nMessage server test starting ...\n";
+    messageserver_keySentTest(TEST);
+    std::cout << "Message server test finished.\n";
+}
@@ -0,0 +1,10 @@
+/**
+ * @file MessageServer_Test.h
+ * @brief Message server test prototypes.
+ * @author Guillermo M. Paris
+ * @date 2026-10-18
+ */
+
+// messageserver.h is left to the .cpp: its friend main(int, char*[]) conflicts with the test main().
+
+void MessageServerTests(TEST_REF);
@@ -0,0 +1,217 @@
+/**
+ * @file PartitionedMessageQueue_Test.cpp
+ * @brief Unit tests and consumer scaling benchmark for PartitionedMessageQueue.
+ * @author Guillermo M. Paris
+ * @date 2026-10-18
+ */
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "test-macros.h"
+#include "test.h"
+#include "PartitionedMessageQueue_Test.h"
+#include "ShardedMapManager.h"
+
+extern uint8_t genRandomNumbers[];
+extern const char* firstHundred[100];
+extern const char* urls[10];
+
+/*********************************
+ * PartitionedMessageQueue Tests *
+*********************************/
+
+// addKey messages built from genRandomNumbers[2*from .. 2*to).
+void partitionedqueue_buildMessages(std::vector<Message*>& messages, size_t from, size_t to)
+{
+    messages.reserve(messages.size() + to - from);
+    for (size_t i = from, j = 2 * from; i < to; i++)
+    {
+        unsigned idx0 = genRandomNumbers[j++];
+        unsigned idx1 = genRandomNumbers[j++];
+        std::string sKey(firstHundred[idx0%100]);
+        sKey += ' ';
+        sKey += firstHundred[idx1%100];
+        messages.push_back(new Message(Message::Command::addKey, sKey, urls[(idx0 % 100)/10], 0, 0, uint32_t(i + 1)));
+    }
+}
+
+// Pushes the messages (the queue owns them afterwards) and waits until all of them are applied.
+void partitionedqueue_apply(PartitionedMessageQueue& q, std::vector<Message*>& messages)
+{
+    for (Message* pm : messages)
+        q.push(pm);
+    messages.clear();
+
+    while (! q.isEmpty())
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    q.stop(); // applies the last batches
+}
+
+void partitionedqueue_routingTest(TEST_REF)
+{
+    // Partition i only carries the keys of shard i of a sharded manager of the same size.
+    PartitionedMessageQueue q(7, 1024);
+    ShardedMapManager mgr(7, 10, 20);
+    unsigned same = 0;
+    for (unsigned i = 0; i < 1000; i++)
+    {
+        std::string key = std::string(firstHundred[i % 100]) + ' ' + firstHundred[i / 10];
+        same += (q.getPartition(key) == mgr.getShardIndex(key));
+    }
+    EXPECT_EQ(q.getPartitionNumber(), 7U);
+    EXPECT_EQ(same, 1000U);
+}
+
+void partitionedqueue_functionalTest(TEST_REF)
+{
+    // Same counts than a single map manager fed directly.
+    const size_t keys = 500000;
+    std::vector<Message*> messages;
+    partitionedqueue_buildMessages(messages, 0, keys);
+
+    MapManager single(12, 24);
+    for (Message* pm : messages)
+        single.addOrUpdateKey(pm->getStringRef1(), pm->getStringRef2(), pm->getNumber());
+
+    ShardedMapManager sharded(4, 12, 24);
+    PartitionedMessageQueue q(4, keys);
+    q.setConsumer(&sharded);
+    EXPECT_TRUE(q.start());
+    partitionedqueue_apply(q, messages);
+
+    EXPECT_EQ(sharded.getTotalKeyNumber(), single.getTotalKeyNumber());
+    KeyFrequencyVector vSingle, vSharded;
+    single.getTopHotkeys(vSingle);
+    sharded.getTopHotkeys(vSharded);
+    EXPECT_EQ(vSharded.size(), vSingle.size());
+    unsigned same = 0;
+    for (size_t i = 0; i < vSharded.size() && i < vSingle.size(); ++i)
+        same += (vSharded[i].frequency == vSingle[i].frequency);
+    EXPECT_EQ(same, unsigned(vSingle.size()));
+
+    // Commands other than addKey are applied too.
+    q.start();
+    q.push(new Message(Message::Command::setRankingLength, 0, 15, 0));
+    while (! q.isEmpty())
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    q.stop();
+    EXPECT_EQ(sharded.getTopKeyReportBaseSize(), 15U);
+}
+
+void partitionedqueue_bulkTest(TEST_REF)
+{
+    // A bulk of keys is split among the partitions: same counts than its keys one by one.
+    const size_t keys = 100000;
+    std::vector<Message*> messages;
+    partitionedqueue_buildMessages(messages, 0, keys);
+
+    MapManager single(12, 24);
+    std::string body;
+    for (Message* pm : messages)
+    {
+        single.addOrUpdateKey(pm->getStringRef1(), pm->getStringRef2(), pm->getNumber());
+        body.append(pm->getStringRef1()).append(1, ',').append(pm->getStringRef2()).append(1, ',');
+        body.append(std::to_string(pm->getNumber())).append(1, '\n');
+        delete pm;
+    }
+    messages.clear();
+    const std::string bulk = body;
+    messages.push_back(new Message(Message::Command::addKeys, std::move(body), std::string(), 0, 0, uint32_t(keys)));
+
+    ShardedMapManager sharded(4, 12, 24);
+    PartitionedMessageQueue q(4, 1024);
+    q.setConsumer(&sharded);
+    EXPECT_TRUE(q.start());
+    partitionedqueue_apply(q, messages);
+
+    EXPECT_EQ(sharded.getTotalKeyNumber(), single.getTotalKeyNumber());
+    KeyFrequencyVector vSingle, vSharded;
+    single.getTopHotkeys(vSingle);
+    sharded.getTopHotkeys(vSharded);
+    EXPECT_EQ(vSharded.size(), vSingle.size());
+    EXPECT_TRUE(! vSharded.empty() && vSharded[0].frequency == vSingle[0].frequency);
+
+    // Every part is larger than the capacity of its partition: all of them shed, every key counted.
+    PartitionedMessageQueue bounded(4, 1024);
+    bounded.setConsumer(&sharded);
+    bounded.setOverloadPolicy(40, OverloadGuard::Policy::dropNewest);
+    EXPECT_TRUE(bounded.start());
+    EXPECT_FALSE(bounded.push(new Message(Message::Command::addKeys, bulk, std::string(), 0, 0, uint32_t(keys))));
+    EXPECT_EQ(bounded.getOverloadStats().dropped, uint64_t(keys));
+    bounded.stop();
+
+    // Only the part beyond its partition capacity (10 keys) is shed: the other part is counted queued.
+    PartitionedMessageQueue partly(4, 1024);
+    partly.setConsumer(&sharded);
+    partly.setOverloadPolicy(40, OverloadGuard::Policy::dropNewest);
+    EXPECT_TRUE(partly.start());
+    std::string partlyBulk;
+    unsigned parts[2] = {0, 0}; // 20 keys of partition 0, 5 of partition 1
+    for (unsigned i = 0; parts[0] < 20 || parts[1] < 5; i++)
+    {
+        const std::string key = "partly key " + std::to_string(i);
+        const unsigned partition = partly.getPartition(key);
+        if (partition < 2 && parts[partition] < (partition == 0 ? 20U : 5U))
+        {
+            partlyBulk.append(key).append(",www.partly.com,80\n");
+            parts[partition]++;
+        }
+    }
+    EXPECT_EQ(partly.pushKeys(new Message(Message::Command::addKeys, partlyBulk, std::string(), 0, 0, 25), 25), 5U);
+    EXPECT_EQ(partly.getOverloadStats().dropped, 20ULL);
+    partly.stop();
+}
+
+void partitionedqueue_scalingBenchmark(TEST_REF)
+{
+    // Messages are built before the clock starts: the figure is the apply side throughput.
+    const size_t keys = 1000000;
+    const unsigned consumerSet[] = {1, 2, 4, 8};
+    unsigned expectedTotal = 0;
+
+    std::cout << "Partitioned queue consumer scaling (" << keys << " keys per run, "
+              << std::thread::hardware_concurrency() << " hardware threads)\n"
+              << "consumers  MKeys/sec\n";
+
+    for (unsigned consumers : consumerSet)
+    {
+        std::vector<Message*> messages;
+        partitionedqueue_buildMessages(messages, 0, keys);
+
+        ShardedMapManager mgr(consumers, DEFAULT_TOPKEY_REPORTSIZE, MAX_TOPKEY_REPORTSIZE);
+        PartitionedMessageQueue q(consumers, keys);
+        q.setConsumer(&mgr);
+        q.start();
+
+        auto start = std::chrono::steady_clock::now();
+        partitionedqueue_apply(q, messages);
+        auto finish = std::chrono::steady_clock::now();
+
+        double seconds = std::chrono::duration<double>(finish - start).count();
+        std::cout << std::setw(9) << consumers << std::setw(11) << std::fixed << std::setprecision(2)
+                  << (keys / seconds / 1e6) << '\n';
+
+        if (expectedTotal == 0) expectedTotal = mgr.getTotalKeyNumber();
+        EXPECT_EQ(mgr.getTotalKeyNumber(), expectedTotal);
+    }
+
+    std::cout.unsetf(std::ios_base::floatfield);
+    std::cout << std::endl;
+}
+
+void PartitionedMessageQueueTests(TEST_REF)
+{
+    std::cout << "\nPartitioned queue routing test starting ...\n";
+    partitionedqueue_routingTest(TEST);
+    partitionedqueue_functionalTest(TEST);
+    partitionedqueue_bulkTest(TEST);
+    std::cout << "Partitioned queue routing test finished.\n";
+
+    std::cout << "\nPartitioned queue scaling benchmark starting ...\n";
+    partitionedqueue_scalingBenchmark(TEST);
+    std::cout << "Partitioned queue scaling benchmark finished.\n" << std::endl;
+}
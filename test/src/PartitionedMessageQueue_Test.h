@@ -0,0 +1,10 @@
+/**
+ * @file PartitionedMessageQueue_Test.h
+ * @brief Partitioned message queue test prototypes.
+ * @author Guillermo M. Paris
+ * @date 2026-10-18
+ */
+
+#include "PartitionedMessageQueue.h"
+
+void PartitionedMessageQueueTests(TEST_REF);
@@ -0,0 +1,189 @@
+/**
+ * @file PerProducerMessageQueue_Test.cpp
+ * @brief Unit tests and producer contention benchmark for SpscRing and PerProducerMessageQueue.
+ * @author Guillermo M. Paris
+ * @date 2026-10-18
+ */
+
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "test-macros.h"
+#include "test.h"
+#include "PerProducerMessageQueue_Test.h"
+#include "ThreadedMessageQueue.h"
+
+extern uint8_t genRandomNumbers[];
+extern const char* firstHundred[100];
+extern const char* urls[10];
+
+/*********************************
+ * PerProducerMessageQueue Tests *
+*********************************/
+
+// Consumer that only counts keys: the benchmark measures the queues, not the map.
+class perproducer_KeyCounter : public IMapManager
+{
+public:
+    virtual void      addOrUpdateKey(const std::string&, const std::string&, unsigned int) { ++m_keys; }
+    virtual void      addOrUpdateKeys(const KeyEvent*, std::size_t n) { m_keys += n; }
+    virtual void      setTopKeyReportBaseSize(unsigned short) {}
+    virtual unsigned  getTopKeyReportBaseSize() { return 0; }
+    virtual unsigned  getTopKeyReportActualSize() { return 0; }
+    virtual unsigned  getTopKeyReportMaxSize() { return 0; }
+    virtual unsigned  getTotalKeyNumber() { return unsigned(m_keys.load()); }
+    virtual void      getTopHotkeys(KeyFrequencyVector&) {}
+    virtual bool      isHotKey(const std::string&) { return false; }
+    virtual bool      backupRequest(const std::string&, const std::string&) { return true; }
+    virtual bool      restoreRequest(const std::string&, const std::string&) { return true; }
+
+private:
+    std::atomic<std::size_t> m_keys{0};
+};
+
+// Every producer thread pushes the keys of genRandomNumbers[2*first .. 2*(first + keys)).
+void perproducer_produce(IQueue<Message*, IMapManager*>& q, unsigned producers, unsigned keysPerProducer)
+{
+    std::vector<std::thread> threads;
+    for (unsigned p = 0; p < producers; p++)
+    {
+        threads.emplace_back([&q, p, keysPerProducer] {
+            std::string sKey;
+            for (unsigned i = 0, j = 2 * p * keysPerProducer; i < keysPerProducer; i++)
+            {
+                unsigned idx0 = genRandomNumbers[j++];
+                unsigned idx1 = genRandomNumbers[j++];
+                sKey = firstHundred[idx0%100];
+                sKey += ' ';
+                sKey += firstHundred[idx1%100];
+                q.push(new Message(Message::Command::addKey, sKey, urls[(idx0 % 100)/10], 0, 0, i + 1));
+            }
+        });
+    }
+
+    for (std::thread& t : threads)
+        t.join();
+
+    while (! q.isEmpty())
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+}
+
+void perproducer_ringTest(TEST_REF)
+{
+    SpscRing<unsigned> ring(5);
+    EXPECT_EQ(ring.capacity(), 8U);
+    EXPECT_TRUE(ring.empty());
+
+    unsigned value = 0;
+    for (unsigned round = 0; round < 3; round++) // wraps around
+    {
+        unsigned pushed = 0;
+        while (ring.push(round * 100 + pushed))
+            pushed++;
+        EXPECT_EQ(pushed, 8U);
+
+        unsigned ordered = 0;
+        for (unsigned i = 0; ring.pop(value); i++)
+            ordered += (value == round * 100 + i);
+        EXPECT_EQ(ordered, 8U);
+        EXPECT_TRUE(ring.empty());
+    }
+}
+
+void perproducer_functionalTest(TEST_REF)
+{
+    // Same counts than a map manager fed directly, rings smaller than what every producer pushes.
+    const unsigned producers = 4, keysPerProducer = 50000;
+    MapManager direct(10, 20), queued(10, 20);
+    PerProducerMessageQueue q(256, 64);
+    q.setConsumer(&queued);
+    q.start();
+
+    perproducer_produce(q, producers, keysPerProducer);
+    for (unsigned j = 0; j < 2 * producers * keysPerProducer; j += 2)
+    {
+        std::string sKey(firstHundred[genRandomNumbers[j] % 100]);
+        sKey += ' ';
+        sKey += firstHundred[genRandomNumbers[j + 1] % 100];
+        direct.addOrUpdateKey(sKey, urls[(genRandomNumbers[j] % 100) / 10], 0);
+    }
+
+    EXPECT_EQ(q.getRingNumber(), size_t(producers));
+    EXPECT_EQ(queued.getTotalKeyNumber(), direct.getTotalKeyNumber());
+    KeyFrequencyVector vDirect, vQueued;
+    direct.getTopHotkeys(vDirect);
+    queued.getTopHotkeys(vQueued);
+    EXPECT_EQ(vQueued.size(), vDirect.size());
+    unsigned same = 0;
+    for (size_t i = 0; i < vQueued.size() && i < vDirect.size(); ++i)
+        same += (vQueued[i].frequency == vDirect[i].frequency);
+    EXPECT_EQ(same, unsigned(vDirect.size()));
+
+    // New threads reuse the rings of the ended ones; commands go through any ring.
+    perproducer_produce(q, 2, 1000);
+    std::thread([&q] { q.push(new Message(Message::Command::setRankingLength, 0, 15, 0)); }).join();
+    while (! q.isEmpty())
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    q.stop();
+
+    EXPECT_EQ(q.getRingNumber(), size_t(producers));
+    EXPECT_EQ(queued.getTopKeyReportBaseSize(), 15U);
+}
+
+void perproducer_contentionBenchmark(TEST_REF)
+{
+    // The same 2M keys pushed by more and more threads, end to end (first push to last key).
+    const unsigned keys = 2000000;
+    const unsigned producerSet[] = {1, 8, 32, 200};
+
+    std::cout << "Producer contention (" << keys << " keys per run, "
+              << std::thread::hardware_concurrency() << " hardware threads), MKeys/sec\n"
+              << "producers  shared queue  per producer rings\n";
+
+    for (unsigned producers : producerSet)
+    {
+        double rates[2] = {0.0, 0.0};
+        unsigned applied[2] = {0, 0};
+        for (int mode = 0; mode < 2; mode++)
+        {
+            perproducer_KeyCounter counter;
+            ThreadedMessageQueue shared(keys);
+            PerProducerMessageQueue rings;
+            IQueue<Message*, IMapManager*>& q = (mode == 0 ? static_cast<IQueue<Message*, IMapManager*>&>(shared) : rings);
+            q.setConsumer(&counter);
+            q.start();
+
+            auto start = std::chrono::steady_clock::now();
+            perproducer_produce(q, producers, keys / producers);
+            q.stop();
+            auto finish = std::chrono::steady_clock::now();
+
+            applied[mode] = counter.getTotalKeyNumber();
+            rates[mode] = applied[mode] / std::chrono::duration<double, std::micro>(finish - start).count();
+        }
+
+        std::cout << std::setw(9) << producers << std::fixed << std::setprecision(2)
+                  << std::setw(14) << rates[0] << std::setw(20) << rates[1] << '\n';
+        std::cout.unsetf(std::ios_base::floatfield);
+        EXPECT_EQ(applied[0], (keys / producers) * producers);
+        EXPECT_EQ(applied[1], applied[0]);
+    }
+
+    std::cout << std::endl;
+}
+
+void PerProducerMessageQueueTests(TEST_REF)
+{
+    std::cout << "\nPer producer queue test starting ...\n";
+    perproducer_ringTest(TEST);
+    perproducer_functionalTest(TEST);
+    std::cout << "Per producer queue test finished.\n";
+
+    std::cout << "\nPer producer queue contention benchmark starting ...\n";
+    perproducer_contentionBenchmark(TEST);
+    std::cout << "Per producer queue contention benchmark finished.\n" << std::endl;
+}
@@ -0,0 +1,10 @@
+/**
+ * @file PerProducerMessageQueue_Test.h
+ * @brief Per producer message queue test prototypes.
+ * @author Guillermo M. Paris
+ * @date 2026-10-18
+ */
+
+#include "PerProducerMessageQueue.h"
+
+void PerProducerMessageQueueTests(TEST_REF);
@@ -0,0 +1,184 @@
+/**
+ * @file ShardedMapManager_Test.cpp
+ * @brief Unit tests and scaling benchmark for ShardedMapManager.
+ * @author Guillermo M. Paris
+ * @date 2026-10-18
+ */
+
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "test-macros.h"
+#include "test.h"
+#include "MapManager_Test.h"
+#include "ShardedMapManager_Test.h"
+
+extern uint8_t genRandomNumbers[];
+extern const char* firstHundred[100];
+extern const char* urls[10];
+
+/*****************************
+ * ShardedMapManager Tests   *
+*****************************/
+
+// Inserts the keys built from genRandomNumbers[2*from .. 2*to).
+void shardedmapmanager_insertRange(IMapManager& mgr, size_t from, size_t to)
+{
+    std::string sKey;
+    sKey.reserve(50);
+    for (size_t i = from, j = 2 * from; i < to; i++)
+    {
+        unsigned idx0 = genRandomNumbers[j++];
+        unsigned idx1 = genRandomNumbers[j++];
+        sKey = (firstHundred[idx0%100]);
+        sKey += ' ';
+        sKey += firstHundred[idx1%100];
+        mgr.addOrUpdateKey(sKey, urls[(idx0 % 100)/10], unsigned(i + 1));
+    }
+}
+
+void shardedmapmanager_rankingTest(TEST_REF)
+{
+    // The merged ranking must be the same one than a single map manager gives.
+    const size_t keys = 2000000;
+    MapManager single(12, 24);
+    ShardedMapManager sharded(7, 12, 24);
+    shardedmapmanager_insertRange(single, 0, keys);
+    shardedmapmanager_insertRange(sharded, 0, keys);
+
+    EXPECT_EQ(sharded.getTotalKeyNumber(), single.getTotalKeyNumber());
+    EXPECT_EQ(sharded.getTopKeyReportActualSize(), single.getTopKeyReportActualSize());
+
+    KeyFrequencyVector vSingle, vSharded, vWhole;
+    single.getTopHotkeys(vSingle);
+    sharded.getTopHotkeys(vSharded);
+    single.getRanking(vWhole, single.getTopKeyReportMaxSize());
+    EXPECT_EQ(vSharded.size(), vSingle.size());
+    for (size_t i = 0; i < vSingle.size() && i < vSharded.size(); ++i)
+    {
+        EXPECT_EQ(vSharded[i].frequency, vSingle[i].frequency);
+
+        // Ties at the bottom of the ranking may keep a different key in each manager.
+        if (std::stoul(vSingle[i].frequency) > std::stoul(vWhole.back().frequency))
+            EXPECT_TRUE(sharded.isHotKey(vSingle[i].key));
+    }
+
+    EXPECT_FALSE(sharded.isHotKey("impossible to be found"));
+
+    // Backup with 7 shards, restore within 3 shards.
+    EXPECT_TRUE(sharded.backupRequest("ShardedKeys.csv", "ShardedFrequencies.csv"));
+    ShardedMapManager restored(3, 12, 24);
+    EXPECT_TRUE(restored.restoreRequest("ShardedKeys.csv", "ShardedFrequencies.csv"));
+    EXPECT_EQ(restored.getTotalKeyNumber(), single.getTotalKeyNumber());
+
+    KeyFrequencyVector vRestored;
+    restored.getTopHotkeys(vRestored);
+    EXPECT_EQ(vRestored.size(), vSingle.size());
+    for (size_t i = 0; i < vSingle.size() && i < vRestored.size(); ++i)
+        EXPECT_EQ(vRestored[i].frequency, vSingle[i].frequency);
+}
+
+void shardedmapmanager_hotThresholdTest(TEST_REF)
+{
+    // 4 shards of M = 6 keys each: keys ranked by their shard but out of the global top 6 are cold.
+    ShardedMapManager sharded(4, 2, 6);
+    for (unsigned k = 0; k < 16; ++k)
+        for (unsigned i = 0; i <= k; ++i)
+            sharded.addOrUpdateKey("key " + std::to_string(k), urls[0], 80);
+
+    for (unsigned k = 0; k < 16; ++k)
+        EXPECT_EQ(sharded.isHotKey("key " + std::to_string(k)), k >= 10);
+
+    // The cached threshold follows the updates, refreshed by concurrent readers meanwhile: the
+    // last refresh is the newest one once the updates stop.
+    std::atomic<bool> writing(true);
+    std::vector<std::thread> readers;
+    for (unsigned r = 0; r < 4; ++r)
+        readers.emplace_back( [&sharded, &writing, r] {
+            while (writing)
+                sharded.isHotKey("key " + std::to_string(10 + r));
+        } );
+    for (unsigned i = 0; i < 20; ++i)
+    {
+        sharded.addOrUpdateKey("key 0", urls[0], 80);
+        std::this_thread::yield();
+    }
+    writing = false;
+    for (std::thread& reader : readers)
+        reader.join();
+
+    EXPECT_TRUE(sharded.isHotKey("key 0"));
+    EXPECT_FALSE(sharded.isHotKey("key 10"));
+    EXPECT_TRUE(sharded.isHotKey("key 11"));
+
+    sharded.zap();
+    EXPECT_FALSE(sharded.isHotKey("key 0"));
+    sharded.addOrUpdateKey("key 1", urls[0], 80);
+    EXPECT_TRUE(sharded.isHotKey("key 1"));
+}
+
+void shardedmapmanager_scalingBenchmark(TEST_REF)
+{
+    const size_t keys = 4000000; // per configuration, split among the writer threads
+    const unsigned shardSet[] = {1, 4, 16, 64};
+    const unsigned threadSet[] = {1, 2, 4, 8, 16};
+    unsigned expectedTotal = 0;
+
+    std::cout << "Sharded map manager scaling (" << keys << " keys per run, "
+              << std::thread::hardware_concurrency() << " hardware threads)\n"
+              << "shards  threads  MKeys/sec\n";
+
+    for (unsigned shards : shardSet)
+    {
+        for (unsigned threads : threadSet)
+        {
+            ShardedMapManager mgr(shards, DEFAULT_TOPKEY_REPORTSIZE, MAX_TOPKEY_REPORTSIZE);
+            std::vector<std::thread> writers;
+            writers.reserve(threads);
+
+            auto start = std::chrono::steady_clock::now();
+            for (unsigned t = 0; t < threads; ++t)
+                writers.emplace_back( shardedmapmanager_insertRange, std::ref(mgr),
+                                      keys * t / threads, keys * (t + 1) / threads );
+            for (std::thread& w : writers)
+                w.join();
+            auto finish = std::chrono::steady_clock::now();
+
+            double seconds = std::chrono::duration<double>(finish - start).count();
+            std::cout << std::setw(6) << shards << std::setw(9) << threads
+                      << std::setw(11) << std::fixed << std::setprecision(2)
+                      << (keys / seconds / 1e6) << '\n';
+
+            // Same key set whatever the split is.
+            if (expectedTotal == 0) expectedTotal = mgr.getTotalKeyNumber();
+            EXPECT_EQ(mgr.getTotalKeyNumber(), expectedTotal);
+        }
+    }
+
+    std::cout.unsetf(std::ios_base::floatfield);
+    std::cout << std::endl;
+}
+
+void ShardedMapManagerTests(TEST_REF)
+{
+    ShardedMapManager m(4, 12, 24);
+    mapmanager_functionalTest(TEST, m);
+    ShardedMapManager batched(4, 10, 20), single(4, 10, 20);
+    mapmanager_batchTest(TEST, batched, single);
+
+    std::cout << "\nSharded ranking merge test starting ...\n";
+    shardedmapmanager_rankingTest(TEST);
+    std::cout << "Sharded ranking merge test finished.\n";
+
+    std::cout << "\nSharded hot key threshold test starting ...\n";
+    shardedmapmanager_hotThresholdTest(TEST);
+    std::cout << "Sharded hot key threshold test finished.\n";
+
+    std::cout << "\nSharded scaling benchmark starting ...\n";
+    shardedmapmanager_scalingBenchmark(TEST);
+    std::cout << "Sharded scaling benchmark finished.\n" << std::endl;
+}
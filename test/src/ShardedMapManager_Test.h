@@ -0,0 +1,10 @@
+/**
+ * @file ShardedMapManager_Test.h
+ * @brief Sharded map manager test prototypes.
+ * @author Guillermo M. Paris
+ * @date 2026-10-18
+ */
+
+#include "ShardedMapManager.h"
+
+void ShardedMapManagerTests(TEST_REF);
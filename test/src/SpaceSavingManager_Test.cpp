@@ -0,0 +1,202 @@
+/**
+ * @file SpaceSavingManager_Test.cpp
+ * @brief Unit tests for SpaceSavingManager: interface behavior, error bounds and bounded memory.
+ * @author Guillermo M. Paris
+ * @date 2026-10-18
+ */
+
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <unordered_map>
+#include "test-macros.h"
+#include "test.h"
+#include "MapManager_Test.h"
+#include "SpaceSavingManager_Test.h"
+
+extern uint8_t genRandomNumbers[];
+extern const char* firstHundred[100];
+extern const char* urls[10];
+
+/*****************************
+ * SpaceSavingManager Tests  *
+*****************************/
+
+// Feeds keys built from genRandomNumbers into mgr, and counts them exactly into freq.
+void spacesaving_insert(IMapManager& mgr, std::unordered_map<std::string, unsigned long>& freq, size_t keys)
+{
+    std::string sKey;
+    sKey.reserve(50);
+    for (size_t i = 0, j = 0; i < keys; i++)
+    {
+        unsigned idx0 = genRandomNumbers[j++];
+        unsigned idx1 = genRandomNumbers[j++];
+        sKey = (firstHundred[idx0%100]);
+        sKey += ' ';
+        sKey += firstHundred[idx1%100];
+        mgr.addOrUpdateKey(sKey, urls[(idx0 % 100)/10], unsigned(i + 1));
+        ++freq[sKey];
+    }
+}
+
+void spacesaving_exactTest(TEST_REF)
+{
+    // With more counters than distinct keys nothing is replaced: same result as MapManager.
+    const size_t keys = 1000000;
+    std::unordered_map<std::string, unsigned long> freq;
+    SpaceSavingManager ss(20000, 12, 24);
+    spacesaving_insert(ss, freq, keys);
+
+    EXPECT_EQ(ss.getTotalKeyNumber(), unsigned(freq.size()));
+    EXPECT_EQ(ss.getStreamLength(), keys);
+    EXPECT_Z(ss.getMaxError());
+
+    KeyFrequencyVector v;
+    ss.getTopHotkeys(v);
+    EXPECT_EQ(v.size(), 12U);
+    bool exact = true;
+    for (const KeyFrequency& kf : v)
+        exact = exact && kf.error == "0" && std::stoul(kf.frequency) == freq[kf.key];
+    EXPECT_TRUE(exact);
+    EXPECT_TRUE(ss.isGuaranteedHotKey(v[0].key));
+}
+
+void spacesaving_errorBoundTest(TEST_REF)
+{
+    // Fewer counters than distinct keys: every estimation must bracket the true frequency.
+    const size_t keys = 2000000;
+    const unsigned counters = 2000;
+    std::unordered_map<std::string, unsigned long> freq;
+    SpaceSavingManager ss(counters, 12, 24);
+    spacesaving_insert(ss, freq, keys);
+
+    std::cout << freq.size() << " distinct keys over " << counters << " counters, max error "
+              << ss.getMaxError() << '\n';
+
+    EXPECT_TRUE(freq.size() > counters);
+    EXPECT_EQ(ss.getTotalKeyNumber(), counters);
+    EXPECT_EQ(ss.getStreamLength(), keys);
+    EXPECT_LE(ss.getMaxError(), keys / counters);
+
+    KeyFrequencyVector v;
+    ss.setTopKeyReportBaseSize(24);
+    ss.getTopHotkeys(v);
+    EXPECT_EQ(v.size(), 24U);
+
+    unsigned bounded = 0, guaranteed = 0;
+    for (const KeyFrequency& kf : v)
+    {
+        unsigned long count = std::stoul(kf.frequency);
+        unsigned long error = std::stoul(kf.error);
+        if (count - error <= freq[kf.key] && freq[kf.key] <= count) ++bounded;
+
+        // Every key above stream / counters is monitored, so only real heavy hitters qualify.
+        if (ss.isGuaranteedHotKey(kf.key))
+        {
+            ++guaranteed;
+            unsigned above = 0;
+            for (const auto& kv : freq) above += (kv.second > freq[kf.key]);
+            EXPECT_LW(above, 24U);
+        }
+    }
+    EXPECT_EQ(bounded, 24U);
+    std::cout << guaranteed << " of the top 24 are guaranteed hot keys.\n";
+
+    // Backup and restore keep the counters and their errors.
+    EXPECT_TRUE(ss.backupRequest("SpaceSavingKeys.csv", "SpaceSavingFrequencies.csv"));
+    SpaceSavingManager restored(counters, 24, 24);
+    EXPECT_TRUE(restored.restoreRequest("SpaceSavingKeys.csv", "SpaceSavingFrequencies.csv"));
+    EXPECT_EQ(restored.getTotalKeyNumber(), counters);
+    EXPECT_EQ(restored.getStreamLength(), keys);
+
+    KeyFrequencyVector vRestored;
+    restored.getTopHotkeys(vRestored);
+    EXPECT_EQ(vRestored.size(), v.size());
+    unsigned same = 0;
+    for (size_t i = 0; i < v.size() && i < vRestored.size(); ++i)
+        same += (vRestored[i].frequency == v[i].frequency && vRestored[i].error == v[i].error);
+    EXPECT_EQ(same, unsigned(v.size()));
+}
+
+void spacesaving_boundedMemoryTest(TEST_REF)
+{
+    // A million distinct keys never take more than the configured counters.
+    const unsigned counters = 1000;
+    const size_t keys = 1000000;
+    SpaceSavingManager ss(counters, 10, 20);
+    for (size_t i = 0; i < keys; ++i)
+    {
+        ss.addOrUpdateKey("distinct key " + std::to_string(i), urls[i % 10], unsigned(i));
+        if (i % 10 == 0) ss.addOrUpdateKey("heavy hitter", urls[0], 80);
+    }
+
+    EXPECT_EQ(ss.getCounterNumber(), counters);
+    EXPECT_EQ(ss.getTotalKeyNumber(), counters);
+    EXPECT_EQ(ss.getStreamLength(), keys + keys / 10);
+    EXPECT_TRUE(ss.isHotKey("heavy hitter"));
+    EXPECT_TRUE(ss.isGuaranteedHotKey("heavy hitter"));
+    EXPECT_FALSE(ss.isGuaranteedHotKey("distinct key 999999"));
+
+    ss.zap();
+    EXPECT_Z(ss.getTotalKeyNumber());
+    EXPECT_Z(ss.getStreamLength());
+}
+
+void spacesaving_mapManagerRestoreTest(TEST_REF)
+{
+    // A MapManager backup starts with its backend dictionary and refers to it as "#id".
+    MapManager m(2, 4);
+    m.addOrUpdateKey("alpha", "www.a.com", 80);
+    m.addOrUpdateKey("alpha", "www.a.com", 80);
+    m.addOrUpdateKey("beta", "www.b.com", 81);
+    EXPECT_TRUE(m.backupRequest("MapManagerKeys.csv", "MapManagerFrequencies.csv"));
+
+    SpaceSavingManager ss(16, 2, 4);
+    EXPECT_TRUE(ss.restoreRequest("MapManagerKeys.csv", "MapManagerFrequencies.csv"));
+    EXPECT_EQ(ss.getTotalKeyNumber(), 2U);
+    EXPECT_EQ(ss.getStreamLength(), 3UL);
+    EXPECT_TRUE(ss.isHotKey("alpha"));
+
+    // The urls are restored in full, not as their file ids.
+    EXPECT_TRUE(ss.backupRequest("SpaceSavingKeys.csv", "SpaceSavingFrequencies.csv"));
+    std::ifstream keyFile("SpaceSavingKeys.csv");
+    std::string contents((std::istreambuf_iterator<char>(keyFile)), std::istreambuf_iterator<char>());
+    EXPECT_TRUE(contents.find("beta,1,www.b.com,81,0\n") != std::string::npos);
+    EXPECT_TRUE(contents.find("alpha,2,www.a.com,80,0\n") != std::string::npos);
+
+    // A malformed line further on is refused before any counter is cleared.
+    {
+        std::ofstream badFile("SpaceSavingBadKeys.csv");
+        badFile << "gamma,5,www.c.com,82,0\n" << "delta,not a count,www.d.com,83,0\n";
+    }
+    EXPECT_FALSE(ss.restoreRequest("SpaceSavingBadKeys.csv", "SpaceSavingFrequencies.csv"));
+    EXPECT_EQ(ss.getTotalKeyNumber(), 2U);
+    EXPECT_EQ(ss.getStreamLength(), 3UL);
+    EXPECT_TRUE(ss.isHotKey("alpha"));
+    EXPECT_FALSE(ss.isHotKey("gamma"));
+}
+
+void SpaceSavingManagerTests(TEST_REF)
+{
+    SpaceSavingManager m(64, 12, 24);
+    mapmanager_functionalTest(TEST, m);
+    SpaceSavingManager batched(2048, 10, 20), single(2048, 10, 20); // exact: more counters than keys
+    mapmanager_batchTest(TEST, batched, single);
+
+    std::cout << "\nSpace-Saving exact count test starting ...\n";
+    spacesaving_exactTest(TEST);
+    std::cout << "Space-Saving exact count test finished.\n";
+
+    std::cout << "\nSpace-Saving error bound test starting ...\n";
+    spacesaving_errorBoundTest(TEST);
+    std::cout << "Space-Saving error bound test finished.\n";
+
+    std::cout << "\nSpace-Saving restore of a MapManager backup test starting ...\n";
+    spacesaving_mapManagerRestoreTest(TEST);
+    std::cout << "Space-Saving restore of a MapManager backup test finished.\n";
+
+    std::cout << "\nSpace-Saving bounded memory test starting ...\n";
+    spacesaving_boundedMemoryTest(TEST);
+    std::cout << "Space-Saving bounded memory test finished.\n" << std::endl;
+}
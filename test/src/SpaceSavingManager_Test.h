@@ -0,0 +1,10 @@
+/**
+ * @file SpaceSavingManager_Test.h
+ * @brief Space-Saving map manager test prototypes.
+ * @author Guillermo M. Paris
+ * @date 2026-10-18
+ */
+
+#include "SpaceSavingManager.h"
+
+void SpaceSavingManagerTests(TEST_REF);
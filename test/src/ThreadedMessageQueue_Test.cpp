@@ -5,15 +5,29 @@
  * @date 2019-12-15
  */
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <ctime>
 #include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
 #include <thread>
+#include <vector>
+#include <sys/resource.h>
+#include <unistd.h>
 #include "test-macros.h"
 #include "test.h"
 #include "MapManager_Test.h"
+#include "InlineMessageQueue.h"
 #include "ThreadedMessageQueue.h"
 
+extern uint8_t genRandomNumbers[];
+extern const char* firstHundred[100];
+extern const char* urls[10];
+
 /******************************
  * ThreadedMessageQueue Tests *
 ******************************/
@@ -42,6 +56,837 @@ void waitForQueueEmpty(ThreadedMessageQueue& q)
     std::cout << std::endl;
 }
 
+// MKeys/sec from the first push until the consumer applied the last key.
+double queue_batchThroughput(MapManager& m, size_t batchSize, size_t burstSize)
+{
+    ThreadedMessageQueue q(burstSize / 2, batchSize);
+    q.setConsumer(&m);
+    q.start();
+
+    auto start = std::chrono::steady_clock::now();
+    keyInsertion(nullptr, &q, false, burstSize);
+    while (! q.isEmpty())
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    q.stop(); // applies the last batch
+    auto finish = std::chrono::steady_clock::now();
+
+    const double messages = burstSize / 2; // keyInsertion() sends one message per pair of numbers
+    return messages / std::chrono::duration<double, std::micro>(finish - start).count();
+}
+
+// MKeys/sec of the consumer side alone: the same keys, one call per key or one call per batch.
+double queue_consumerThroughput(MapManager& m, size_t batchSize, size_t messages)
+{
+    std::vector<std::string> keys(batchSize);
+    std::vector<KeyEvent> events(batchSize);
+    std::chrono::steady_clock::duration elapsed(0);
+
+    for (size_t i = 0, j = 0; i < messages; i += batchSize)
+    {
+        for (size_t k = 0; k < batchSize; k++, j += 2)
+        {
+            keys[k] = firstHundred[genRandomNumbers[j] % 100];
+            keys[k] += ' ';
+            keys[k] += firstHundred[genRandomNumbers[j + 1] % 100];
+            events[k] = {keys[k], urls[(genRandomNumbers[j] % 100) / 10], unsigned(i + k + 1)};
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        if (batchSize == 1)
+            m.addOrUpdateKey(keys[0], std::string(events[0].url), events[0].port);
+        else
+            m.addOrUpdateKeys(events.data(), events.size());
+        elapsed += std::chrono::steady_clock::now() - start;
+    }
+
+    return messages / std::chrono::duration<double, std::micro>(elapsed).count();
+}
+
+void queue_batchThroughputTest(TEST_REF)
+{
+    const size_t burstSize = maxNumbers / 10; // 4M messages
+    MapManager single, batched;
+    double singleRate = queue_batchThroughput(single, 1, burstSize);
+    double batchedRate = queue_batchThroughput(batched, DEFAULT_KEY_BATCH_SIZE, burstSize);
+
+    std::cout << "Queue to map manager, end to end:\n"
+              << "  batch size 1   : " << singleRate << " MKeys/sec\n"
+              << "  batch size " << DEFAULT_KEY_BATCH_SIZE << " : " << batchedRate << " MKeys/sec\n";
+
+    EXPECT_EQ(batched.getTotalKeyNumber(), single.getTotalKeyNumber());
+    KeyFrequencyVector vBatched, vSingle;
+    batched.getTopHotkeys(vBatched);
+    single.getTopHotkeys(vSingle);
+    EXPECT_EQ(vBatched.size(), vSingle.size());
+    EXPECT_EQ(vBatched[0].frequency, vSingle[0].frequency);
+
+    MapManager consumerSingle, consumerBatched;
+    singleRate = queue_consumerThroughput(consumerSingle, 1, burstSize / 2);
+    batchedRate = queue_consumerThroughput(consumerBatched, DEFAULT_KEY_BATCH_SIZE, burstSize / 2);
+    std::cout << "Map manager alone:\n"
+              << "  addOrUpdateKey  : " << singleRate << " MKeys/sec\n"
+              << "  addOrUpdateKeys : " << batchedRate << " MKeys/sec\n";
+    EXPECT_EQ(consumerBatched.getTotalKeyNumber(), consumerSingle.getTotalKeyNumber());
+}
+
+// MKeys/sec from the first push until the consumer applied the last key, InlineMessage values
+// in the ring instead of Message pointers. Same keys as keyInsertion().
+double queue_inlineThroughput(MapManager& m, size_t batchSize, size_t burstSize)
+{
+    InlineMessageQueue q(INLINE_QUEUE_DEFAULT_SLOTS, batchSize);
+    q.setConsumer(&m);
+    q.start();
+
+    auto start = std::chrono::steady_clock::now();
+    std::string sKey;
+    sKey.reserve(50);
+    for (unsigned int i = 0, j = 0; i < burstSize / 2; i++)
+    {
+        unsigned idx0 = genRandomNumbers[j++];
+        unsigned idx1 = genRandomNumbers[j++];
+        sKey = firstHundred[idx0%100];
+        sKey += ' ';
+        sKey += firstHundred[idx1%100];
+        q.pushKey(sKey, urls[(idx0 % 100)/10], i + 1);
+    }
+
+    while (! q.isEmpty())
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    q.stop();
+    auto finish = std::chrono::steady_clock::now();
+
+    const double messages = burstSize / 2;
+    return messages / std::chrono::duration<double, std::micro>(finish - start).count();
+}
+
+void queue_inlineMessageTest(TEST_REF)
+{
+    const std::string shortKey(InlineMessage::ms_KeySize, 's');
+    const std::string longKey(3 * InlineMessage::ms_KeySize, 'l');
+
+    InlineMessage inlined(Message::Command::addKey, shortKey, 7, 0, 0, 8080);
+    InlineMessage spilled(Message::Command::addKey, longKey, 3, 0, 0, 443);
+    InlineMessage copy = spilled; // a plain copy shares the spilled key
+    EXPECT_FALSE(inlined.isSpilled());
+    EXPECT_TRUE(spilled.isSpilled());
+    EXPECT_TRUE(inlined.getKey() == shortKey);
+    EXPECT_TRUE(copy.getKey() == longKey);
+    EXPECT_EQ(inlined.getBackend(), 7U);
+    EXPECT_EQ(copy.getNumber(), 443U);
+    inlined.releaseKey();
+    copy.releaseKey();
+
+    InlineMessage command(Message::Command::setRankingLength, 0, 15, 0);
+    EXPECT_TRUE(command.getKey().empty());
+    EXPECT_EQ(command.getShort(), 15U);
+    EXPECT_EQ(sizeof(InlineMessage) % alignof(InlineMessage), 0U);
+}
+
+void queue_inlineQueueTest(TEST_REF)
+{
+    // Same counts than a map manager fed directly, long (spilled) keys included, and a ring
+    // much smaller than the number of messages so producers wait for free slots.
+    const unsigned keys = 100000;
+    MapManager direct(10, 20), queued(10, 20);
+    InlineMessageQueue q(1024, 64);
+    q.setConsumer(&queued);
+    q.start();
+
+    const std::string longSuffix(InlineMessage::ms_KeySize, '+');
+    for (unsigned i = 0; i < keys; i++)
+    {
+        std::string key = std::string(firstHundred[genRandomNumbers[i] % 100]) + (i % 10 == 0 ? longSuffix : "");
+        const char* url = urls[i % 10];
+        direct.addOrUpdateKey(key, url, i);
+        q.pushKey(key, url, i);
+    }
+    q.push(InlineMessage(Message::Command::setRankingLength, 0, 15, 0));
+    direct.setTopKeyReportBaseSize(15);
+
+    while (! q.isEmpty())
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    q.stop();
+
+    EXPECT_EQ(q.getCapacity(), 1024U);
+    EXPECT_EQ(queued.getTotalKeyNumber(), direct.getTotalKeyNumber());
+    EXPECT_EQ(queued.getTopKeyReportBaseSize(), 15U);
+    KeyFrequencyVector vDirect, vQueued;
+    direct.getTopHotkeys(vDirect);
+    queued.getTopHotkeys(vQueued);
+    EXPECT_EQ(vQueued.size(), vDirect.size());
+    unsigned same = 0;
+    for (size_t i = 0; i < vQueued.size() && i < vDirect.size(); ++i)
+        same += (vQueued[i].key == vDirect[i].key && vQueued[i].frequency == vDirect[i].frequency);
+    EXPECT_EQ(same, unsigned(vDirect.size()));
+}
+
+void queue_inlineThroughputTest(TEST_REF)
+{
+    const size_t burstSize = maxNumbers / 10; // 4M messages
+    MapManager pointers, values;
+    double pointerRate = queue_batchThroughput(pointers, DEFAULT_KEY_BATCH_SIZE, burstSize);
+    double inlineRate = queue_inlineThroughput(values, DEFAULT_KEY_BATCH_SIZE, burstSize);
+
+    std::cout << "Queue to map manager, end to end, batch size " << DEFAULT_KEY_BATCH_SIZE << ":\n"
+              << "  Message pointers      : " << pointerRate << " MKeys/sec\n"
+              << "  InlineMessage values  : " << inlineRate << " MKeys/sec\n";
+
+    EXPECT_EQ(values.getTotalKeyNumber(), pointers.getTotalKeyNumber());
+    KeyFrequencyVector vPointers, vValues;
+    pointers.getTopHotkeys(vPointers);
+    values.getTopHotkeys(vValues);
+    EXPECT_EQ(vValues.size(), vPointers.size());
+    EXPECT_EQ(vValues[0].frequency, vPointers[0].frequency);
+}
+
+// Consumer that only records how many keys it got and when it got the last one.
+class queue_ApplyClock : public IMapManager
+{
+public:
+    virtual void      addOrUpdateKey(const std::string&, const std::string&, unsigned int) { applied(1); }
+    virtual void      addOrUpdateKeys(const KeyEvent*, std::size_t n) { applied(n); }
+    virtual void      setTopKeyReportBaseSize(unsigned short) {}
+    virtual unsigned  getTopKeyReportBaseSize() { return 0; }
+    virtual unsigned  getTopKeyReportActualSize() { return 0; }
+    virtual unsigned  getTopKeyReportMaxSize() { return 0; }
+    virtual unsigned  getTotalKeyNumber() { return unsigned(m_keys.load()); }
+    virtual void      getTopHotkeys(KeyFrequencyVector&) {}
+    virtual bool      isHotKey(const std::string&) { return false; }
+    virtual bool      backupRequest(const std::string&, const std::string&) { return true; }
+    virtual bool      restoreRequest(const std::string&, const std::string&) { return true; }
+
+    long long         lastApplied() const { return m_lastApplied.load(); } // steady clock nSec
+
+private:
+    void applied(std::size_t n)
+    {
+        m_lastApplied = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            std::chrono::steady_clock::now().time_since_epoch()).count();
+        m_keys += n;
+    }
+
+    std::atomic<long long>   m_lastApplied{0};
+    std::atomic<std::size_t> m_keys{0};
+};
+
+// Consumer held back until open() is called: the queue fills up. Counts the weighted events.
+class queue_GatedConsumer : public IMapManager
+{
+public:
+    virtual void      addOrUpdateKey(const std::string&, const std::string&, unsigned int) { waitOpen(); ++m_events; }
+    virtual void      addOrUpdateKeys(const KeyEvent* pEvents, std::size_t n)
+                      {
+                          waitOpen();
+                          for (std::size_t i = 0; i < n; i++)
+                              m_events += pEvents[i].count;
+                      }
+    virtual void      setTopKeyReportBaseSize(unsigned short) {}
+    virtual unsigned  getTopKeyReportBaseSize() { return 0; }
+    virtual unsigned  getTopKeyReportActualSize() { return 0; }
+    virtual unsigned  getTopKeyReportMaxSize() { return 0; }
+    virtual unsigned  getTotalKeyNumber() { return unsigned(m_events.load()); }
+    virtual void      getTopHotkeys(KeyFrequencyVector&) {}
+    virtual bool      isHotKey(const std::string&) { return false; }
+    virtual bool      backupRequest(const std::string&, const std::string&) { return true; }
+    virtual bool      restoreRequest(const std::string&, const std::string&) { return true; }
+
+    void              open() { m_open = true; }
+
+private:
+    void waitOpen()
+    {
+        while (! m_open)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    std::atomic<bool>        m_open{false};
+    std::atomic<std::size_t> m_events{0};
+};
+
+// Pushes keys into a queue of the given capacity whose consumer is held back.
+// accepted: how many of them the queue took (push() true).
+void queue_overload(ThreadedMessageQueue& q, unsigned keys, unsigned& accepted)
+{
+    accepted = 0;
+    for (unsigned i = 0; i < keys; i++)
+        accepted += q.push(new Message(Message::Command::addKey, "overload key " + std::to_string(i % 10), "url", 0, 0, i));
+}
+
+void queue_overloadTest(TEST_REF)
+{
+    const unsigned capacity = 1000, keys = 5000, rate = 10;
+    unsigned accepted = 0;
+
+    // Drop newest: beyond capacity push() fails, memory stays bounded.
+    {
+        queue_GatedConsumer consumer;
+        ThreadedMessageQueue q(capacity, 64);
+        q.setOverloadPolicy(capacity, OverloadGuard::Policy::dropNewest);
+        q.setConsumer(&consumer);
+        q.start();
+        queue_overload(q, keys, accepted);
+        OverloadGuard::Stats full = q.getOverloadStats();
+        consumer.open();
+        while (! q.isEmpty())
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        q.stop();
+        OverloadGuard::Stats drained = q.getOverloadStats();
+
+        std::cout << "Drop newest: " << accepted << " of " << keys << " keys accepted, "
+                  << full.dropped << " dropped\n";
+        EXPECT_EQ(accepted, capacity);
+        EXPECT_EQ(full.size, uint64_t(capacity));
+        EXPECT_EQ(full.dropped, uint64_t(keys - capacity));
+        EXPECT_EQ(consumer.getTotalKeyNumber(), accepted);
+        EXPECT_EQ(drained.size, 0UL);
+    }
+
+    // Sample: from half the capacity on, 1 of every rate keys counting rate times.
+    {
+        queue_GatedConsumer consumer;
+        ThreadedMessageQueue q(capacity, 64);
+        q.setOverloadPolicy(capacity, OverloadGuard::Policy::sample, rate);
+        q.setConsumer(&consumer);
+        q.start();
+        queue_overload(q, keys, accepted);
+        OverloadGuard::Stats full = q.getOverloadStats();
+        consumer.open();
+        while (! q.isEmpty())
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        q.stop();
+
+        const unsigned sampled = (keys - capacity / 2 + rate - 1) / rate; // all of them fit
+        std::cout << "Sample: " << accepted << " of " << keys << " keys accepted, "
+                  << full.sampled << " of them sampled, " << consumer.getTotalKeyNumber() << " events applied\n";
+        EXPECT_EQ(full.sampled, uint64_t(sampled));
+        EXPECT_EQ(accepted, capacity / 2 + sampled);
+        EXPECT_LE(full.size, uint64_t(capacity));
+        EXPECT_EQ(full.dropped, uint64_t(keys - accepted));
+        EXPECT_EQ(consumer.getTotalKeyNumber(), capacity / 2 + sampled * rate);
+    }
+
+    // Block: the producer waits until the consumer makes room, nothing is lost.
+    {
+        queue_GatedConsumer consumer;
+        ThreadedMessageQueue q(capacity, 64);
+        q.setOverloadPolicy(capacity, OverloadGuard::Policy::block);
+        q.setConsumer(&consumer);
+        q.start();
+        std::atomic<bool> produced(false);
+        std::thread producer([&] { queue_overload(q, keys, accepted); produced = true; });
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        OverloadGuard::Stats full = q.getOverloadStats();
+        const bool waiting = ! produced;
+        consumer.open();
+        producer.join();
+        while (! q.isEmpty())
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        q.stop();
+        OverloadGuard::Stats drained = q.getOverloadStats();
+
+        std::cout << "Block: " << accepted << " of " << keys << " keys accepted, "
+                  << drained.blocked << " pushes waited for room\n";
+        EXPECT_TRUE(waiting);
+        EXPECT_EQ(full.size, uint64_t(capacity));
+        EXPECT_EQ(accepted, keys);
+        EXPECT_EQ(consumer.getTotalKeyNumber(), keys);
+        EXPECT_GT(drained.blocked, 0UL);
+        EXPECT_EQ(drained.dropped, 0UL);
+    }
+}
+
+void queue_keyRecordsTest(TEST_REF)
+{
+    const std::string body = "a,u1,80,3\r\nb\n\nc,u2,bad\n,u3,1\nd,u4,7,0\ne,,9";
+    std::vector<KeyEvent> events;
+    EXPECT_EQ(parseKeyRecords(body, events), 4UL);
+    EXPECT_EQ(events.size(), 4UL);
+    EXPECT_TRUE(events[0].key == "a" && events[0].url == "u1");
+    EXPECT_EQ(events[0].port, 80U);
+    EXPECT_EQ(events[0].count, 3U);
+    EXPECT_TRUE(events[1].key == "b" && events[1].url.empty());
+    EXPECT_EQ(events[1].count, 1U);
+    EXPECT_EQ(events[2].port, 0U); // bad port
+    EXPECT_TRUE(events[3].key == "e");
+    EXPECT_EQ(events[3].port, 9U);
+    EXPECT_TRUE(events[0].key.data() == body.data()); // views, not copies
+
+    events.clear();
+    EXPECT_EQ(parseKeyRecords(body, events, 2), 4UL); // a sampled bulk
+    EXPECT_EQ(events[0].count, 6U);
+    EXPECT_EQ(events[3].count, 2U);
+    EXPECT_EQ(parseKeyRecords("\n\r\n", events), 0UL);
+
+    // Counted without parsing: the record with a zero count too.
+    EXPECT_EQ(countKeyRecords(body), 5UL);
+    EXPECT_EQ(countKeyRecords("\n\r\n"), 0UL);
+    std::string_view lines = body;
+    EXPECT_TRUE(nextKeyRecord(lines) == "a,u1,80,3");
+    EXPECT_TRUE(nextKeyRecord(lines) == "b");
+}
+
+// keyInsertion() keys, records bodies of bulkSize records each.
+void queue_buildBulks(std::vector<std::string>& bodies, size_t keys, size_t bulkSize)
+{
+    bodies.clear();
+    for (size_t i = 0, j = 0; i < keys; i++)
+    {
+        if (i % bulkSize == 0)
+            bodies.emplace_back();
+
+        unsigned idx0 = genRandomNumbers[j++];
+        unsigned idx1 = genRandomNumbers[j++];
+        std::string& body = bodies.back();
+        body.append(firstHundred[idx0%100]).append(1, ' ').append(firstHundred[idx1%100]).append(1, ',');
+        body.append(urls[(idx0 % 100)/10]).append(1, ',').append(std::to_string(i + 1)).append(1, '\n');
+    }
+}
+
+// MKeys/sec from the first push until the consumer applied the last key. bulkSize 1: one addKey
+// message per key, otherwise one addKeys message per bulk.
+double queue_bulkThroughput(MapManager& m, size_t keys, size_t bulkSize)
+{
+    std::vector<std::string> bodies;
+    queue_buildBulks(bodies, keys, bulkSize);
+    std::vector<Message*> messages;
+    messages.reserve(bulkSize == 1 ? keys : bodies.size());
+    for (std::string& body : bodies)
+    {
+        if (bulkSize == 1)
+        {
+            std::vector<KeyEvent> events;
+            parseKeyRecords(body, events);
+            messages.push_back(new Message(Message::Command::addKey, std::string(events[0].key),
+                                           std::string(events[0].url), 0, 0, events[0].port));
+        }
+        else
+        {
+            const uint32_t records = uint32_t(std::count(body.begin(), body.end(), '\n'));
+            messages.push_back(new Message(Message::Command::addKeys, std::move(body), std::string(), 0, 0, records));
+        }
+    }
+
+    ThreadedMessageQueue q(1024);
+    q.setConsumer(&m);
+    q.start();
+    auto start = std::chrono::steady_clock::now();
+    for (Message* pm : messages)
+        q.push(pm);
+    while (! q.isEmpty())
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    q.stop(); // applies the last batch
+    auto finish = std::chrono::steady_clock::now();
+
+    return keys / std::chrono::duration<double, std::micro>(finish - start).count();
+}
+
+void queue_bulkTest(TEST_REF)
+{
+    // Same counts whatever the bulk size, every record applied.
+    const size_t keys = 1000000;
+    const size_t bulkSizes[] = {1, 10, 100, 1000};
+    MapManager single;
+    KeyFrequencyVector vSingle;
+    for (size_t bulkSize : bulkSizes)
+    {
+        MapManager m;
+        const double rate = queue_bulkThroughput(bulkSize == 1 ? single : m, keys, bulkSize);
+        std::cout << "  bulk of " << std::setw(4) << bulkSize << " keys : " << rate << " MKeys/sec\n";
+        if (bulkSize == 1)
+        {
+            single.getTopHotkeys(vSingle);
+            continue;
+        }
+
+        KeyFrequencyVector v;
+        m.getTopHotkeys(v);
+        EXPECT_EQ(m.getTotalKeyNumber(), single.getTotalKeyNumber());
+        EXPECT_EQ(v.size(), vSingle.size());
+        unsigned same = 0;
+        for (size_t i = 0; i < v.size() && i < vSingle.size(); i++)
+            same += (v[i].frequency == vSingle[i].frequency);
+        EXPECT_EQ(same, unsigned(vSingle.size()));
+    }
+
+    // A bounded queue admits or drops a bulk as a whole, counting its keys.
+    const unsigned capacity = 1000, bulks = 10, bulkSize = 300;
+    std::vector<std::string> bodies;
+    queue_buildBulks(bodies, bulks * bulkSize, bulkSize);
+    queue_GatedConsumer consumer;
+    ThreadedMessageQueue q(capacity, 64);
+    q.setOverloadPolicy(capacity, OverloadGuard::Policy::dropNewest);
+    q.setConsumer(&consumer);
+    q.start();
+    unsigned accepted = 0;
+    for (std::string& body : bodies)
+        accepted += q.push(new Message(Message::Command::addKeys, std::move(body), std::string(), 0, 0, bulkSize));
+    OverloadGuard::Stats full = q.getOverloadStats();
+    consumer.open();
+    while (! q.isEmpty())
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    q.stop();
+
+    EXPECT_EQ(accepted, capacity / bulkSize);
+    EXPECT_EQ(full.size, uint64_t(accepted * bulkSize));
+    EXPECT_EQ(full.dropped, uint64_t((bulks - accepted) * bulkSize));
+    EXPECT_EQ(consumer.getTotalKeyNumber(), accepted * bulkSize);
+    EXPECT_EQ(q.getOverloadStats().size, 0UL);
+}
+
+// CPU seconds used by the whole process so far.
+double queue_processCpuSeconds()
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+void queue_wakeupLatencyTest(TEST_REF)
+{
+    // Low load: one key every 2 mSec, so the consumer always finds the queue idle.
+    const unsigned keys = 500;
+    queue_ApplyClock consumer;
+    ThreadedMessageQueue q(1024);
+    q.setConsumer(&consumer);
+    q.start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+    std::vector<long long> samples;
+    samples.reserve(keys);
+    for (unsigned i = 0; i < keys; i++)
+    {
+        long long pushed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                               std::chrono::steady_clock::now().time_since_epoch()).count();
+        q.push(new Message(Message::Command::addKey, "wakeup key", "www.wakeup.com", 0, 0, i));
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        samples.push_back(consumer.lastApplied() - pushed);
+    }
+
+    // Idle: nothing is pushed, the consumer should not burn CPU.
+    const double idleSeconds = 0.5;
+    double cpuBefore = queue_processCpuSeconds();
+    std::this_thread::sleep_for(std::chrono::duration<double>(idleSeconds));
+    double idleCpu = queue_processCpuSeconds() - cpuBefore;
+    q.stop();
+
+    std::sort(samples.begin(), samples.end());
+    const std::streamsize precision = std::cout.precision();
+    std::cout << std::fixed << std::setprecision(1)
+              << "Enqueue to apply latency at low load (uSec): p50 " << samples[keys / 2] / 1000.0
+              << ", p99 " << samples[keys * 99 / 100] / 1000.0 << ", max " << samples.back() / 1000.0 << '\n'
+              << "Idle consumer CPU: " << 100.0 * idleCpu / idleSeconds << " %\n";
+    std::cout.unsetf(std::ios_base::floatfield);
+    std::cout.precision(precision);
+
+    EXPECT_EQ(consumer.getTotalKeyNumber(), keys);
+    EXPECT_GT(samples.front(), 0LL);
+
+    // The queue own histograms sampled the same keys.
+    QueueStats stats = q.getQueueStats();
+    std::cout << "Queue stats latency (nSec): p50 " << stats.latency.p50 << ", p99 " << stats.latency.p99
+              << ", p999 " << stats.latency.p999 << ", max " << stats.latency.max
+              << "; depth: p50 " << stats.depth.p50 << ", max " << stats.depth.max << '\n';
+    EXPECT_GE(stats.latency.count, uint64_t(keys / QUEUE_LATENCY_SAMPLE_RATE));
+    EXPECT_LE(stats.latency.count, uint64_t(keys / QUEUE_LATENCY_SAMPLE_RATE + 1));
+    EXPECT_GE(stats.depth.count, uint64_t(keys));
+    EXPECT_LE(stats.latency.p50, stats.latency.p99);
+    EXPECT_LE(stats.latency.p99, stats.latency.max);
+    EXPECT_LE(stats.latency.p50, uint64_t(samples[keys / 2]) * 2);
+    EXPECT_GE(stats.depth.p50, 1U);
+}
+
+// Consumer that applies a batch per mSec while slow: the queue backlog grows as fast as the producer pushes.
+class queue_SlowConsumer : public IMapManager
+{
+public:
+    virtual void      addOrUpdateKey(const std::string&, const std::string&, unsigned int) { pace(); ++m_events; }
+    virtual void      addOrUpdateKeys(const KeyEvent*, std::size_t n) { pace(); m_events += n; }
+    virtual void      setTopKeyReportBaseSize(unsigned short newBase) { m_base = newBase; }
+    virtual unsigned  getTopKeyReportBaseSize() { return m_base; }
+    virtual unsigned  getTopKeyReportActualSize() { return m_base; }
+    virtual unsigned  getTopKeyReportMaxSize() { return MAX_TOPKEY_REPORTSIZE; }
+    virtual unsigned  getTotalKeyNumber() { return unsigned(m_events.load()); }
+    virtual void      getTopHotkeys(KeyFrequencyVector&) {}
+    virtual bool      isHotKey(const std::string&) { return false; }
+    virtual bool      backupRequest(const std::string&, const std::string&) { return true; }
+    virtual bool      restoreRequest(const std::string&, const std::string&) { return true; }
+
+    void              setSlow(bool slow) { m_slow = slow; }
+
+private:
+    void pace()
+    {
+        if (m_slow)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    std::atomic<bool>        m_slow{true};
+    std::atomic<unsigned>    m_base{DEFAULT_TOPKEY_REPORTSIZE};
+    std::atomic<std::size_t> m_events{0};
+};
+
+void queue_controlLaneTest(TEST_REF)
+{
+    // A 5M messages backlog (the queue of a 10 MKeys burst of keyInsertion()) with short keys and
+    // url (no heap buffers), so it fits in the memory of the test hosts along with the other tests.
+    // setRankingLength commands sent behind it must be applied within a batch, long before the
+    // backlog drains.
+    const size_t messages = maxNumbers / 16;
+    const unsigned commands = 10;
+    queue_SlowConsumer consumer;
+    ThreadedMessageQueue q(messages);
+    q.setOverloadPolicy(maxNumbers, OverloadGuard::Policy::block); // never full: it counts the depth
+    q.setConsumer(&consumer);
+    q.start();
+
+    std::string sKey;
+    for (size_t i = 0; i < messages; i++)
+    {
+        sKey = 'k';
+        sKey += std::to_string(i % 10000);
+        q.push(new Message(Message::Command::addKey, sKey, "www.q.com", 0, 0, uint32_t(i)));
+    }
+
+    std::chrono::steady_clock::duration maxLatency(0);
+    const uint64_t depth = q.getOverloadStats().size;
+    unsigned applied = 0;
+    for (unsigned i = 0; i < commands; i++)
+    {
+        const unsigned short length = (i % 2 == 0 ? 11 : 12);
+        auto start = std::chrono::steady_clock::now();
+        q.push(new Message(Message::Command::setRankingLength, 0, length, 0));
+        while (consumer.getTopKeyReportBaseSize() != length)
+            std::this_thread::yield();
+
+        auto latency = std::chrono::steady_clock::now() - start;
+        if (latency > maxLatency) maxLatency = latency;
+        applied++;
+    }
+
+    const uint64_t depthAfter = q.getOverloadStats().size;
+    consumer.setSlow(false);
+    auto drainStart = std::chrono::steady_clock::now();
+    while (! q.isEmpty())
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    auto drain = std::chrono::steady_clock::now() - drainStart;
+    q.stop();
+
+    const long long latencyMicros = std::chrono::duration_cast<std::chrono::microseconds>(maxLatency).count();
+    const long long drainMicros = std::chrono::duration_cast<std::chrono::microseconds>(drain).count();
+    std::cout << commands << " control commands behind a backlog of " << depth << " keys: max latency "
+              << latencyMicros << " uSec; the backlog took " << drainMicros << " uSec to drain at full speed\n";
+
+    EXPECT_EQ(applied, commands);
+    EXPECT_GT(depth, uint64_t(messages * 3 / 4));
+    EXPECT_GT(depthAfter, uint64_t(messages / 2)); // the commands did not wait for the keys
+    EXPECT_LW(latencyMicros, 100000LL);
+    EXPECT_LW(latencyMicros * 10, drainMicros);
+    EXPECT_EQ(consumer.getTotalKeyNumber(), unsigned(messages));
+}
+
+// Resident set size of the process in bytes.
+size_t queue_residentBytes()
+{
+    size_t pages = 0, resident = 0;
+    std::ifstream statm("/proc/self/statm");
+    statm >> pages >> resident;
+    return resident * size_t(sysconf(_SC_PAGESIZE));
+}
+
+void queue_segmentedQueueTest(TEST_REF)
+{
+    // Several producers, one consumer: every value once and in the order of its producer.
+    const unsigned producers = 4;
+    const uint64_t values = 200000; // per producer, several segments in all
+    SegmentedQueue<uint64_t> sq;
+    std::vector<std::thread> threads;
+    for (unsigned p = 0; p < producers; p++)
+        threads.emplace_back([&sq, p, values]{ for (uint64_t i = 1; i <= values; i++) sq.push((uint64_t(p) << 32) | i); });
+
+    std::vector<uint64_t> last(producers, 0);
+    uint64_t popped = 0, unordered = 0;
+    while (popped < producers * values)
+    {
+        uint64_t v = 0;
+        if (! sq.pop(v))
+        {
+            std::this_thread::yield();
+            continue;
+        }
+
+        const unsigned p = unsigned(v >> 32);
+        unordered += (p >= producers || (v & 0xFFFFFFFFU) != last[p] + 1);
+        if (p < producers) last[p] = v & 0xFFFFFFFFU;
+        popped++;
+    }
+
+    for (std::thread& t : threads)
+        t.join();
+
+    uint64_t v = 0;
+    EXPECT_EQ(unordered, 0U);
+    EXPECT_FALSE(sq.pop(v));
+    EXPECT_TRUE(sq.empty());
+
+    // Drained segments are spares until released, all but the reserve one.
+    SegmentedQueue<uint64_t>::Stats stats = sq.getStats();
+    EXPECT_GE(stats.mapped, 1U); // drained segments are recycled: fewer than pushed
+    sq.releaseIdleSegments();
+    EXPECT_FALSE(sq.hasIdleSegments());
+    EXPECT_LE(sq.getStats().mapped, 2U); // the reserve and the current one
+    EXPECT_EQ(sq.getStats().released, stats.mapped - sq.getStats().mapped);
+}
+
+void queue_segmentedStorageTest(TEST_REF)
+{
+    // Startup: the 10M nodes the tracker used to preallocate vs. segments mapped on demand.
+    const size_t nodes = 10000000;
+    size_t rss = queue_residentBytes();
+    auto start = std::chrono::steady_clock::now();
+    BLFMessageQueue* pBoost = new BLFMessageQueue(nodes);
+    auto finish = std::chrono::steady_clock::now();
+    const size_t boostBytes = queue_residentBytes() - rss;
+    const long long boostMicros = std::chrono::duration_cast<std::chrono::microseconds>(finish - start).count();
+    delete pBoost;
+
+    rss = queue_residentBytes();
+    start = std::chrono::steady_clock::now();
+    ThreadedMessageQueue* pSegmented = new ThreadedMessageQueue(SegmentedMessageQueue::ms_SegmentSlots);
+    finish = std::chrono::steady_clock::now();
+    const size_t segmentedBytes = queue_residentBytes() - rss;
+    const long long segmentedMicros = std::chrono::duration_cast<std::chrono::microseconds>(finish - start).count();
+    delete pSegmented;
+
+    std::cout << "Queue construction: boost::lockfree::queue of " << nodes << " nodes " << boostMicros << " uSec, "
+              << boostBytes / 1024 << " KiB resident; segmented queue " << segmentedMicros << " uSec, "
+              << segmentedBytes / 1024 << " KiB resident\n";
+    EXPECT_LW(segmentedMicros, boostMicros);
+    EXPECT_LW(segmentedBytes, boostBytes);
+
+    // A burst maps segments, a quiet period gives them back.
+    queue_SlowConsumer consumer; // slow while the burst is pushed: it piles up
+    ThreadedMessageQueue q(0);
+    q.setIdleRelease(std::chrono::milliseconds(50));
+    q.setConsumer(&consumer);
+    q.start();
+    const size_t keys = 1000000;
+    for (size_t i = 0; i < keys; i++)
+        q.push(new Message(Message::Command::addKey, "k", "www.q.com", 0, 0, uint32_t(i)));
+    const SegmentedMessageQueue::Stats busy = q.getStorageStats();
+    consumer.setSlow(false);
+    while (! q.isEmpty())
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    const SegmentedMessageQueue::Stats idle = q.getStorageStats();
+    q.stop();
+
+    std::cout << "Burst of " << keys << " keys: " << busy.mapped << " segments mapped, "
+              << idle.mapped << " once idle (" << idle.released << " released)\n";
+    EXPECT_EQ(consumer.getTotalKeyNumber(), unsigned(keys));
+    EXPECT_GT(busy.mapped, 10U);
+    EXPECT_LE(idle.mapped, 2U);
+    EXPECT_GE(idle.released, busy.mapped - 2);
+}
+
+void queue_histogramTest(TEST_REF)
+{
+    // Buckets are contiguous: every value falls in the bucket whose bounds hold it.
+    unsigned contiguous = 0;
+    for (unsigned b = 0; b + 1 < LogLinearHistogram::ms_Buckets; b++)
+    {
+        const uint64_t bound = LogLinearHistogram::getBucketUpperBound(b);
+        contiguous += (LogLinearHistogram::getBucket(bound) == b && LogLinearHistogram::getBucket(bound + 1) == b + 1);
+    }
+    EXPECT_EQ(contiguous, LogLinearHistogram::ms_Buckets - 1);
+    EXPECT_EQ(LogLinearHistogram::getBucket(UINT64_MAX), LogLinearHistogram::ms_Buckets - 1);
+
+    LogLinearHistogram h;
+    const uint64_t values = 100000;
+    for (uint64_t v = 1; v <= values; v++)
+        h.record(v);
+
+    // Percentiles are bucket upper bounds: never below, at most 1/16 above.
+    LogLinearHistogram::Summary summary = h.getSummary();
+    EXPECT_EQ(summary.count, values);
+    EXPECT_EQ(summary.max, values);
+    EXPECT_GE(summary.p50, 50000U);
+    EXPECT_LE(summary.p50, 50000U + 50000U / 16);
+    EXPECT_GE(summary.p99, 99000U);
+    EXPECT_LE(summary.p99, values);
+    EXPECT_GE(summary.p999, 99900U);
+
+    LogLinearHistogram merged;
+    merged.add(h);
+    merged.add(h);
+    EXPECT_EQ(merged.getCount(), 2 * values);
+    EXPECT_EQ(merged.getPercentile(0.5), h.getPercentile(0.5));
+
+    // Per message overhead: a sampled clock read by the producer, one record by the consumer.
+    const unsigned calls = 10000000;
+    uint64_t sum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned i = 0; i < calls; i++)
+        sum += TickClock::now();
+    auto middle = std::chrono::steady_clock::now();
+    for (unsigned i = 0; i < calls; i++)
+        h.record(sum + i * 7919U);
+    auto finish = std::chrono::steady_clock::now();
+
+    const double clockNanos = std::chrono::duration<double, std::nano>(middle - start).count() / calls;
+    const double recordNanos = std::chrono::duration<double, std::nano>(finish - middle).count() / calls;
+    const std::streamsize precision = std::cout.precision();
+    const double messageNanos = (clockNanos + recordNanos) / QUEUE_LATENCY_SAMPLE_RATE;
+    std::cout << std::fixed << std::setprecision(1) << "TickClock::now() " << clockNanos
+              << " nSec, LogLinearHistogram::record() " << recordNanos << " nSec, "
+              << TickClock::nanosecondsPerTick() << " nSec per tick: " << messageNanos
+              << " nSec per message sampling 1 of " << QUEUE_LATENCY_SAMPLE_RATE << '\n';
+    std::cout.unsetf(std::ios_base::floatfield);
+    std::cout.precision(precision);
+
+    EXPECT_EQ(h.getCount(), values + calls);
+    EXPECT_LW(messageNanos, 10.0); // a few nSec, loose for loaded hosts
+}
+
+void ThreadedMessageQueueTests(TEST_REF)
+{
+    std::cout << "\nQueue wakeup latency test starting ...\n";
+    queue_wakeupLatencyTest(TEST);
+    std::cout << "Queue wakeup latency test finished.\n";
+
+    std::cout << "\nQueue control lane test starting ...\n";
+    queue_controlLaneTest(TEST);
+    std::cout << "Queue control lane test finished.\n";
+
+    std::cout << "\nSegmented queue storage test starting ...\n";
+    queue_segmentedQueueTest(TEST);
+    queue_segmentedStorageTest(TEST);
+    std::cout << "Segmented queue storage test finished.\n";
+
+    std::cout << "\nQueue latency histogram test starting ...\n";
+    queue_histogramTest(TEST);
+    std::cout << "Queue latency histogram test finished.\n";
+
+    std::cout << "\nQueue batch throughput test starting ...\n";
+    queue_batchThroughputTest(TEST);
+    std::cout << "Queue batch throughput test finished.\n";
+
+    std::cout << "\nQueue bulk of keys test starting ...\n";
+    queue_keyRecordsTest(TEST);
+    queue_bulkTest(TEST);
+    std::cout << "Queue bulk of keys test finished.\n";
+
+    std::cout << "\nQueue overload test starting ...\n";
+    queue_overloadTest(TEST);
+    std::cout << "Queue overload test finished.\n";
+
+    std::cout << "\nInline message queue test starting ...\n";
+    queue_inlineMessageTest(TEST);
+    queue_inlineQueueTest(TEST);
+    queue_inlineThroughputTest(TEST);
+    std::cout << "Inline message queue test finished.\n" << std::endl;
+}
+
 void MixManagerQueueTests(MapManager& m, ThreadedMessageQueue& q)
 {
     std::cout << "\nMessaging map manager through message queue. Test starting ...\n";
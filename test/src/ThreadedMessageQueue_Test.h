@@ -8,5 +8,6 @@
 #include "MapManager.h"
 #include "ThreadedMessageQueue.h"
 
+void ThreadedMessageQueueTests(TEST_REF);
 void MixManagerQueueTests(MapManager& m, ThreadedMessageQueue& q);
 
@@ -0,0 +1,161 @@
+/**
+ * @file ZeroAllocation_Test.cpp
+ * @brief Counts heap allocations of the ingest path for already known keys, and of the
+ *        top keys export.
+ *        This translation unit replaces the global operator new/delete of the test binary
+ *        with counting versions. The count is one relaxed atomic increment per allocation.
+ * @author Guillermo M. Paris
+ * @date 2026-10-18
+ */
+
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+#include "test-macros.h"
+#include "MapManager.h"
+#include "ShardedMapManager.h"
+#include "SpaceSavingManager.h"
+#include "ZeroAllocation_Test.h"
+
+static std::atomic<unsigned long> s_allocations(0);
+
+void* operator new(std::size_t size)
+{
+    s_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1))
+        return p;
+
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+/*****************************
+ *  Zero Allocation Tests    *
+*****************************/
+
+// Allocations done by rounds x keys updates of keys already known by mgr.
+unsigned long zeroalloc_repeatedUpdates(IMapManager& mgr, const std::vector<std::string>& keys, unsigned rounds)
+{
+    const std::string url("https://www.repeated-keys.com");
+
+    // Warm up: first sight of every key, and every published snapshot buffer sees them.
+    for (unsigned r = 0; r < 4; r++)
+        for (unsigned i = 0; i < keys.size(); i++)
+            mgr.addOrUpdateKey(keys[i], url, i);
+
+    unsigned long before = s_allocations.load();
+    for (unsigned r = 0; r < rounds; r++)
+        for (unsigned i = 0; i < keys.size(); i++)
+            mgr.addOrUpdateKey(keys[(i * 7 + r) % keys.size()], url, i); // ranking keeps changing
+
+    return s_allocations.load() - before;
+}
+
+// Same as above through addOrUpdateKeys(), in batches of 64 events with repeated keys.
+unsigned long zeroalloc_repeatedBatches(IMapManager& mgr, const std::vector<std::string>& keys, unsigned rounds)
+{
+    const std::string url("https://www.repeated-keys.com");
+    std::vector<KeyEvent> events(64);
+    auto sendBatches = [&](unsigned r) {
+        for (unsigned i = 0; i < keys.size(); i += unsigned(events.size()))
+        {
+            for (unsigned j = 0; j < events.size(); j++)
+                events[j] = {keys[(i + j / 2 * 7 + r) % keys.size()], url, i + j};
+            mgr.addOrUpdateKeys(events.data(), events.size());
+        }
+    };
+
+    for (unsigned r = 0; r < 4; r++)
+        sendBatches(r);
+
+    unsigned long before = s_allocations.load();
+    for (unsigned r = 0; r < rounds; r++)
+        sendBatches(r);
+
+    return s_allocations.load() - before;
+}
+
+void zeroalloc_steadyStateTest(TEST_REF)
+{
+    // Longer than the small string buffer, so any key copy would reach the heap.
+    std::vector<std::string> keys;
+    for (unsigned i = 0; i < 1000; i++)
+        keys.push_back("repeated key number " + std::to_string(10000 + i));
+
+    const unsigned rounds = 200;
+    MapManager single(10, 20);
+    unsigned long allocs = zeroalloc_repeatedUpdates(single, keys, rounds);
+    std::cout << "MapManager         : " << allocs << " allocations in " << rounds * keys.size() << " updates\n";
+    EXPECT_Z(allocs);
+
+    ShardedMapManager sharded(4, 10, 20);
+    allocs = zeroalloc_repeatedUpdates(sharded, keys, rounds);
+    std::cout << "ShardedMapManager  : " << allocs << " allocations in " << rounds * keys.size() << " updates\n";
+    EXPECT_Z(allocs);
+
+    // Fewer counters than keys: replacements recycle the index node and the key buffer.
+    SpaceSavingManager spaceSaving(500, 10, 20);
+    allocs = zeroalloc_repeatedUpdates(spaceSaving, keys, rounds);
+    std::cout << "SpaceSavingManager : " << allocs << " allocations in " << rounds * keys.size() << " updates\n";
+    EXPECT_Z(allocs);
+
+    // Batches: the aggregation buffers are reused once warmed up.
+    allocs = zeroalloc_repeatedBatches(single, keys, rounds);
+    std::cout << "MapManager batches         : " << allocs << " allocations\n";
+    EXPECT_Z(allocs);
+    allocs = zeroalloc_repeatedBatches(sharded, keys, rounds);
+    std::cout << "ShardedMapManager batches  : " << allocs << " allocations\n";
+    EXPECT_Z(allocs);
+    allocs = zeroalloc_repeatedBatches(spaceSaving, keys, rounds);
+    std::cout << "SpaceSavingManager batches : " << allocs << " allocations\n";
+    EXPECT_Z(allocs);
+}
+
+void zeroalloc_topKeysExportTest(TEST_REF)
+{
+    MapManager m(10, 20);
+    for (unsigned i = 0; i < 100000; i++)
+        m.addOrUpdateKey("exported key number " + std::to_string(i % 997 * (i % 5)), "export.com", i);
+
+    KeyFrequencyVector vRanking;
+    m.getRanking(vRanking, 20);
+
+    KeyCountVector out;
+    out.reserve(20);
+    unsigned int size = 0;
+    unsigned long allocs = 0;
+    {
+        MapManager::TopKeysGuard guard = m.pinTopKeys();
+        unsigned long before = s_allocations.load();
+        for (unsigned r = 0; r < 1000; r++)
+            size = m.getTopKeys(guard, out, 20);
+        allocs = s_allocations.load() - before;
+
+        // Same ranking than the copying interface, through the KeyFrequency conversion.
+        unsigned same = 0;
+        for (unsigned int i = 0; i < size && i < vRanking.size(); i++)
+            same += (KeyFrequency(out[i]).key == vRanking[i].key && KeyFrequency(out[i]).frequency == vRanking[i].frequency);
+        EXPECT_EQ(same, 20U);
+    }
+
+    std::cout << "MapManager top keys export: " << allocs << " allocations in 1000 exports\n";
+    EXPECT_EQ(size, 20U);
+    EXPECT_Z(allocs);
+
+    // The guard is gone: purge may release the old key arena.
+    m.purge(10);
+    EXPECT_EQ(m.getTotalKeyNumber(), 10U);
+}
+
+void ZeroAllocationTests(TEST_REF)
+{
+    std::cout << "\nZero allocation ingest test starting ...\n";
+    zeroalloc_steadyStateTest(TEST);
+    zeroalloc_topKeysExportTest(TEST);
+    std::cout << "Zero allocation ingest test finished.\n" << std::endl;
+}
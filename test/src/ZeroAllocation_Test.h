@@ -0,0 +1,8 @@
+/**
+ * @file ZeroAllocation_Test.h
+ * @brief Steady state ingest allocation test prototypes.
+ * @author Guillermo M. Paris
+ * @date 2026-10-18
+ */
+
+void ZeroAllocationTests(TEST_REF);
@@ -11,8 +11,17 @@
 #include <random>
 #include <thread>
 #include "test-macros.h"
+#include "FlatKeyIndex_Test.h"
+#include "KeyPreAggregator_Test.h"
 #include "MapManager_Test.h"
+#include "MessagePool_Test.h"
+#include "MessageServer_Test.h"
+#include "PartitionedMessageQueue_Test.h"
+#include "PerProducerMessageQueue_Test.h"
+#include "ShardedMapManager_Test.h"
+#include "SpaceSavingManager_Test.h"
 #include "ThreadedMessageQueue_Test.h"
+#include "ZeroAllocation_Test.h"
 #include "FirstHundredNumbersArray.h"
 
 extern const long CLOCKS_PER_MILLISEC = CLOCKS_PER_SEC / 1000;
@@ -94,7 +103,17 @@ int main()
     ThreadedMessageQueue q(initialQueueNodes);
 
     // test suites go here
+    FlatKeyIndexTests(TEST);
     MapManagerTests(TEST, m);
+    ShardedMapManagerTests(TEST);
+    SpaceSavingManagerTests(TEST);
+    ZeroAllocationTests(TEST);
+    MessagePoolTests(TEST);
+    ThreadedMessageQueueTests(TEST);
+    PartitionedMessageQueueTests(TEST);
+    PerProducerMessageQueueTests(TEST);
+    KeyPreAggregatorTests(TEST);
+    MessageServerTests(TEST);
     q.setConsumer(&m);
     q.start();
     MixManagerQueueTests(m, q);